@@ -5,8 +5,11 @@
 #include "afterhours/src/core/entity_helper.h"
 #include "afterhours/src/core/entity_query.h"
 #include "components.h"
+#include "engine/parallel.h"
 #include "engine/random_engine.h"
+#include "engine/spatial_hash.h"
 #include "systems.h"
+#include "telemetry.h"
 #include "update_helpers.h"
 
 // Greedy neighbor pathfinding with pheromone weighting.
@@ -14,14 +17,13 @@
 // When stuck behind an obstacle, takes a random lateral step to route around.
 static std::pair<int, int> pick_next_tile(
     int cur_x, int cur_z, int goal_x, int goal_z, const Grid& grid,
-    FacilityType want = FacilityType::Stage) {
+    RandomStream& rng, FacilityType want = FacilityType::Stage) {
     static constexpr int dx[] = {1, -1, 0, 0};
     static constexpr int dz[] = {0, 0, 1, -1};
 
     // Shuffle direction order to eliminate directional bias.
     // Without this, agents always prefer right > left > down > up when
     // scores are tied, causing them to cluster on one side of the stage.
-    auto& rng = RandomEngine::get();
     int order[4] = {0, 1, 2, 3};
     for (int k = 3; k > 0; k--) {
         int j = rng.get_int(0, k);
@@ -101,7 +103,8 @@ static float density_speed_modifier(float density_ratio) {
 }
 
 // When density is dangerous, randomly pick a less-crowded walkable neighbor.
-static std::pair<int, int> pick_flee_tile(int cx, int cz, const Grid& grid) {
+static std::pair<int, int> pick_flee_tile(int cx, int cz, const Grid& grid,
+                                          RandomStream& rng) {
     int cur_count = grid.at(cx, cz).agent_count;
 
     struct Candidate {
@@ -138,17 +141,15 @@ static std::pair<int, int> pick_flee_tile(int cx, int cz, const Grid& grid) {
                 for (int i = 1; i < n; i++) {
                     if (candidates[i].count < candidates[best].count) best = i;
                 }
-                static int desperate_count = 0;
-                if (++desperate_count <= 5) {
-                    log_warn(
-                        "DESPERATE FLEE ({},{}) count={} -> ({},{}) count={}",
-                        cx, cz, cur_count, candidates[best].x,
-                        candidates[best].z, candidates[best].count);
-                }
+                log_warn_limited(
+                    5, std::chrono::seconds(10),
+                    "DESPERATE FLEE ({},{}) count={} -> ({},{}) count={}", cx,
+                    cz, cur_count, candidates[best].x, candidates[best].z,
+                    candidates[best].count);
                 return {candidates[best].x, candidates[best].z};
             }
-            static int flee_trapped_count = 0;
-            if (++flee_trapped_count <= 5) {
+            if (LOG_SITE(LogLevel::LOG_WARN, 5, std::chrono::seconds(10))
+                    .allow()) {
                 log_warn("FLEE TRAPPED at ({},{}) count={} type={}:", cx, cz,
                          cur_count, static_cast<int>(grid.at(cx, cz).type));
                 for (auto [ddx, ddz] : dirs) {
@@ -176,7 +177,7 @@ static std::pair<int, int> pick_flee_tile(int cx, int cz, const Grid& grid) {
         total += weights[i];
     }
 
-    float roll = RandomEngine::get().get_float(0.f, total);
+    float roll = rng.get_float(0.f, total);
     float accum = 0.f;
     for (int i = 0; i < n; i++) {
         accum += weights[i];
@@ -199,9 +200,10 @@ static float dist_to_stage_edge(int x, int z) {
 }
 
 // Pick the best StageFloor tile scored by distance to stage edge + crowd.
-std::pair<int, int> best_stage_spot(int /*from_x*/, int /*from_z*/) {
+// Rng is RandomEngine for spawners or an agent's own RandomStream.
+template<typename Rng>
+static std::pair<int, int> pick_stage_spot(Rng& rng) {
     auto* grid = EntityHelper::get_singleton_cmp<Grid>();
-    auto& rng = RandomEngine::get();
     float scx = STAGE_X + STAGE_SIZE / 2.0f;
     float scz = STAGE_Z + STAGE_SIZE / 2.0f;
 
@@ -246,6 +248,25 @@ std::pair<int, int> best_stage_spot(int /*from_x*/, int /*from_z*/) {
     return {gx, gz};
 }
 
+std::pair<int, int> best_stage_spot(int /*from_x*/, int /*from_z*/) {
+    return pick_stage_spot(RandomEngine::get());
+}
+
+std::pair<int, int> best_stage_spot(int /*from_x*/, int /*from_z*/,
+                                    RandomStream& rng) {
+    return pick_stage_spot(rng);
+}
+
+// Feed a tile change into the crush forecast's inflow/outflow windows.
+static void report_transition(const Grid& grid, int from_x, int from_z,
+                              int to_x, int to_z) {
+    auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+    if (!cf) return;
+    int from = grid.in_bounds(from_x, from_z) ? grid.index(from_x, from_z) : -1;
+    int to = grid.in_bounds(to_x, to_z) ? grid.index(to_x, to_z) : -1;
+    cf->record_transition(from, to);
+}
+
 // Move agents toward their target using greedy pathfinding
 struct AgentMovementSystem : System<Agent, Transform> {
     void for_each_with(Entity& e, Agent& agent, Transform& tf,
@@ -262,6 +283,10 @@ struct AgentMovementSystem : System<Agent, Transform> {
 
         // Stuck detection
         if (cur_gx != agent.last_grid_x || cur_gz != agent.last_grid_z) {
+            if (agent.last_grid_x >= 0) {
+                report_transition(*grid, agent.last_grid_x, agent.last_grid_z,
+                                  cur_gx, cur_gz);
+            }
             agent.stuck_timer = 0.f;
             agent.last_grid_x = cur_gx;
             agent.last_grid_z = cur_gz;
@@ -304,8 +329,10 @@ struct AgentMovementSystem : System<Agent, Transform> {
                 }
 
                 if (need_new_target) {
-                    auto [fx, fz] = pick_flee_tile(cur_gx, cur_gz, *grid);
+                    auto [fx, fz] =
+                        pick_flee_tile(cur_gx, cur_gz, *grid, agent.rng);
                     if (fx != cur_gx || fz != cur_gz) {
+                        telemetry::bump(telemetry::FleeRetargets);
                         next_x = fx;
                         next_z = fz;
                         agent.flee_target_x = fx;
@@ -315,17 +342,17 @@ struct AgentMovementSystem : System<Agent, Transform> {
                         if (!e.is_missing<WatchingStage>()) {
                             e.removeComponent<WatchingStage>();
                         }
-                        auto [rsx, rsz] = best_stage_spot(cur_gx, cur_gz);
+                        auto [rsx, rsz] =
+                            best_stage_spot(cur_gx, cur_gz, agent.rng);
                         agent.set_target(rsx, rsz);
-                        static int lethal_count = 0;
-                        if (++lethal_count <= 5) {
-                            log_warn(
-                                "LETHAL NO FLEE at ({},{}) count={} "
-                                "forcing={} stuck={:.1f}s -> retarget ({},{})",
-                                cur_gx, cur_gz,
-                                grid->at(cur_gx, cur_gz).agent_count, forcing,
-                                agent.stuck_timer, rsx, rsz);
-                        }
+                        telemetry::bump(telemetry::LethalNoFlee);
+                        log_warn_limited(
+                            5, std::chrono::seconds(10),
+                            "LETHAL NO FLEE at ({},{}) count={} "
+                            "forcing={} stuck={:.1f}s -> retarget ({},{})",
+                            cur_gx, cur_gz,
+                            grid->at(cur_gx, cur_gz).agent_count, forcing,
+                            agent.stuck_timer, rsx, rsz);
                     }
                 }
                 if (fleeing) {
@@ -376,9 +403,11 @@ struct AgentMovementSystem : System<Agent, Transform> {
                 agent.move_target_x < 0 || (cur_gx == agent.move_target_x &&
                                             cur_gz == agent.move_target_z);
             if (need_pathfind) {
+                telemetry::bump(telemetry::Pathfinds);
                 auto [px, pz] =
                     pick_next_tile(cur_gx, cur_gz, agent.target_grid_x,
-                                   agent.target_grid_z, *grid, agent.want);
+                                   agent.target_grid_z, *grid, agent.rng,
+                                   agent.want);
                 agent.move_target_x = px;
                 agent.move_target_z = pz;
             }
@@ -404,6 +433,7 @@ struct AgentMovementSystem : System<Agent, Transform> {
         float dist = std::sqrt(dx * dx + dz * dz);
 
         if (dist > 0.01f) {
+            if (forcing) telemetry::bump(telemetry::ForcedMoves);
             float step = agent.speed * TILESIZE * dt;
             if (step > dist) step = dist;
             tf.position.x += (dx / dist) * step;
@@ -412,6 +442,82 @@ struct AgentMovementSystem : System<Agent, Transform> {
     }
 };
 
+// Boids-style separation so agents sharing a tile spread out instead of
+// stacking on its center. Positions are gathered into flat arrays, bucketed
+// with a counting-sort spatial hash, and pushed apart in a parallel pass.
+// Pushes never carry an agent out of its current tile, so tile density (and
+// everything built on it) is unaffected.
+struct AgentSeparationSystem : System<> {
+    SpatialHash hash;
+    std::vector<float> px, pz, out_dx, out_dz;
+    std::vector<uint32_t> seeds;
+    std::vector<Transform*> transforms;
+
+    AgentSeparationSystem() {
+        hash.init(-0.5f * TILESIZE, MAP_SIZE * TILESIZE, SEPARATION_RADIUS);
+    }
+
+    void once(float dt) override {
+        if (skip_game_logic()) return;
+        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        if (!grid) return;
+
+        px.clear();
+        pz.clear();
+        seeds.clear();
+        transforms.clear();
+        auto agents = EntityQuery()
+                          .whereHasComponent<Agent>()
+                          .whereHasComponent<Transform>()
+                          .gen();
+        for (Entity& e : agents) {
+            if (!e.is_missing<BeingServiced>()) continue;
+            auto& tf = e.get<Transform>();
+            px.push_back(tf.position.x);
+            pz.push_back(tf.position.y);
+            seeds.push_back(static_cast<uint32_t>(e.get<Agent>().rng_id));
+            transforms.push_back(&tf);
+        }
+
+        int n = static_cast<int>(px.size());
+        if (n < 2) return;
+        out_dx.resize(px.size());
+        out_dz.resize(px.size());
+
+        hash.build(px.data(), pz.data(), n);
+        parallel::for_range(n, SEPARATION_MIN_CHUNK, [&](int begin, int end) {
+            compute_separation(hash, px.data(), pz.data(), SEPARATION_RADIUS,
+                               seeds.data(), begin, end, out_dx.data(),
+                               out_dz.data());
+        });
+
+        float max_step = SEPARATION_STRENGTH * TILESIZE * dt;
+        for (int i = 0; i < n; i++) {
+            float mx = out_dx[i] * max_step;
+            float mz = out_dz[i] * max_step;
+            float len2 = mx * mx + mz * mz;
+            if (len2 <= 0.f) continue;
+            if (len2 > max_step * max_step) {
+                float s = max_step / std::sqrt(len2);
+                mx *= s;
+                mz *= s;
+            }
+
+            // Stay inside the current tile. Only limit the push itself: an
+            // agent already past the inset (crossing an edge) keeps moving.
+            auto [gx, gz] = grid->world_to_grid(px[i], pz[i]);
+            float cx = gx * TILESIZE, cz = gz * TILESIZE;
+            float lim = SEPARATION_TILE_INSET * TILESIZE;
+            float nx = std::clamp(px[i] + mx, std::min(px[i], cx - lim),
+                                  std::max(px[i], cx + lim));
+            float nz = std::clamp(pz[i] + mz, std::min(pz[i], cz - lim),
+                                  std::max(pz[i], cz + lim));
+            transforms[i]->position.x = nx;
+            transforms[i]->position.y = nz;
+        }
+    }
+};
+
 // Check if a facility tile is "full"
 static bool facility_is_full(int gx, int gz, const Grid& grid) {
     if (!grid.in_bounds(gx, gz)) return true;
@@ -507,7 +613,8 @@ struct UpdateAgentGoalSystem : System<Agent, AgentNeeds, Transform> {
                     grid->at(agent.target_grid_x, agent.target_grid_z)
                         .agent_count;
                 if (target_crowd >= RETARGET_THRESHOLD) {
-                    auto [rsx, rsz] = best_stage_spot(cur_gx, cur_gz);
+                    auto [rsx, rsz] =
+                        best_stage_spot(cur_gx, cur_gz, agent.rng);
                     agent.set_target(rsx, rsz);
                 }
             }
@@ -518,7 +625,8 @@ struct UpdateAgentGoalSystem : System<Agent, AgentNeeds, Transform> {
             if (agent.want != FacilityType::Stage &&
                 agent.want != FacilityType::MedTent) {
                 agent.want = FacilityType::Stage;
-                auto [rsx, rsz] = best_stage_spot(cur_gx, cur_gz);
+                auto [rsx, rsz] =
+                    best_stage_spot(cur_gx, cur_gz, agent.rng);
                 agent.set_target(rsx, rsz);
             }
         } else {
@@ -532,7 +640,8 @@ struct UpdateAgentGoalSystem : System<Agent, AgentNeeds, Transform> {
                 needs.needs_food = false;
                 needs.food_timer = 0.f;
                 agent.want = FacilityType::Stage;
-                auto [rsx, rsz] = best_stage_spot(cur_gx, cur_gz);
+                auto [rsx, rsz] =
+                    best_stage_spot(cur_gx, cur_gz, agent.rng);
                 agent.set_target(rsx, rsz);
             }
         }
@@ -566,9 +675,9 @@ struct StageWatchingSystem : System<Agent, Transform> {
 
         if (gx != agent.target_grid_x || gz != agent.target_grid_z) return;
 
-        auto& rng = RandomEngine::get();
         e.addComponent<WatchingStage>();
-        e.get<WatchingStage>().watch_duration = rng.get_float(30.f, 120.f);
+        e.get<WatchingStage>().watch_duration =
+            agent.rng.get_float(30.f, 120.f);
     }
 };
 
@@ -586,7 +695,7 @@ struct FacilityServiceSystem : System<Agent, AgentNeeds, Transform> {
             if (bs.time_remaining <= 0.f) {
                 auto* gs = EntityHelper::get_singleton_cmp<GameState>();
                 if (gs) gs->total_agents_served++;
-                auto& rng = RandomEngine::get();
+                auto& rng = agent.rng;
                 if (bs.facility_type == FacilityType::Bathroom) {
                     needs.needs_bathroom = false;
                     needs.bathroom_timer = 0.f;
@@ -617,7 +726,7 @@ struct FacilityServiceSystem : System<Agent, AgentNeeds, Transform> {
                 agent.want = FacilityType::Stage;
                 auto [fgx, fgz] =
                     grid->world_to_grid(tf.position.x, tf.position.y);
-                auto [rsx, rsz] = best_stage_spot(fgx, fgz);
+                auto [rsx, rsz] = best_stage_spot(fgx, fgz, agent.rng);
                 agent.set_target(rsx, rsz);
             }
             return;
@@ -636,6 +745,7 @@ struct FacilityServiceSystem : System<Agent, AgentNeeds, Transform> {
                 return;
             }
             e.addComponent<BeingServiced>();
+            telemetry::bump(telemetry::FacilityAdmissions);
             auto& bs = e.get<BeingServiced>();
             bs.facility_grid_x = gx;
             bs.facility_grid_z = gz;
@@ -645,13 +755,58 @@ struct FacilityServiceSystem : System<Agent, AgentNeeds, Transform> {
     }
 };
 
+// Buckets agents by tile into Grid::agent_index for the Close LOD
+// renderer, so a drawn frame costs what is on screen rather than the whole
+// population. Runs after every system that spawns, moves or removes agents
+// (e2e commands included), and while paused, so the index always matches
+// the frame that draws it.
+struct IndexAgentTilesSystem : System<> {
+    void once(float) override {
+        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        if (!grid) return;
+        auto& index = grid->agent_index;
+
+        index.px.clear();
+        index.pz.clear();
+        index.entries.clear();
+        auto agents = EntityQuery()
+                          .whereHasComponent<Agent>()
+                          .whereHasComponent<Transform>()
+                          .gen();
+        for (Entity& e : agents) {
+            if (e.cleanup || !e.is_missing<BeingServiced>()) continue;
+            const auto& tf = e.get<Transform>();
+            const auto& agent = e.get<Agent>();
+            AgentTileIndex::Entry entry;
+            entry.color_idx = agent.color_idx;
+            entry.want = static_cast<uint8_t>(agent.want);
+            if (!e.is_missing<WatchingStage>()) {
+                float timer = e.get<WatchingStage>().watch_timer;
+                entry.bob = std::sin(timer * 6.0f) * 0.03f;
+            }
+            if (!e.is_missing<AgentHealth>())
+                entry.hp = e.get<AgentHealth>().hp;
+            index.px.push_back(tf.position.x);
+            index.pz.push_back(tf.position.y);
+            index.entries.push_back(entry);
+        }
+        index.hash.build(index.px.data(), index.pz.data(),
+                         static_cast<int>(index.px.size()));
+    }
+};
+
 void register_agent_goal_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<NeedTickSystem>());
-    sm.register_update_system(std::make_unique<UpdateAgentGoalSystem>());
+    sm.register_update_system(timed<NeedTickSystem>());
+    sm.register_update_system(timed<UpdateAgentGoalSystem>());
 }
 
 void register_agent_movement_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<AgentMovementSystem>());
-    sm.register_update_system(std::make_unique<StageWatchingSystem>());
-    sm.register_update_system(std::make_unique<FacilityServiceSystem>());
+    sm.register_update_system(timed<AgentMovementSystem>());
+    sm.register_update_system(timed<AgentSeparationSystem>());
+    sm.register_update_system(timed<StageWatchingSystem>());
+    sm.register_update_system(timed<FacilityServiceSystem>());
+}
+
+void register_agent_index_systems(SystemManager& sm) {
+    sm.register_update_system(timed<IndexAgentTilesSystem>());
 }
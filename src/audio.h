@@ -4,10 +4,12 @@
 
 #include <afterhours/src/plugins/audio_helpers.h>
 
-#include <cmath>
-#include <cstdlib>
+#include <string>
 #include <vector>
 
+#include "audio_synth.h"
+#include "log.h"
+
 namespace ah = afterhours;
 
 struct AudioManager {
@@ -24,158 +26,60 @@ struct AudioManager {
     float music_volume = 0.3f;
     bool music_playing = false;
     bool initialized = false;
-
-    static ah::WaveType gen_tone(float freq, float duration, float volume,
-                                 int sample_rate = 44100) {
-        int count = static_cast<int>(sample_rate * duration);
-        auto* data = static_cast<float*>(std::malloc(count * sizeof(float)));
-        for (int i = 0; i < count; i++) {
-            float t = static_cast<float>(i) / sample_rate;
-            float env = 1.0f;
-            float fade_start = duration * 0.8f;
-            if (t > fade_start)
-                env = 1.0f - (t - fade_start) / (duration * 0.2f);
-            data[i] = std::sin(2.0f * 3.14159265f * freq * t) * volume * env;
-        }
-        ah::WaveType w = {0};
-        w.frameCount = static_cast<unsigned int>(count);
-        w.sampleRate = static_cast<unsigned int>(sample_rate);
-        w.sampleSize = 32;
-        w.channels = 1;
-        w.data = data;
-        return w;
+    bool music_loaded = false;
+
+    // One entry per sfx_* member, in declaration order
+    static std::vector<audio_synth::Recipe> sfx_recipes() {
+        using audio_synth::Recipe;
+        return {
+            Recipe::tone(800.0f, 0.04f, 0.3f),            // click
+            Recipe::tone(300.0f, 0.08f, 0.4f),            // place
+            Recipe::tone(500.0f, 0.12f, 0.3f),            // demolish
+            Recipe::chime(523.0f, 784.0f, 0.25f, 0.25f),  // toast
+            Recipe::noise(0.15f, 0.2f),                   // death
+            Recipe::tone(200.0f, 0.5f, 0.4f),             // gameover
+        };
     }
 
-    static ah::WaveType gen_chime(float freq1, float freq2, float duration,
-                                  float volume) {
-        int rate = 44100;
-        int count = static_cast<int>(rate * duration);
-        auto* data = static_cast<float*>(std::malloc(count * sizeof(float)));
-        int half = count / 2;
-        for (int i = 0; i < count; i++) {
-            float t = static_cast<float>(i) / rate;
-            float freq = (i < half) ? freq1 : freq2;
-            float env = 1.0f - static_cast<float>(i) / count;
-            data[i] = std::sin(2.0f * 3.14159265f * freq * t) * volume * env;
-        }
-        ah::WaveType w = {0};
-        w.frameCount = static_cast<unsigned int>(count);
-        w.sampleRate = static_cast<unsigned int>(rate);
-        w.sampleSize = 32;
-        w.channels = 1;
-        w.data = data;
-        return w;
-    }
-
-    static ah::WaveType gen_noise(float duration, float volume) {
-        int rate = 44100;
-        int count = static_cast<int>(rate * duration);
-        auto* data = static_cast<float*>(std::malloc(count * sizeof(float)));
-        for (int i = 0; i < count; i++) {
-            float env = 1.0f - static_cast<float>(i) / count;
-            float noise =
-                (static_cast<float>(std::rand()) / RAND_MAX) * 2.0f - 1.0f;
-            data[i] = noise * volume * env * env;
-        }
-        ah::WaveType w = {0};
-        w.frameCount = static_cast<unsigned int>(count);
-        w.sampleRate = static_cast<unsigned int>(rate);
-        w.sampleSize = 32;
-        w.channels = 1;
-        w.data = data;
-        return w;
+    static audio_synth::Recipe beat_recipe() {
+        return audio_synth::Recipe::beat_loop(128.0f, 4, 0.5f);
     }
 
-    static ah::WaveType gen_beat_loop(float bpm, int bars, float volume) {
-        int rate = 44100;
-        float beat_sec = 60.0f / bpm;
-        float bar_sec = beat_sec * 4.0f;
-        float total_sec = bar_sec * bars;
-        int count = static_cast<int>(rate * total_sec);
-        auto* data = static_cast<float*>(std::malloc(count * sizeof(float)));
-        std::memset(data, 0, count * sizeof(float));
-
-        for (int i = 0; i < count; i++) {
-            float t = static_cast<float>(i) / rate;
-            float beat_pos = std::fmod(t, beat_sec);
-
-            float bar_t = std::fmod(t, bar_sec);
-            bool is_kick =
-                (bar_t < beat_sec * 0.01f) ||
-                (bar_t >= beat_sec * 2.0f && bar_t < beat_sec * 2.01f);
-            if (beat_pos < 0.08f) {
-                float kick_env = 1.0f - beat_pos / 0.08f;
-                float kick_freq = 60.0f + 120.0f * kick_env;
-                float kick =
-                    std::sin(2.0f * 3.14159265f * kick_freq * beat_pos) *
-                    kick_env * kick_env;
-                if (is_kick || bar_t < 0.01f ||
-                    (bar_t >= beat_sec * 2.0f && bar_t < beat_sec * 2.01f)) {
-                    data[i] += kick * volume * 0.8f;
-                }
-            }
-
-            float eighth = beat_sec / 2.0f;
-            float eighth_pos = std::fmod(t, eighth);
-            if (eighth_pos < 0.02f) {
-                float hat_env = 1.0f - eighth_pos / 0.02f;
-                float hat_noise =
-                    (static_cast<float>(std::rand()) / RAND_MAX) * 2.0f - 1.0f;
-                data[i] += hat_noise * hat_env * volume * 0.15f;
-            }
-
-            if (bar_t < beat_sec) {
-                float sub_env = 1.0f - bar_t / beat_sec;
-                data[i] += std::sin(2.0f * 3.14159265f * 55.0f * t) * sub_env *
-                           volume * 0.4f;
-            }
-
-            data[i] = std::clamp(data[i], -1.0f, 1.0f);
-        }
-
+    // LoadSoundFromWave copies the samples, so the wave can point straight
+    // at the (possibly mapped) PCM and is never unloaded
+    static ah::SoundType load_sound(const audio_synth::Pcm& pcm) {
         ah::WaveType w = {0};
-        w.frameCount = static_cast<unsigned int>(count);
-        w.sampleRate = static_cast<unsigned int>(rate);
+        w.frameCount = static_cast<unsigned int>(pcm.size());
+        w.sampleRate = static_cast<unsigned int>(audio_synth::SAMPLE_RATE);
         w.sampleSize = 32;
         w.channels = 1;
-        w.data = data;
-        return w;
+        w.data = const_cast<float*>(pcm.data());
+        return ah::LoadSoundFromWave(w);
     }
 
+    // SFX come from the synth cache; the beat loop is loaded on first play
     void init() {
         if (initialized) return;
 
-        auto w_click = gen_tone(800.0f, 0.04f, 0.3f);
-        sfx_click = ah::LoadSoundFromWave(w_click);
-        ah::UnloadWave(w_click);
-
-        auto w_place = gen_tone(300.0f, 0.08f, 0.4f);
-        sfx_place = ah::LoadSoundFromWave(w_place);
-        ah::UnloadWave(w_place);
-
-        auto w_demo = gen_tone(500.0f, 0.12f, 0.3f);
-        sfx_demolish = ah::LoadSoundFromWave(w_demo);
-        ah::UnloadWave(w_demo);
+        auto pcm = audio_synth::prepare(sfx_recipes());
+        ah::SoundType* slots[] = {&sfx_click, &sfx_place, &sfx_demolish,
+                                  &sfx_toast, &sfx_death, &sfx_gameover};
+        for (size_t i = 0; i < pcm.size(); i++) *slots[i] = load_sound(pcm[i]);
+        auto stats = audio_synth::last_stats();
+        log_info("audio: {} sfx cached, {} synthesized in {:.1f} ms",
+                 stats.cached, stats.synthesized, stats.ms);
 
-        auto w_toast = gen_chime(523.0f, 784.0f, 0.25f, 0.25f);
-        sfx_toast = ah::LoadSoundFromWave(w_toast);
-        ah::UnloadWave(w_toast);
-
-        auto w_death = gen_noise(0.15f, 0.2f);
-        sfx_death = ah::LoadSoundFromWave(w_death);
-        ah::UnloadWave(w_death);
-
-        auto w_go = gen_tone(200.0f, 0.5f, 0.4f);
-        sfx_gameover = ah::LoadSoundFromWave(w_go);
-        ah::UnloadWave(w_go);
+        initialized = true;
+    }
 
-        auto w_beat = gen_beat_loop(128.0f, 4, 0.5f);
-        ah::ExportWave(w_beat, "/tmp/edc_beat.wav");
-        ah::UnloadWave(w_beat);
-        music_beat = ah::LoadMusicStream("/tmp/edc_beat.wav");
+    void load_music() {
+        std::string path = audio_synth::wav_file(beat_recipe());
+        music_beat = ah::LoadMusicStream(path.c_str());
         music_beat.looping = true;
-
-        initialized = true;
+        music_loaded = true;
+        auto stats = audio_synth::last_stats();
+        log_info("audio: beat loop {} in {:.1f} ms",
+                 stats.cached ? "cached" : "synthesized", stats.ms);
     }
 
     void shutdown() {
@@ -186,7 +90,8 @@ struct AudioManager {
         ah::UnloadSound(sfx_toast);
         ah::UnloadSound(sfx_death);
         ah::UnloadSound(sfx_gameover);
-        ah::UnloadMusicStream(music_beat);
+        if (music_loaded) ah::UnloadMusicStream(music_beat);
+        music_loaded = false;
         initialized = false;
     }
 
@@ -222,6 +127,7 @@ struct AudioManager {
 
     void start_music() {
         if (!music_playing) {
+            if (!music_loaded) load_music();
             ah::SetMusicVolume(music_beat, music_volume * master_volume);
             ah::PlayMusicStream(music_beat);
             music_playing = true;
@@ -0,0 +1,385 @@
+// Audio synthesis domain: pure per-sample waveform rendering, parallel
+// chunked synthesis and the on-disk PCM cache.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "audio_synth.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "engine/parallel.h"
+
+namespace audio_synth {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float TWO_PI = 2.0f * 3.14159265f;
+
+// Samples per parallel job; the short SFX are one job each
+constexpr size_t CHUNK = 8192;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t count;
+    uint64_t hash;
+};
+static_assert(sizeof(Header) == 24, "cache header layout");
+constexpr char MAGIC[4] = {'E', 'D', 'C', 'A'};
+
+constexpr size_t WAV_HEADER_SIZE = 44;
+
+struct State {
+    std::string cache_dir;
+    Stats stats;
+    bool warned = false;  // one write warning per run
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+// splitmix64 finalizer
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t f32_bits(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+// Uniform in [-1, 1), from the sample index alone
+float white_noise(uint32_t seed, size_t i) {
+    uint64_t h = mix64(((uint64_t) seed << 32) ^ (uint64_t) i);
+    return (float) (h >> 40) / (float) (1u << 23) - 1.0f;
+}
+
+float tone_sample(const Recipe& r, size_t i) {
+    float t = static_cast<float>(i) / SAMPLE_RATE;
+    float env = 1.0f;
+    float fade_start = r.duration * 0.8f;
+    if (t > fade_start) env = 1.0f - (t - fade_start) / (r.duration * 0.2f);
+    return std::sin(TWO_PI * r.freq1 * t) * r.volume * env;
+}
+
+float chime_sample(const Recipe& r, size_t i, size_t count) {
+    float t = static_cast<float>(i) / SAMPLE_RATE;
+    float freq = (i < count / 2) ? r.freq1 : r.freq2;
+    float env = 1.0f - static_cast<float>(i) / count;
+    return std::sin(TWO_PI * freq * t) * r.volume * env;
+}
+
+float noise_sample(const Recipe& r, size_t i, size_t count) {
+    float env = 1.0f - static_cast<float>(i) / count;
+    return white_noise(r.seed, i) * r.volume * env * env;
+}
+
+// Kick on beats 1 and 3, closed hat every eighth, sub swell each bar
+float beat_sample(const Recipe& r, size_t i) {
+    float beat_sec = 60.0f / r.freq1;
+    float bar_sec = beat_sec * 4.0f;
+    float t = static_cast<float>(i) / SAMPLE_RATE;
+    float beat_pos = std::fmod(t, beat_sec);
+    float bar_t = std::fmod(t, bar_sec);
+    float v = 0.f;
+
+    bool is_kick = (bar_t < beat_sec * 0.01f) ||
+                   (bar_t >= beat_sec * 2.0f && bar_t < beat_sec * 2.01f);
+    if (beat_pos < 0.08f) {
+        float kick_env = 1.0f - beat_pos / 0.08f;
+        float kick_freq = 60.0f + 120.0f * kick_env;
+        float kick =
+            std::sin(TWO_PI * kick_freq * beat_pos) * kick_env * kick_env;
+        if (is_kick || bar_t < 0.01f) v += kick * r.volume * 0.8f;
+    }
+
+    float eighth_pos = std::fmod(t, beat_sec / 2.0f);
+    if (eighth_pos < 0.02f) {
+        float hat_env = 1.0f - eighth_pos / 0.02f;
+        v += white_noise(r.seed, i) * hat_env * r.volume * 0.15f;
+    }
+
+    if (bar_t < beat_sec) {
+        float sub_env = 1.0f - bar_t / beat_sec;
+        v += std::sin(TWO_PI * 55.0f * t) * sub_env * r.volume * 0.4f;
+    }
+    return std::clamp(v, -1.0f, 1.0f);
+}
+
+std::string cache_path(const Recipe& r, const char* ext) {
+    return fmt::format("{}/{:016x}.{}", state().cache_dir, hash(r), ext);
+}
+
+// Render `count` samples into `out` in CHUNK-sized parallel jobs
+void render_parallel(const Recipe& r, float* out, size_t count) {
+    int jobs = (int) ((count + CHUNK - 1) / CHUNK);
+    parallel::for_range(jobs, 1, [&](int begin, int end) {
+        for (int j = begin; j < end; j++) {
+            size_t b = (size_t) j * CHUNK;
+            render(r, out + b, b, std::min(count, b + CHUNK));
+        }
+    });
+}
+
+// Write to PATH.tmp, then rename over PATH, so a concurrent launch (or a
+// crash mid-write) never maps a truncated file
+bool write_atomic(const std::string& path, const void* head, size_t head_size,
+                  const float* samples, size_t count) {
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), ec);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(static_cast<const char*>(head), (std::streamsize) head_size);
+        f.write(reinterpret_cast<const char*>(samples),
+                (std::streamsize) (count * sizeof(float)));
+        f.flush();
+        if (!f.good()) ec = std::make_error_code(std::errc::io_error);
+    }
+    if (!ec) std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        if (!state().warned)
+            log_warn("audio: cannot write {}: {}", path, ec.message());
+        state().warned = true;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool load_cached(const Recipe& r, size_t count, MappedFile& out) {
+    if (state().cache_dir.empty()) return false;
+    MappedFile f;
+    if (!f.open(cache_path(r, "pcm"))) return false;
+    if (f.size() != sizeof(Header) + count * sizeof(float)) return false;
+    Header h;
+    std::memcpy(&h, f.data(), sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        h.version != CACHE_VERSION || h.sample_rate != SAMPLE_RATE ||
+        h.count != count || h.hash != hash(r))
+        return false;
+    out = std::move(f);
+    return true;
+}
+
+void store(const Recipe& r, const std::vector<float>& samples) {
+    if (state().cache_dir.empty()) return;
+    Header h;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = CACHE_VERSION;
+    h.sample_rate = SAMPLE_RATE;
+    h.count = (uint32_t) samples.size();
+    h.hash = hash(r);
+    write_atomic(cache_path(r, "pcm"), &h, sizeof(h), samples.data(),
+                 samples.size());
+}
+
+// Canonical 44-byte header, mono IEEE float (format 3)
+std::array<uint8_t, WAV_HEADER_SIZE> wav_header(size_t count) {
+    std::array<uint8_t, WAV_HEADER_SIZE> out{};
+    size_t at = 0;
+    auto tag = [&](const char* s) {
+        std::memcpy(out.data() + at, s, 4);
+        at += 4;
+    };
+    auto u32 = [&](uint32_t v) {
+        for (int b = 0; b < 4; b++) out[at++] = (uint8_t) (v >> (8 * b));
+    };
+    auto u16 = [&](uint16_t v) {
+        out[at++] = (uint8_t) v;
+        out[at++] = (uint8_t) (v >> 8);
+    };
+    uint32_t data_bytes = (uint32_t) (count * sizeof(float));
+    tag("RIFF");
+    u32(36 + data_bytes);
+    tag("WAVE");
+    tag("fmt ");
+    u32(16);
+    u16(3);  // WAVE_FORMAT_IEEE_FLOAT
+    u16(1);  // channels
+    u32(SAMPLE_RATE);
+    u32(SAMPLE_RATE * sizeof(float));
+    u16(sizeof(float));
+    u16(32);
+    tag("data");
+    u32(data_bytes);
+    return out;
+}
+
+}  // namespace
+
+Recipe Recipe::tone(float freq, float duration, float volume) {
+    return {.kind = Kind::Tone,
+            .freq1 = freq,
+            .duration = duration,
+            .volume = volume};
+}
+
+Recipe Recipe::chime(float freq1, float freq2, float duration, float volume) {
+    return {.kind = Kind::Chime,
+            .freq1 = freq1,
+            .freq2 = freq2,
+            .duration = duration,
+            .volume = volume};
+}
+
+Recipe Recipe::noise(float duration, float volume, uint32_t seed) {
+    return {.kind = Kind::Noise,
+            .duration = duration,
+            .volume = volume,
+            .seed = seed};
+}
+
+Recipe Recipe::beat_loop(float bpm, int bars, float volume, uint32_t seed) {
+    float bar_sec = 60.0f / bpm * 4.0f;
+    return {.kind = Kind::BeatLoop,
+            .freq1 = bpm,
+            .duration = bar_sec * bars,
+            .volume = volume,
+            .bars = bars,
+            .seed = seed};
+}
+
+uint64_t hash(const Recipe& r) {
+    uint64_t h = mix64(CACHE_VERSION ^ ((uint64_t) SAMPLE_RATE << 32));
+    auto feed = [&](uint64_t v) { h = mix64(h ^ v) + 0x9e3779b97f4a7c15ull; };
+    feed((uint64_t) r.kind);
+    feed(f32_bits(r.freq1));
+    feed(f32_bits(r.freq2));
+    feed(f32_bits(r.duration));
+    feed(f32_bits(r.volume));
+    feed((uint64_t) (uint32_t) r.bars);
+    feed(r.seed);
+    return h;
+}
+
+size_t sample_count(const Recipe& r) {
+    return (size_t) std::max(0, static_cast<int>(SAMPLE_RATE * r.duration));
+}
+
+void render(const Recipe& r, float* out, size_t begin, size_t end) {
+    size_t count = sample_count(r);
+    for (size_t i = begin; i < end; i++) {
+        float v = 0.f;
+        switch (r.kind) {
+            case Kind::Tone:
+                v = tone_sample(r, i);
+                break;
+            case Kind::Chime:
+                v = chime_sample(r, i, count);
+                break;
+            case Kind::Noise:
+                v = noise_sample(r, i, count);
+                break;
+            case Kind::BeatLoop:
+                v = beat_sample(r, i);
+                break;
+        }
+        out[i - begin] = v;
+    }
+}
+
+const float* Pcm::data() const {
+    if (mapped_.is_open())
+        return reinterpret_cast<const float*>(mapped_.data() + sizeof(Header));
+    return owned_.data();
+}
+
+void set_cache_dir(const std::string& dir) { state().cache_dir = dir; }
+
+const std::string& cache_dir() { return state().cache_dir; }
+
+std::vector<Pcm> prepare(const std::vector<Recipe>& recipes) {
+    auto start = Clock::now();
+    Stats stats;
+    std::vector<Pcm> out(recipes.size());
+
+    // Misses are split into (recipe, sample range) jobs so short SFX and
+    // the long loop share the pool evenly
+    struct Job {
+        size_t recipe, begin, end;
+    };
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < recipes.size(); i++) {
+        Pcm& pcm = out[i];
+        pcm.count_ = sample_count(recipes[i]);
+        if (load_cached(recipes[i], pcm.count_, pcm.mapped_)) {
+            stats.cached++;
+            continue;
+        }
+        stats.synthesized++;
+        pcm.owned_.resize(pcm.count_);
+        for (size_t b = 0; b < pcm.count_; b += CHUNK)
+            jobs.push_back({i, b, std::min(pcm.count_, b + CHUNK)});
+    }
+
+    parallel::for_range((int) jobs.size(), 1, [&](int begin, int end) {
+        for (int j = begin; j < end; j++) {
+            const Job& job = jobs[j];
+            render(recipes[job.recipe],
+                   out[job.recipe].owned_.data() + job.begin, job.begin,
+                   job.end);
+        }
+    });
+
+    for (size_t i = 0; i < recipes.size(); i++) {
+        if (!out[i].from_cache()) store(recipes[i], out[i].owned_);
+    }
+
+    stats.ms = std::chrono::duration<float, std::milli>(Clock::now() - start)
+                   .count();
+    state().stats = stats;
+    return out;
+}
+
+std::string wav_file(const Recipe& r) {
+    auto start = Clock::now();
+    Stats stats;
+    size_t count = sample_count(r);
+    bool cached = !state().cache_dir.empty();
+    std::string path =
+        cached ? cache_path(r, "wav")
+               : (std::filesystem::temp_directory_path() /
+                  fmt::format("edc_{:016x}.wav", hash(r)))
+                     .string();
+
+    std::error_code ec;
+    if (cached && std::filesystem::file_size(path, ec) ==
+                      WAV_HEADER_SIZE + count * sizeof(float)) {
+        stats.cached++;
+    } else {
+        stats.synthesized++;
+        std::vector<float> samples(count);
+        render_parallel(r, samples.data(), count);
+        auto header = wav_header(count);
+        write_atomic(path, header.data(), header.size(), samples.data(),
+                     count);
+    }
+
+    stats.ms = std::chrono::duration<float, std::milli>(Clock::now() - start)
+                   .count();
+    state().stats = stats;
+    return path;
+}
+
+Stats last_stats() { return state().stats; }
+
+}  // namespace audio_synth
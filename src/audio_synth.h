@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine/mapped_file.h"
+
+// Procedural waveforms for the SFX and the music loop.
+//
+// A Recipe fully describes one waveform; every sample is a pure function
+// of the recipe and its index (noise comes from a counter-based hash, not
+// a global RNG), so a waveform can be rendered in independent chunks on
+// the parallel worker pool and gives the same samples on every run.
+//
+// Rendered waveforms are cached in cache_dir() as raw mono float32 PCM
+// named after hash(recipe); later launches map the file instead of
+// synthesizing. Bump CACHE_VERSION whenever render() output changes.
+namespace audio_synth {
+
+constexpr int SAMPLE_RATE = 44100;
+constexpr uint32_t CACHE_VERSION = 1;
+
+enum class Kind : uint8_t { Tone, Chime, Noise, BeatLoop };
+
+struct Recipe {
+    Kind kind = Kind::Tone;
+    float freq1 = 0.f;     // Hz; BeatLoop: bpm
+    float freq2 = 0.f;     // Hz, Chime second half
+    float duration = 0.f;  // seconds; BeatLoop: derived from bpm and bars
+    float volume = 0.f;
+    int bars = 0;       // BeatLoop
+    uint32_t seed = 0;  // Noise, BeatLoop hats
+
+    static Recipe tone(float freq, float duration, float volume);
+    static Recipe chime(float freq1, float freq2, float duration,
+                        float volume);
+    static Recipe noise(float duration, float volume, uint32_t seed = 1);
+    static Recipe beat_loop(float bpm, int bars, float volume,
+                            uint32_t seed = 1);
+};
+
+// Stable across runs and platforms; includes CACHE_VERSION
+[[nodiscard]] uint64_t hash(const Recipe& r);
+[[nodiscard]] size_t sample_count(const Recipe& r);
+
+// Samples [begin, end) of `r` into out[0, end - begin)
+void render(const Recipe& r, float* out, size_t begin, size_t end);
+
+// One waveform, either mapped from the cache or rendered in memory
+class Pcm {
+   public:
+    [[nodiscard]] const float* data() const;
+    [[nodiscard]] size_t size() const { return count_; }
+    [[nodiscard]] bool from_cache() const { return mapped_.is_open(); }
+
+   private:
+    friend std::vector<Pcm> prepare(const std::vector<Recipe>& recipes);
+    MappedFile mapped_;
+    std::vector<float> owned_;
+    size_t count_ = 0;
+};
+
+// "" disables the disk cache
+void set_cache_dir(const std::string& dir);
+[[nodiscard]] const std::string& cache_dir();
+
+// Waveforms for `recipes`, in order: cache hits are mapped, misses are
+// rendered in parallel and written back to the cache
+[[nodiscard]] std::vector<Pcm> prepare(const std::vector<Recipe>& recipes);
+
+// Path of `r` as a 32-bit float WAV file (for streamed music, which
+// needs a file), rendering and writing it first if it is not cached.
+// Uses a temporary file when the cache is disabled.
+[[nodiscard]] std::string wav_file(const Recipe& r);
+
+struct Stats {
+    int cached = 0;       // waveforms loaded from the cache
+    int synthesized = 0;  // waveforms rendered
+    float ms = 0.f;       // wall time of the last prepare / wav_file
+};
+[[nodiscard]] Stats last_stats();
+
+}  // namespace audio_synth
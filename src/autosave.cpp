@@ -0,0 +1,201 @@
+// Autosave domain: main-thread snapshot capture and the background
+// writer thread that encodes, rotates and atomically renames saves.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "autosave.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#include "save_system.h"
+
+namespace autosave {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+float ms_since(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start)
+        .count();
+}
+
+struct Writer {
+    float interval = DEFAULT_INTERVAL;
+    int keep = DEFAULT_KEEP;
+    float timer = 0.f;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thread;
+    bool stopping = false;
+    bool busy = false;  // a snapshot is pending or being written
+    save::Snapshot pending;
+    Stats stats;
+
+    void start() {
+        if (thread.joinable()) return;
+        stopping = false;
+        thread = std::thread([this] { run(); });
+    }
+
+    void run() {
+        std::unique_lock lock(mtx);
+        while (true) {
+            cv.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;  // stopping with nothing queued
+            save::Snapshot snap = std::move(pending);
+            pending = {};
+            int slots = keep;
+            lock.unlock();
+
+            auto start = Clock::now();
+            auto bytes = save::encode_snapshot(snap);
+            bool ok = rotate(slots) &&
+                      save::write_file_atomic(path_for(1), bytes);
+            float ms = ms_since(start);
+
+            lock.lock();
+            if (ok) {
+                stats.written++;
+            } else {
+                stats.failed++;
+            }
+            stats.last_bytes = bytes.size();
+            stats.last_write_ms = ms;
+            busy = false;
+            cv.notify_all();
+        }
+    }
+
+    // Shift autosave.N -> N+1, dropping the oldest, so slot 1 is free
+    static bool rotate(int slots) {
+        std::error_code ec;
+        std::filesystem::remove(path_for(slots), ec);
+        for (int i = slots - 1; i >= 1; i--) {
+            if (!std::filesystem::exists(path_for(i))) continue;
+            std::filesystem::rename(path_for(i), path_for(i + 1), ec);
+            if (ec) {
+                log_warn("autosave: rotate {} failed: {}", path_for(i),
+                         ec.message());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool submit() {
+        {
+            std::lock_guard lock(mtx);
+            if (busy) {
+                stats.skipped_busy++;
+                return false;
+            }
+        }
+        // Capture outside the lock: the writer never touches game state
+        auto start = Clock::now();
+        save::Snapshot snap = save::capture_snapshot();
+        float ms = ms_since(start);
+        if (snap.empty()) return false;
+
+        start_thread_once();
+        std::lock_guard lock(mtx);
+        pending = std::move(snap);
+        busy = true;
+        stats.captured++;
+        stats.last_capture_ms = ms;
+        cv.notify_all();
+        return true;
+    }
+
+    void start_thread_once() {
+        std::lock_guard lock(mtx);
+        start();
+    }
+
+    void wait_idle() {
+        std::unique_lock lock(mtx);
+        cv.wait(lock, [this] { return !busy; });
+    }
+
+    void stop() {
+        {
+            std::lock_guard lock(mtx);
+            stopping = true;
+            cv.notify_all();
+        }
+        if (thread.joinable()) thread.join();
+    }
+};
+
+Writer& writer() {
+    static Writer w;
+    return w;
+}
+
+}  // namespace
+
+void configure(float interval, int keep) {
+    auto& w = writer();
+    std::lock_guard lock(w.mtx);
+    w.interval = interval;
+    w.keep = std::clamp(keep, 1, MAX_KEEP);
+    w.timer = 0.f;
+}
+
+float interval() { return writer().interval; }
+int keep() { return writer().keep; }
+
+void tick(float dt) {
+    auto& w = writer();
+    if (w.interval <= 0.f) return;
+    w.timer += dt;
+    if (w.timer < w.interval) return;
+    w.timer = 0.f;
+    w.submit();
+}
+
+bool request_now() { return writer().submit(); }
+
+void reset_timer() { writer().timer = 0.f; }
+
+void flush() { writer().wait_idle(); }
+
+void shutdown() {
+    auto& w = writer();
+    w.wait_idle();
+    w.stop();
+}
+
+void discard() {
+    flush();
+    std::error_code ec;
+    for (int i = 1; i <= MAX_KEEP; i++) {
+        std::filesystem::remove(path_for(i), ec);
+    }
+}
+
+std::string path_for(int slot) {
+    return save::save_dir() + "/autosave." + std::to_string(slot) + ".sav";
+}
+
+int files_on_disk() {
+    int n = 0;
+    for (int i = 1; i <= MAX_KEEP; i++) {
+        if (std::filesystem::exists(path_for(i))) n++;
+    }
+    return n;
+}
+
+Stats stats() {
+    auto& w = writer();
+    std::lock_guard lock(w.mtx);
+    return w.stats;
+}
+
+}  // namespace autosave
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Periodic crash-safe autosave.
+//
+// Every `interval` seconds of simulation time the live state is captured
+// into a save::Snapshot on the main thread (column copies only) and handed
+// to a background writer, which compresses it, writes PATH.tmp and renames
+// it into place. Older autosaves rotate: autosave.1.sav is the newest,
+// autosave.K.sav the oldest kept. If the writer is still busy when the
+// next interval fires, that autosave is skipped rather than queued.
+namespace autosave {
+
+constexpr float DEFAULT_INTERVAL = 60.f;  // sim seconds
+constexpr int DEFAULT_KEEP = 3;
+constexpr int MAX_KEEP = 16;
+
+struct Stats {
+    uint64_t captured = 0;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    uint64_t skipped_busy = 0;
+    size_t last_bytes = 0;
+    float last_capture_ms = 0.f;  // main-thread cost
+    float last_write_ms = 0.f;    // background cost
+};
+
+// interval <= 0 disables autosaving; keep is clamped to [1, MAX_KEEP]
+void configure(float interval, int keep);
+[[nodiscard]] float interval();
+[[nodiscard]] int keep();
+
+// Advance the timer by one tick's sim time; captures when it elapses
+void tick(float dt);
+
+// Capture now, regardless of the timer. False if the writer was busy.
+bool request_now();
+
+// Restart the interval (new run)
+void reset_timer();
+
+// Block until the background writer is idle
+void flush();
+
+// Flush and join the writer (called from cleanup)
+void shutdown();
+
+// Remove every autosave file (run ended)
+void discard();
+
+// <save dir>/autosave.<slot>.sav, slot 1 = newest
+[[nodiscard]] std::string path_for(int slot);
+[[nodiscard]] int files_on_disk();
+[[nodiscard]] Stats stats();
+
+}  // namespace autosave
@@ -2,9 +2,13 @@
 #define AFTER_HOURS_REPLACE_LOGGING
 #include "log.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "afterhours/src/core/entity_helper.h"
 #include "audio.h"
 #include "components.h"
+#include "replay.h"
 #include "systems.h"
 #include "update_helpers.h"
 
@@ -50,6 +54,90 @@ static const PlacementMeta* get_placement_meta(BuildTool tool) {
     }
 }
 
+struct BuildAction {
+    BuildTool tool;
+    int x0, z0, x1, z1;
+};
+
+static std::vector<BuildAction>& build_queue() {
+    static std::vector<BuildAction> queue;
+    return queue;
+}
+
+void queue_build(BuildTool tool, int x0, int z0, int x1, int z1) {
+    build_queue().push_back({tool, x0, z0, x1, z1});
+}
+
+// Mutate the grid for one build. Returns false when nothing changed.
+static bool apply_build(Grid& grid, const BuildAction& act) {
+    switch (act.tool) {
+        case BuildTool::Path:
+        case BuildTool::Fence: {
+            TileType fill = (act.tool == BuildTool::Path) ? TileType::Path
+                                                          : TileType::Fence;
+            for (int z = std::min(act.z0, act.z1);
+                 z <= std::max(act.z0, act.z1); z++) {
+                for (int x = std::min(act.x0, act.x1);
+                     x <= std::max(act.x0, act.x1); x++) {
+                    if (!grid.in_bounds(x, z)) continue;
+                    if (grid.at(x, z).type != TileType::Grass) continue;
+                    grid.at(x, z).type = fill;
+                }
+            }
+            grid.mark_tiles_dirty();
+            return true;
+        }
+        case BuildTool::Gate:
+        case BuildTool::Stage:
+        case BuildTool::Bathroom:
+        case BuildTool::Food:
+        case BuildTool::MedTent: {
+            auto* meta = get_placement_meta(act.tool);
+            if (!meta || !can_place_at(grid, act.x0, act.z0, meta->width,
+                                       meta->height))
+                return false;
+            grid.place_footprint(act.x0, act.z0, meta->width, meta->height,
+                                 meta->tile_type);
+            if (meta->tile_type == TileType::Gate) grid.rebuild_gate_cache();
+            return true;
+        }
+        case BuildTool::Demolish: {
+            if (!grid.in_bounds(act.x0, act.z0)) return false;
+            Tile& tile = grid.at(act.x0, act.z0);
+            if (tile.type == TileType::Path || tile.type == TileType::Fence ||
+                tile.type == TileType::Bathroom ||
+                tile.type == TileType::Food ||
+                tile.type == TileType::MedTent ||
+                tile.type == TileType::Stage) {
+                bool is_gate = (tile.type == TileType::Gate);
+                if (is_gate && grid.gate_count() <= 1) return false;
+                tile.type = TileType::Grass;
+                grid.mark_tiles_dirty();
+                return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+// Apply, play feedback and log the build for replays
+static void commit_build(Grid& grid, const BuildAction& act) {
+    if (!apply_build(grid, act)) return;
+    replay::record({.kind = replay::ActionKind::Build,
+                    .value = (uint8_t) act.tool,
+                    .x0 = (int16_t) act.x0,
+                    .z0 = (int16_t) act.z0,
+                    .x1 = (int16_t) act.x1,
+                    .z1 = (int16_t) act.z1});
+    if (replay::is_seeking()) return;
+    if (act.tool == BuildTool::Demolish) {
+        get_audio().play_demolish();
+    } else {
+        get_audio().play_place();
+    }
+}
+
 // Handle all build tools: rect drag for path/fence, point for facilities
 struct PathBuildSystem : System<> {
     void once(float) override {
@@ -59,6 +147,20 @@ struct PathBuildSystem : System<> {
         auto* bs = EntityHelper::get_singleton_cmp<BuilderState>();
         if (!pds || !grid || !bs) return;
 
+        // Replays apply the recorded builds and ignore the player
+        if (replay::is_playing()) {
+            build_queue().clear();
+            replay::for_each_due(
+                replay::ActionKind::Build, [&](const replay::Action& a) {
+                    commit_build(*grid, {static_cast<BuildTool>(a.value),
+                                         a.x0, a.z0, a.x1, a.z1});
+                });
+            return;
+        }
+
+        for (const BuildAction& act : build_queue()) commit_build(*grid, act);
+        build_queue().clear();
+
         // Tool cycling with [ ]
         if (action_pressed(InputAction::PrevTool)) {
             int t = static_cast<int>(bs->tool);
@@ -94,71 +196,25 @@ struct PathBuildSystem : System<> {
 
         if (input::is_mouse_button_pressed(MOUSE_BUTTON_LEFT)) {
             int hx = pds->hover_x, hz = pds->hover_z;
+            bool is_rect =
+                bs->tool == BuildTool::Path || bs->tool == BuildTool::Fence;
 
-            switch (bs->tool) {
-                case BuildTool::Path:
-                case BuildTool::Fence: {
-                    if (!pds->is_drawing) {
-                        pds->start_x = hx;
-                        pds->start_z = hz;
-                        pds->is_drawing = true;
-                    } else {
-                        int min_x, min_z, max_x, max_z;
-                        pds->get_rect(min_x, min_z, max_x, max_z);
-                        TileType fill = (bs->tool == BuildTool::Path)
-                                            ? TileType::Path
-                                            : TileType::Fence;
-                        for (int z = min_z; z <= max_z; z++) {
-                            for (int x = min_x; x <= max_x; x++) {
-                                if (!grid->in_bounds(x, z)) continue;
-                                if (grid->at(x, z).type != TileType::Grass)
-                                    continue;
-                                grid->at(x, z).type = fill;
-                            }
-                        }
-                        pds->is_drawing = false;
-                        grid->mark_tiles_dirty();
-                        get_audio().play_place();
-                    }
-                    break;
-                }
-                case BuildTool::Gate:
-                case BuildTool::Stage:
-                case BuildTool::Bathroom:
-                case BuildTool::Food:
-                case BuildTool::MedTent: {
-                    auto* meta = get_placement_meta(bs->tool);
-                    if (meta && can_place_at(*grid, hx, hz, meta->width,
-                                             meta->height)) {
-                        grid->place_footprint(hx, hz, meta->width, meta->height,
-                                              meta->tile_type);
-                        if (meta->tile_type == TileType::Gate)
-                            grid->rebuild_gate_cache();
-                        get_audio().play_place();
-                    }
-                    break;
-                }
-                case BuildTool::Demolish: {
-                    Tile& tile = grid->at(hx, hz);
-                    if (tile.type == TileType::Path ||
-                        tile.type == TileType::Fence ||
-                        tile.type == TileType::Bathroom ||
-                        tile.type == TileType::Food ||
-                        tile.type == TileType::MedTent ||
-                        tile.type == TileType::Stage) {
-                        bool is_gate = (tile.type == TileType::Gate);
-                        if (is_gate && grid->gate_count() <= 1) break;
-                        tile.type = TileType::Grass;
-                        grid->mark_tiles_dirty();
-                        get_audio().play_demolish();
-                    }
-                    break;
-                }
+            if (is_rect && !pds->is_drawing) {
+                pds->start_x = hx;
+                pds->start_z = hz;
+                pds->is_drawing = true;
+            } else if (is_rect) {
+                int min_x, min_z, max_x, max_z;
+                pds->get_rect(min_x, min_z, max_x, max_z);
+                pds->is_drawing = false;
+                commit_build(*grid, {bs->tool, min_x, min_z, max_x, max_z});
+            } else {
+                commit_build(*grid, {bs->tool, hx, hz, hx, hz});
             }
         }
     }
 };
 
 void register_building_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<PathBuildSystem>());
+    sm.register_update_system(timed<PathBuildSystem>());
 }
@@ -6,8 +6,11 @@
 
 #include "afterhours/src/core/base_component.h"
 #include "camera.h"
+#include "engine/random_engine.h"
+#include "engine/spatial_hash.h"
 #include "game.h"
 #include "rl.h"
+#include "telemetry.h"
 
 struct ProvidesCamera : afterhours::BaseComponent {
     IsometricCamera cam;
@@ -61,6 +64,36 @@ struct Tile {
     }
 };
 
+// Agents bucketed by tile, rebuilt once per tick by IndexAgentTilesSystem.
+// A row of tiles is one contiguous run of the hash, so the Close LOD
+// renderer visits only the tiles on screen.
+struct AgentTileIndex {
+    // What the renderer needs of one agent besides its position
+    struct Entry {
+        float bob = 0.f;  // stage-watching bob height
+        float hp = 1.f;   // 1 without AgentHealth
+        uint8_t color_idx = 0;
+        uint8_t want = 0;  // FacilityType
+    };
+
+    // One cell per tile; agents off the map land in the edge tiles
+    SpatialHash hash;
+    std::vector<Entry> entries;  // in input order, looked up by hash.ids
+    std::vector<float> px, pz;   // build scratch
+
+    AgentTileIndex() {
+        hash.init(-0.5f * TILESIZE, MAP_SIZE * TILESIZE, TILESIZE);
+    }
+
+    // Hash slots [first, second) of the agents on tiles min_x..max_x of
+    // row z (all in bounds)
+    [[nodiscard]] std::pair<int, int> row(int z, int min_x,
+                                          int max_x) const {
+        return {hash.cell_start[z * hash.cols + min_x],
+                hash.cell_start[z * hash.cols + max_x + 1]};
+    }
+};
+
 // Grid singleton - holds the MAP_SIZE x MAP_SIZE tile map
 struct Grid : afterhours::BaseComponent {
     std::array<Tile, MAP_SIZE * MAP_SIZE> tiles{};
@@ -93,6 +126,23 @@ struct Grid : afterhours::BaseComponent {
     // Dirty flags for lazy cache rebuilds
     bool caches_dirty = true;
     bool minimap_dirty = true;
+    // Changes each time the per-tile densities are recounted; render-side
+    // layers rebuild when the version they were built from is stale
+    uint64_t density_version = 0;
+
+    // Versions come from one counter shared by every Grid, so the fresh
+    // grid after reset_game never reuses a version a layer already built
+    void bump_density_version() {
+        static uint64_t last = 0;
+        density_version = ++last;
+    }
+
+    // Agents by tile as of the end of the last tick (Close LOD rendering)
+    AgentTileIndex agent_index;
+
+    // Time since the last pheromone decay step (DecayPheromonesSystem).
+    // Lives here so reset_game restarts the decay cadence with the grid.
+    float pheromone_decay_timer = 0.f;
 
     int index(int x, int z) const { return z * MAP_SIZE + x; }
 
@@ -138,6 +188,7 @@ struct Grid : afterhours::BaseComponent {
     void ensure_caches() {
         if (!caches_dirty) return;
         caches_dirty = false;
+        telemetry::bump(telemetry::CacheRebuilds);
 
         // Gate positions
         gate_positions.clear();
@@ -340,6 +391,11 @@ struct Agent : afterhours::BaseComponent {
     // Visual variety: color palette index (0-7)
     uint8_t color_idx = 0;
 
+    // Private RNG stream (see RandomStream). rng_id is also the agent's
+    // stable identity for state hashing, independent of entity ids.
+    uint64_t rng_id = 0;
+    RandomStream rng;
+
     // Cached pathfinding result: the next tile the agent is walking toward.
     // Only recomputed on tile transitions or goal changes.
     int move_target_x = -1;
@@ -658,6 +714,138 @@ struct VisibleRegion : afterhours::BaseComponent {
     float fovy = 5.0f;
 };
 
+// Hybrid simulation: tile-level continuum crowd for off-screen regions.
+// When enabled, dense tiles the camera can't resolve (off-screen, or the
+// whole map at Far LOD) hold their agents as fractional per-desire
+// populations instead of entities. MacroCrowdSystem moves them down
+// per-desire goal distance fields and re-materializes agents when a tile
+// comes back into view or thins out.
+struct MacroCrowd : afterhours::BaseComponent {
+    static constexpr int NUM_TILES = MAP_SIZE * MAP_SIZE;
+    static constexpr uint16_t UNREACHABLE = 0xFFFF;
+
+    bool enabled = false;
+
+    // Per-tile, per-desire population (indexed by FacilityType)
+    std::array<std::array<float, Tile::NUM_DESIRES>, NUM_TILES> pop{};
+
+    // Tiles currently held in aggregate form
+    std::array<bool, NUM_TILES> active{};
+
+    // BFS distance in tiles to the nearest goal tile for each desire
+    std::array<std::array<uint16_t, NUM_TILES>, Tile::NUM_DESIRES> goal_dist{};
+
+    // Fractional bookkeeping carried between steps
+    float served_carry = 0.f;
+    float step_timer = 0.f;
+
+    float tile_total(int idx) const {
+        float sum = 0.f;
+        for (float p : pop[idx]) sum += p;
+        return sum;
+    }
+
+    int total_agents() const {
+        float sum = 0.f;
+        for (int i = 0; i < NUM_TILES; i++) sum += tile_total(i);
+        return static_cast<int>(std::lround(sum));
+    }
+
+    void clear() {
+        for (auto& p : pop) p.fill(0.f);
+        active.fill(false);
+        served_carry = 0.f;
+        step_timer = 0.f;
+    }
+};
+
+// Crush forecast singleton - per-tile time until DENSITY_CRITICAL.
+//
+// AgentMovementSystem reports tile transitions; each lands in the current
+// bucket of a rolling window and bumps that tile's inflow/outflow sums.
+// When a bucket expires its events are subtracted again. Only tiles touched
+// by a new or expiring event are re-forecast, and the result is stored as
+// an absolute sim time so untouched tiles count down for free.
+struct CrushForecast : afterhours::BaseComponent {
+    static constexpr int NUM_TILES = MAP_SIZE * MAP_SIZE;
+    static constexpr float NONE = -1.f;
+
+    struct Event {
+        int tile;
+        int8_t dir;  // +1 inflow, -1 outflow
+    };
+
+    // Agents entering / leaving each tile over the window
+    std::array<int16_t, NUM_TILES> inflow{};
+    std::array<int16_t, NUM_TILES> outflow{};
+
+    // Sim time the tile is expected to reach critical density (NONE = not
+    // trending there). critical_at <= now means already critical.
+    std::array<float, NUM_TILES> critical_at{};
+
+    std::array<std::vector<Event>, FORECAST_BUCKETS> buckets;
+    int head = 0;
+    float bucket_timer = 0.f;
+    float now = 0.f;
+
+    // Tiles needing a re-forecast this tick
+    std::vector<int> dirty;
+    std::array<bool, NUM_TILES> is_dirty{};
+
+    // Tiles holding a forecast; re-checked every bucket so a stale ETA
+    // (crowd drained by deaths or service, not by walking) gets dropped
+    std::vector<int> tracked;
+    std::array<bool, NUM_TILES> is_tracked{};
+
+    CrushForecast() { critical_at.fill(NONE); }
+
+    void mark(int idx) {
+        if (is_dirty[idx]) return;
+        is_dirty[idx] = true;
+        dirty.push_back(idx);
+    }
+
+    void track(int idx) {
+        if (is_tracked[idx]) return;
+        is_tracked[idx] = true;
+        tracked.push_back(idx);
+    }
+
+    void record_transition(int from_idx, int to_idx) {
+        auto& bucket = buckets[head];
+        if (from_idx >= 0 && from_idx < NUM_TILES) {
+            outflow[from_idx]++;
+            bucket.push_back({from_idx, -1});
+            mark(from_idx);
+        }
+        if (to_idx >= 0 && to_idx < NUM_TILES) {
+            inflow[to_idx]++;
+            bucket.push_back({to_idx, 1});
+            mark(to_idx);
+        }
+    }
+
+    // Seconds until critical; 0 if already there, NONE if not trending
+    float time_to_critical(int idx) const {
+        if (critical_at[idx] < 0.f) return NONE;
+        return std::max(0.f, critical_at[idx] - now);
+    }
+
+    void clear() {
+        inflow.fill(0);
+        outflow.fill(0);
+        critical_at.fill(NONE);
+        for (auto& b : buckets) b.clear();
+        head = 0;
+        bucket_timer = 0.f;
+        now = 0.f;
+        dirty.clear();
+        is_dirty.fill(false);
+        tracked.clear();
+        is_tracked.fill(false);
+    }
+};
+
 // Path drawing state - rectangle drag on grid
 struct PathDrawState : afterhours::BaseComponent {
     // Current hover position (updated every frame)
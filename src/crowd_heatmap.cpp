@@ -0,0 +1,127 @@
+// Crowd heatmap domain: per-tile desire color and density field for the
+// Far LOD view, blurred once per rebuild.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "crowd_heatmap.h"
+
+#include <algorithm>
+
+#include "render_helpers.h"
+
+namespace crowd_heatmap {
+
+namespace {
+
+constexpr int NUM_TEXELS = SIZE * SIZE;
+constexpr Color EMPTY = {180, 180, 180, 0};
+
+// Desire-weighted color sum, agent weight and occupancy of one tile
+struct Accum {
+    float r = 0.f, g = 0.f, b = 0.f;
+    float w = 0.f;
+    float occupied = 0.f;
+
+    void add(const Accum& o, float k) {
+        r += o.r * k;
+        g += o.g * k;
+        b += o.b * k;
+        w += o.w * k;
+        occupied += o.occupied * k;
+    }
+};
+
+struct Field {
+    std::vector<Accum> a = std::vector<Accum>(NUM_TEXELS);
+    std::vector<Accum> b = std::vector<Accum>(NUM_TEXELS);
+    std::vector<Color> texels = std::vector<Color>(NUM_TEXELS, EMPTY);
+    uint64_t version = 0;
+    uint64_t density_version = ~0ull;  // Grid densities built from
+};
+
+Field& field() {
+    static Field f;
+    return f;
+}
+
+unsigned char to_byte(float v) {
+    return static_cast<unsigned char>(std::clamp(v, 0.f, 255.f));
+}
+
+// [0.5, 1, 0.5] along x (dx = 1) or z (dx = SIZE)
+void blur_1d(const std::vector<Accum>& in, std::vector<Accum>& out,
+             bool along_x) {
+    for (int z = 0; z < SIZE; z++) {
+        for (int x = 0; x < SIZE; x++) {
+            int i = z * SIZE + x;
+            Accum acc = in[i];
+            int pos = along_x ? x : z;
+            int step = along_x ? 1 : SIZE;
+            if (pos > 0) acc.add(in[i - step], 0.5f);
+            if (pos < SIZE - 1) acc.add(in[i + step], 0.5f);
+            out[i] = acc;
+        }
+    }
+}
+
+}  // namespace
+
+void build(const Grid& grid) {
+    auto& f = field();
+    for (int i = 0; i < NUM_TEXELS; i++) {
+        const Tile& tile = grid.tiles[i];
+        Accum& acc = f.a[i];
+        acc = Accum{};
+        if (tile.agent_count <= 0) continue;
+        for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+            float n = static_cast<float>(tile.desire_counts[d]);
+            acc.r += DESIRE_COLORS[d].r * n;
+            acc.g += DESIRE_COLORS[d].g * n;
+            acc.b += DESIRE_COLORS[d].b * n;
+        }
+        acc.w = static_cast<float>(tile.agent_count);
+        acc.occupied = 1.f;
+    }
+
+    blur_1d(f.a, f.b, true);
+    blur_1d(f.b, f.a, false);
+
+    for (int i = 0; i < NUM_TEXELS; i++) {
+        const Accum& acc = f.a[i];
+        if (acc.w <= 0.f) {
+            f.texels[i] = EMPTY;
+            continue;
+        }
+        float inv = 1.f / acc.w;
+        // Agents per occupied tile around here, and how much of the
+        // neighborhood is occupied (1 on and inside the blob, fading out
+        // over the tile beyond its edge)
+        float density = std::min(
+            acc.w / (acc.occupied * static_cast<float>(MAX_AGENTS_PER_TILE)),
+            1.f);
+        float coverage = std::min(acc.occupied, 1.f);
+        // Dense cores glow brighter (the old highlight disks)
+        float boost = 40.f * std::min(density / 0.5f, 1.f);
+        f.texels[i] = {to_byte(acc.r * inv + boost),
+                       to_byte(acc.g * inv + boost),
+                       to_byte(acc.b * inv + boost),
+                       to_byte(coverage * (180.f + density * 75.f))};
+    }
+    f.density_version = grid.density_version;
+    f.version++;
+}
+
+void refresh(const Grid& grid) {
+    if (field().density_version != grid.density_version) build(grid);
+}
+
+const std::vector<Color>& texels() { return field().texels; }
+
+Color texel(int x, int z) {
+    if (x < 0 || x >= SIZE || z < 0 || z >= SIZE) return EMPTY;
+    return field().texels[z * SIZE + x];
+}
+
+uint64_t version() { return field().version; }
+
+}  // namespace crowd_heatmap
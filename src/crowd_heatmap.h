@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "components.h"
+#include "game.h"
+
+// Far LOD crowd field: one RGBA texel per tile, drawn as a single
+// bilinear-filtered quad over the map.
+//
+// Rebuilt only when the tile densities were recounted (Grid::density_version).
+// Color is the agent-weighted mix of desire colors, brightened where the
+// crowd is dense; alpha rises with density. Both go through one 3x3 blur
+// (weights 1 / 0.5 / 0.25, run as two separable passes) so blobs of
+// adjacent tiles merge and their edges fade out over a tile.
+namespace crowd_heatmap {
+
+constexpr int SIZE = MAP_SIZE;
+
+// Recompute every texel from the grid's current counts
+void build(const Grid& grid);
+
+// build() unless the field already reflects the grid's densities
+void refresh(const Grid& grid);
+
+// SIZE * SIZE texels, row-major by z (row 0 is z = 0)
+[[nodiscard]] const std::vector<Color>& texels();
+[[nodiscard]] Color texel(int x, int z);
+
+// Bumps on every build (texture upload key)
+[[nodiscard]] uint64_t version();
+
+}  // namespace crowd_heatmap
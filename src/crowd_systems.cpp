@@ -7,6 +7,7 @@
 #include "afterhours/src/core/entity_query.h"
 #include "audio.h"
 #include "components.h"
+#include "density_history.h"
 #include "engine/random_engine.h"
 #include "systems.h"
 #include "update_helpers.h"
@@ -151,17 +152,16 @@ struct PheromoneDepositSystem : System<Agent, Transform, PheromoneDepositor> {
 
 // Decay all pheromones periodically
 struct DecayPheromonesSystem : System<> {
-    float accumulator = 0.f;
     static constexpr float DECAY_INTERVAL = 1.5f;
 
     void once(float dt) override {
         if (skip_game_logic()) return;
-        accumulator += dt;
-        if (accumulator < DECAY_INTERVAL) return;
-        accumulator -= DECAY_INTERVAL;
-
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
         if (!grid) return;
+
+        grid->pheromone_decay_timer += dt;
+        if (grid->pheromone_decay_timer < DECAY_INTERVAL) return;
+        grid->pheromone_decay_timer -= DECAY_INTERVAL;
         for (auto& tile : grid->tiles) {
             for (auto& p : tile.pheromone) {
                 if (p > 0) p--;
@@ -173,13 +173,22 @@ struct DecayPheromonesSystem : System<> {
 // Update per-tile agent density each frame
 struct UpdateTileDensitySystem : System<> {
     float stage_log_timer = 0.f;
+    // Counts before the recount, to detect whether any tile changed
+    std::vector<int> prev_agents;
+    std::vector<std::array<int, Tile::NUM_DESIRES>> prev_desires;
 
     void once(float dt) override {
         if (skip_game_logic()) return;
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
         if (!grid) return;
 
-        for (auto& tile : grid->tiles) {
+        const size_t num_tiles = grid->tiles.size();
+        prev_agents.resize(num_tiles);
+        prev_desires.resize(num_tiles);
+        for (size_t i = 0; i < num_tiles; i++) {
+            auto& tile = grid->tiles[i];
+            prev_agents[i] = tile.agent_count;
+            prev_desires[i] = tile.desire_counts;
             tile.agent_count = 0;
             tile.desire_counts.fill(0);
         }
@@ -200,6 +209,29 @@ struct UpdateTileDensitySystem : System<> {
             }
         }
 
+        // Aggregated (hybrid sim) populations count like agents
+        auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+        if (mc) {
+            for (int i = 0; i < MacroCrowd::NUM_TILES; i++) {
+                auto& tile = grid->tiles[i];
+                for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+                    int n = static_cast<int>(std::lround(mc->pop[i][d]));
+                    tile.desire_counts[d] += n;
+                    tile.agent_count += n;
+                }
+            }
+        }
+
+        // Layers built from the densities rebuild only when a tile changed
+        for (size_t i = 0; i < num_tiles; i++) {
+            const auto& tile = grid->tiles[i];
+            if (tile.agent_count != prev_agents[i] ||
+                tile.desire_counts != prev_desires[i]) {
+                grid->bump_density_version();
+                break;
+            }
+        }
+
         stage_log_timer -= dt;
         if (stage_log_timer <= 0.f) {
             stage_log_timer = 5.0f;
@@ -227,10 +259,68 @@ struct UpdateTileDensitySystem : System<> {
     }
 };
 
+// Extrapolate per-tile time-to-critical from rolling inflow/outflow.
+// Only tiles touched by a transition (or an expiring one) are recomputed.
+struct CrushForecastSystem : System<> {
+    static constexpr float WINDOW = FORECAST_BUCKETS * FORECAST_BUCKET_SECONDS;
+
+    void once(float dt) override {
+        if (skip_game_logic()) return;
+        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+        if (!grid || !cf) return;
+
+        cf->now += dt;
+        cf->bucket_timer += dt;
+        bool rollover = false;
+        while (cf->bucket_timer >= FORECAST_BUCKET_SECONDS) {
+            cf->bucket_timer -= FORECAST_BUCKET_SECONDS;
+            cf->head = (cf->head + 1) % FORECAST_BUCKETS;
+            auto& expired = cf->buckets[cf->head];
+            for (const auto& ev : expired) {
+                if (ev.dir > 0)
+                    cf->inflow[ev.tile]--;
+                else
+                    cf->outflow[ev.tile]--;
+                cf->mark(ev.tile);
+            }
+            expired.clear();
+            rollover = true;
+        }
+        if (rollover) {
+            for (int idx : cf->tracked) cf->mark(idx);
+        }
+
+        const float critical = DENSITY_CRITICAL * MAX_AGENTS_PER_TILE;
+        for (int idx : cf->dirty) {
+            cf->is_dirty[idx] = false;
+            float count = static_cast<float>(grid->tiles[idx].agent_count);
+            float net = (cf->inflow[idx] - cf->outflow[idx]) / WINDOW;
+            if (count >= critical) {
+                cf->critical_at[idx] = cf->now;
+            } else if (net > 0.f) {
+                cf->critical_at[idx] = cf->now + (critical - count) / net;
+            } else {
+                cf->critical_at[idx] = CrushForecast::NONE;
+            }
+            if (cf->critical_at[idx] >= 0.f) cf->track(idx);
+        }
+
+        // Every tracked tile was just re-forecast: keep the ones still
+        // holding a forecast
+        if (rollover) {
+            std::erase_if(cf->tracked, [&](int idx) {
+                bool keep = cf->critical_at[idx] >= 0.f;
+                cf->is_tracked[idx] = keep;
+                return !keep;
+            });
+        }
+        cf->dirty.clear();
+    }
+};
+
 // Apply crush damage to agents on critically dense tiles.
 struct CrushDamageSystem : System<Agent, Transform, AgentHealth> {
-    float log_cooldown = 0.f;
-
     void for_each_with(Entity& e, Agent& agent, Transform& tf,
                        AgentHealth& health, float dt) override {
         if (skip_game_logic()) return;
@@ -249,9 +339,8 @@ struct CrushDamageSystem : System<Agent, Transform, AgentHealth> {
         if (density >= DENSITY_CRITICAL) {
             health.hp -= CRUSH_DAMAGE_RATE * dt;
 
-            log_cooldown -= dt;
-            if (log_cooldown <= 0.f) {
-                log_cooldown = 2.0f;
+            if (LOG_SITE(LogLevel::LOG_WARN, 1, std::chrono::seconds(2))
+                    .allow()) {
                 bool watching = !e.is_missing<WatchingStage>();
                 bool forcing_flag = agent.is_forcing();
                 int min_neighbor = MAX_AGENTS_PER_TILE;
@@ -284,6 +373,7 @@ static void spawn_death_particles(float wx, float wz, int count, float radius) {
     auto& rng = RandomEngine::get();
     for (int i = 0; i < count; i++) {
         Entity& pe = EntityHelper::createEntity();
+        telemetry::bump(telemetry::EntitiesCreated);
         pe.addComponent<Transform>(::vec2{wx, wz});
         pe.addComponent<Particle>();
         auto& p = pe.get<Particle>();
@@ -379,6 +469,7 @@ struct AgentDeathSystem : System<> {
             }
 
             Entity& dme = EntityHelper::createEntity();
+            telemetry::bump(telemetry::EntitiesCreated);
             dme.addComponent<DeathMarker>();
             auto& dm = dme.get<DeathMarker>();
             dm.position = {info.wx, info.wz};
@@ -428,6 +519,8 @@ struct TrackStatsSystem : System<> {
 
         int count = static_cast<int>(
             EntityQuery().whereHasComponent<Agent>().gen_count());
+        auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+        if (mc) count += mc->total_agents();
 
         int old_max = gs->max_attendees;
         if (count > gs->max_attendees) {
@@ -447,20 +540,30 @@ struct TrackStatsSystem : System<> {
     }
 };
 
+// Record the freshly counted density planes for post-game heatmaps
+struct DensityHistorySystem : System<> {
+    void once(float dt) override {
+        if (skip_game_logic()) return;
+        density_history::tick(dt);
+    }
+};
+
 void register_crowd_flow_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<ExodusSystem>());
-    sm.register_update_system(std::make_unique<GateExitSystem>());
-    sm.register_update_system(std::make_unique<PheromoneDepositSystem>());
-    sm.register_update_system(std::make_unique<DecayPheromonesSystem>());
-    sm.register_update_system(std::make_unique<UpdateTileDensitySystem>());
+    sm.register_update_system(timed<ExodusSystem>());
+    sm.register_update_system(timed<GateExitSystem>());
+    sm.register_update_system(timed<PheromoneDepositSystem>());
+    sm.register_update_system(timed<DecayPheromonesSystem>());
+    sm.register_update_system(timed<UpdateTileDensitySystem>());
+    sm.register_update_system(timed<DensityHistorySystem>());
 }
 
 void register_crowd_damage_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<CrushDamageSystem>());
-    sm.register_update_system(std::make_unique<AgentDeathSystem>());
-    sm.register_update_system(std::make_unique<TrackStatsSystem>());
+    sm.register_update_system(timed<CrushForecastSystem>());
+    sm.register_update_system(timed<CrushDamageSystem>());
+    sm.register_update_system(timed<AgentDeathSystem>());
+    sm.register_update_system(timed<TrackStatsSystem>());
 }
 
 void register_crowd_particle_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<UpdateParticlesSystem>());
+    sm.register_update_system(timed<UpdateParticlesSystem>());
 }
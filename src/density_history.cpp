@@ -0,0 +1,310 @@
+// Density history domain: sampling, delta/LZ block encoding, budgeted
+// downsampling and window queries (see density_history.h).
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "density_history.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+#include "afterhours/src/core/entity_helper.h"
+#include "engine/compress.h"
+
+namespace density_history {
+
+namespace {
+
+constexpr int PLANES = 2 + Tile::NUM_DESIRES;  // max, mean, desire means
+constexpr size_t PLANE_BYTES = (size_t) PLANES * NUM_TILES;
+
+struct Frame {
+    float t0 = 0.f, t1 = 0.f;
+    uint32_t samples = 1;
+    std::vector<uint8_t> planes;  // PLANES x NUM_TILES
+
+    uint8_t* plane(int p) { return planes.data() + (size_t) p * NUM_TILES; }
+    const uint8_t* plane(int p) const {
+        return planes.data() + (size_t) p * NUM_TILES;
+    }
+};
+
+struct Block {
+    float t0 = 0.f, t1 = 0.f;
+    uint32_t span = 1;  // samples per frame (of the first frame)
+    int frames = 0;
+    size_t raw_size = 0;
+    std::vector<uint8_t> packed;
+};
+
+constexpr size_t FRAME_HEADER = 2 * sizeof(float) + sizeof(uint32_t);
+
+// Frame headers, then each frame's planes minus the previous frame's
+void encode(const std::vector<Frame>& frames, Block& out) {
+    std::vector<uint8_t> raw(frames.size() * (FRAME_HEADER + PLANE_BYTES));
+    uint8_t* p = raw.data();
+    const uint8_t* prev = nullptr;
+    for (const Frame& f : frames) {
+        std::memcpy(p, &f.t0, sizeof(float));
+        std::memcpy(p + 4, &f.t1, sizeof(float));
+        std::memcpy(p + 8, &f.samples, sizeof(uint32_t));
+        p += FRAME_HEADER;
+        for (size_t i = 0; i < PLANE_BYTES; i++) {
+            p[i] = (uint8_t) (f.planes[i] - (prev ? prev[i] : 0));
+        }
+        prev = f.planes.data();
+        p += PLANE_BYTES;
+    }
+    out.t0 = frames.front().t0;
+    out.t1 = frames.back().t1;
+    out.span = frames.front().samples;
+    out.frames = (int) frames.size();
+    out.raw_size = raw.size();
+    out.packed.clear();
+    compress::lz_compress(raw.data(), raw.size(), out.packed);
+    out.packed.shrink_to_fit();
+}
+
+bool decode(const Block& b, std::vector<Frame>& frames) {
+    std::vector<uint8_t> raw;
+    if (!compress::lz_decompress(b.packed.data(), b.packed.size(),
+                                 b.raw_size, raw))
+        return false;
+    frames.assign(b.frames, Frame{});
+    const uint8_t* p = raw.data();
+    const uint8_t* prev = nullptr;
+    for (Frame& f : frames) {
+        std::memcpy(&f.t0, p, sizeof(float));
+        std::memcpy(&f.t1, p + 4, sizeof(float));
+        std::memcpy(&f.samples, p + 8, sizeof(uint32_t));
+        p += FRAME_HEADER;
+        f.planes.resize(PLANE_BYTES);
+        for (size_t i = 0; i < PLANE_BYTES; i++) {
+            f.planes[i] = (uint8_t) (p[i] + (prev ? prev[i] : 0));
+        }
+        prev = f.planes.data();
+        p += PLANE_BYTES;
+    }
+    return true;
+}
+
+// b follows a in time: max of maxes, sample-weighted means
+Frame combine(const Frame& a, const Frame& b) {
+    Frame out;
+    out.t0 = a.t0;
+    out.t1 = b.t1;
+    out.samples = a.samples + b.samples;
+    out.planes.resize(PLANE_BYTES);
+    float wa = (float) a.samples / out.samples;
+    float wb = (float) b.samples / out.samples;
+    for (int p = 0; p < PLANES; p++) {
+        const uint8_t* pa = a.plane(p);
+        const uint8_t* pb = b.plane(p);
+        uint8_t* po = out.plane(p);
+        for (int i = 0; i < NUM_TILES; i++) {
+            po[i] = p == 0 ? std::max(pa[i], pb[i])
+                           : (uint8_t) std::lround(pa[i] * wa + pb[i] * wb);
+        }
+    }
+    return out;
+}
+
+struct History {
+    float interval = DEFAULT_INTERVAL;
+    size_t budget = DEFAULT_BUDGET;
+    float clock = 0.f;
+    float timer = 0.f;
+
+    std::deque<Block> blocks;
+    std::vector<Frame> open;  // newest frames, not yet a block
+    Stats stats;
+
+    size_t block_bytes() const {
+        size_t n = 0;
+        for (const Block& b : blocks) n += b.packed.size();
+        return n;
+    }
+
+    void refresh_stats() {
+        stats.blocks = (int) blocks.size();
+        stats.frames = (int) open.size();
+        for (const Block& b : blocks) stats.frames += b.frames;
+        stats.bytes = block_bytes() + open.size() * PLANE_BYTES;
+        stats.coarsest_span = blocks.empty()
+                                  ? (open.empty() ? 0 : 1)
+                                  : (int) blocks.front().span;
+        stats.oldest = !blocks.empty() ? blocks.front().t0
+                       : !open.empty() ? open.front().t0
+                                       : 0.f;
+        stats.newest = !open.empty()     ? open.back().t1
+                       : !blocks.empty() ? blocks.back().t1
+                                         : 0.f;
+        stats.version++;
+    }
+
+    // Merge two adjacent blocks into one at half the time resolution
+    bool merge(size_t i) {
+        std::vector<Frame> a, b;
+        if (!decode(blocks[i], a) || !decode(blocks[i + 1], b)) return false;
+        a.insert(a.end(), std::make_move_iterator(b.begin()),
+                 std::make_move_iterator(b.end()));
+        std::vector<Frame> halved;
+        for (size_t k = 0; k < a.size(); k += 2) {
+            halved.push_back(k + 1 < a.size() ? combine(a[k], a[k + 1])
+                                              : std::move(a[k]));
+        }
+        encode(halved, blocks[i]);
+        blocks.erase(blocks.begin() + (long) i + 1);
+        stats.merges++;
+        return true;
+    }
+
+    void enforce_budget() {
+        while (blocks.size() >= 2 && block_bytes() > budget) {
+            // Oldest pair at equal resolution first, so age maps to
+            // coarseness like a binary counter
+            size_t pick = 0;
+            for (size_t i = 0; i + 1 < blocks.size(); i++) {
+                if (blocks[i].span == blocks[i + 1].span) {
+                    pick = i;
+                    break;
+                }
+            }
+            if (!merge(pick)) {
+                log_warn("density_history: corrupt block, dropping oldest");
+                blocks.pop_front();
+            }
+        }
+    }
+
+    void sample(const Grid& grid) {
+        Frame f;
+        f.t0 = f.t1 = clock;
+        f.planes.resize(PLANE_BYTES);
+        for (int i = 0; i < NUM_TILES; i++) {
+            const Tile& t = grid.tiles[i];
+            auto count = (uint8_t) std::clamp(t.agent_count, 0, 255);
+            f.plane(0)[i] = count;
+            f.plane(1)[i] = count;
+            for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+                f.plane(2 + d)[i] =
+                    (uint8_t) std::clamp(t.desire_counts[d], 0, 255);
+            }
+        }
+        open.push_back(std::move(f));
+        stats.samples++;
+
+        if ((int) open.size() >= BLOCK_FRAMES) {
+            encode(open, blocks.emplace_back());
+            open.clear();
+            enforce_budget();
+        }
+        refresh_stats();
+    }
+};
+
+History& hist() {
+    static History h;
+    return h;
+}
+
+void accumulate(const Frame& f, Window& w, std::vector<double>& mean_sum,
+                std::vector<double>& desire_sum) {
+    if (w.samples == 0) {
+        w.t0 = f.t0;
+    }
+    w.t0 = std::min(w.t0, f.t0);
+    w.t1 = std::max(w.t1, f.t1);
+    w.samples += (int) f.samples;
+    for (int i = 0; i < NUM_TILES; i++) {
+        w.max[i] = std::max(w.max[i], f.plane(0)[i]);
+        mean_sum[i] += (double) f.plane(1)[i] * f.samples;
+        for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+            desire_sum[(size_t) d * NUM_TILES + i] +=
+                (double) f.plane(2 + d)[i] * f.samples;
+        }
+    }
+}
+
+}  // namespace
+
+void configure(float interval, size_t budget) {
+    auto& h = hist();
+    h.interval = interval;
+    h.budget = std::max(budget, (size_t) 4096);
+    h.timer = 0.f;
+    h.enforce_budget();
+    h.refresh_stats();
+}
+
+float interval() { return hist().interval; }
+
+void clear() {
+    auto& h = hist();
+    h.blocks.clear();
+    h.open.clear();
+    h.clock = 0.f;
+    h.timer = 0.f;
+    uint64_t version = h.stats.version;
+    h.stats = {};
+    h.stats.version = version + 1;
+}
+
+void tick(float dt) {
+    auto& h = hist();
+    h.clock += dt;
+    if (h.interval <= 0.f) return;
+    h.timer += dt;
+    if (h.timer < h.interval) return;
+    h.timer -= h.interval;
+    sample_now();
+}
+
+void sample_now() {
+    auto* grid = afterhours::EntityHelper::get_singleton_cmp<Grid>();
+    if (grid) hist().sample(*grid);
+}
+
+bool query(float t0, float t1, Window& out) {
+    auto& h = hist();
+    out = Window{};
+    out.max.assign(NUM_TILES, 0);
+    std::vector<double> mean_sum(NUM_TILES, 0.0);
+    std::vector<double> desire_sum((size_t) Tile::NUM_DESIRES * NUM_TILES,
+                                   0.0);
+    auto overlaps = [&](float a, float b) { return b >= t0 && a <= t1; };
+
+    std::vector<Frame> frames;
+    for (const Block& b : h.blocks) {
+        if (!overlaps(b.t0, b.t1) || !decode(b, frames)) continue;
+        for (const Frame& f : frames) {
+            if (overlaps(f.t0, f.t1)) accumulate(f, out, mean_sum, desire_sum);
+        }
+    }
+    for (const Frame& f : h.open) {
+        if (overlaps(f.t0, f.t1)) accumulate(f, out, mean_sum, desire_sum);
+    }
+    if (out.samples == 0) return false;
+
+    out.mean.resize(NUM_TILES);
+    for (auto& plane : out.desire_mean) plane.resize(NUM_TILES);
+    for (int i = 0; i < NUM_TILES; i++) {
+        out.mean[i] = (float) (mean_sum[i] / out.samples);
+        for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+            out.desire_mean[d][i] =
+                (float) (desire_sum[(size_t) d * NUM_TILES + i] / out.samples);
+        }
+    }
+    return true;
+}
+
+bool query_all(Window& out) {
+    return query(0.f, std::max(hist().clock, hist().stats.newest), out);
+}
+
+float now() { return hist().clock; }
+
+Stats stats() { return hist().stats; }
+
+}  // namespace density_history
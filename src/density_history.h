@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "components.h"
+#include "game.h"
+
+// Run-long record of where crowd pressure built up.
+//
+// Every `interval` sim seconds the density plane (agent_count) and the
+// per-desire planes are sampled, clamped to a byte per tile. Samples are
+// grouped into blocks of BLOCK_FRAMES frames; inside a block each frame is
+// stored as the byte-wise difference from the previous one, and the block
+// is LZ-compressed once full (see engine/compress.h).
+//
+// Memory is bounded by `budget` bytes of compressed blocks. When it is
+// exceeded the oldest pair of blocks with equal resolution is merged,
+// halving its time resolution, so recent history stays fine-grained while
+// the start of a long festival degrades gracefully. Each frame keeps the
+// per-tile max and the mean over the samples it covers, so max/mean
+// queries stay exact in time-aligned windows and conservative otherwise.
+namespace density_history {
+
+constexpr int NUM_TILES = MAP_SIZE * MAP_SIZE;
+constexpr int BLOCK_FRAMES = 16;
+constexpr float DEFAULT_INTERVAL = 1.f;     // sim seconds
+constexpr size_t DEFAULT_BUDGET = 2u << 20;  // compressed bytes
+
+// Per-tile statistics over a time window
+struct Window {
+    float t0 = 0.f, t1 = 0.f;  // covered span actually found
+    int samples = 0;
+    std::vector<uint8_t> max;   // peak agent_count
+    std::vector<float> mean;    // mean agent_count
+    std::array<std::vector<float>, Tile::NUM_DESIRES> desire_mean;
+
+    [[nodiscard]] bool empty() const { return samples == 0; }
+};
+
+struct Stats {
+    uint64_t samples = 0;  // taken since the run began
+    int frames = 0;        // stored (after downsampling)
+    int blocks = 0;
+    size_t bytes = 0;      // compressed blocks + open frames
+    uint64_t merges = 0;
+    int coarsest_span = 0;  // samples per frame in the oldest block
+    float oldest = 0.f, newest = 0.f;
+    uint64_t version = 0;  // bumps on every change (cache key)
+};
+
+// interval <= 0 stops sampling; budget is in bytes
+void configure(float interval, size_t budget);
+[[nodiscard]] float interval();
+
+// New run: drop all history and restart the clock
+void clear();
+
+// Advance by one tick's sim time, sampling the grid when due
+void tick(float dt);
+void sample_now();
+
+// Stats over [t0, t1] in sim seconds since the run began (frames that
+// overlap the window count whole). False when nothing was recorded.
+bool query(float t0, float t1, Window& out);
+bool query_all(Window& out);
+
+// Seconds of sim time since clear()
+[[nodiscard]] float now();
+[[nodiscard]] Stats stats();
+
+}  // namespace density_history
@@ -0,0 +1,123 @@
+
+#include "compress.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace compress {
+
+namespace {
+
+constexpr int HASH_BITS = 14;
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+// Stop matching this close to the end so the block ends with literals
+constexpr size_t END_LITERALS = 5;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash4(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+void put_length(std::vector<uint8_t>& out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(len));
+}
+
+void emit(std::vector<uint8_t>& out, const uint8_t* lit, size_t lit_len,
+          size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(lit_len, 15) << 4) |
+                                         std::min<size_t>(ml, 15));
+    out.push_back(token);
+    if (lit_len >= 15) put_length(out, lit_len - 15);
+    out.insert(out.end(), lit, lit + lit_len);
+    if (!match_len) return;
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (ml >= 15) put_length(out, ml - 15);
+}
+
+bool get_length(const uint8_t*& ip, const uint8_t* end, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip >= end) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+}  // namespace
+
+void lz_compress(const uint8_t* src, size_t n, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+    size_t anchor = 0;
+    size_t i = 0;
+    size_t limit = n > END_LITERALS + MIN_MATCH ? n - END_LITERALS : 0;
+
+    while (i + MIN_MATCH <= limit) {
+        uint32_t seq = read32(src + i);
+        uint32_t h = hash4(seq);
+        uint32_t cand = table[h];
+        table[h] = static_cast<uint32_t>(i);
+
+        if (cand == UINT32_MAX || i - cand > MAX_OFFSET ||
+            read32(src + cand) != seq) {
+            i++;
+            continue;
+        }
+
+        size_t len = MIN_MATCH;
+        while (i + len < limit && src[cand + len] == src[i + len]) len++;
+
+        emit(out, src + anchor, i - anchor, i - cand, len);
+        i += len;
+        anchor = i;
+    }
+    emit(out, src + anchor, n - anchor, 0, 0);
+}
+
+bool lz_decompress(const uint8_t* src, size_t n, size_t raw_size,
+                   std::vector<uint8_t>& out) {
+    out.resize(raw_size);
+    uint8_t* op = out.data();
+    uint8_t* oend = op + raw_size;
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + n;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(ip, iend, lit)) return false;
+        if (lit > (size_t) (iend - ip) || lit > (size_t) (oend - op))
+            return false;
+        if (lit) std::memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == iend) break;  // final literal-only sequence
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t len = token & 0x0F;
+        if (len == 15 && !get_length(ip, iend, len)) return false;
+        len += MIN_MATCH;
+        if (offset == 0 || offset > (size_t) (op - out.data()) ||
+            len > (size_t) (oend - op))
+            return false;
+        // Byte copy: matches may overlap their own output (runs)
+        const uint8_t* from = op - offset;
+        for (size_t k = 0; k < len; k++) op[k] = from[k];
+        op += len;
+    }
+    return op == oend;
+}
+
+}  // namespace compress
@@ -0,0 +1,27 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small LZ77 block codec in the style of LZ4: greedy matching through a
+// 4-byte hash table, 64 KB window, no entropy stage. Built for speed on
+// the save file's planar data (tile planes, agent columns), which is
+// mostly runs and repeats.
+//
+// Block = sequences of
+//   token (high nibble: literal count, low nibble: match length - 4;
+//          15 = more length bytes follow, each 255 = keep adding)
+//   [literal length bytes] literals [u16 offset] [match length bytes]
+// The last sequence carries literals only and ends the block.
+namespace compress {
+
+// Append the compressed form of src[0, n) to out
+void lz_compress(const uint8_t* src, size_t n, std::vector<uint8_t>& out);
+
+// Decode exactly raw_size bytes into out. False on corrupt input.
+[[nodiscard]] bool lz_decompress(const uint8_t* src, size_t n,
+                                 size_t raw_size, std::vector<uint8_t>& out);
+
+}  // namespace compress
@@ -0,0 +1,78 @@
+
+#include "mapped_file.h"
+
+#include <fstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    fallback_ = std::move(other.fallback_);
+    data_ = other.data_;  // fallback buffers keep their address on move
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd,
+                   0);
+    ::close(fd);  // the mapping keeps its own reference
+    if (p != MAP_FAILED) {
+        // Loads walk the file front to back exactly once. The advice is a
+        // single value, not a mask, so each hint is its own call.
+        madvise(p, (size_t) st.st_size, MADV_SEQUENTIAL);
+        madvise(p, (size_t) st.st_size, MADV_WILLNEED);
+        data_ = static_cast<const uint8_t*>(p);
+        size_ = (size_t) st.st_size;
+        mapped_ = true;
+        return true;
+    }
+#endif
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) return false;
+    std::streamsize n = f.tellg();
+    if (n <= 0) return false;
+    fallback_.resize((size_t) n);
+    f.seekg(0);
+    if (!f.read(reinterpret_cast<char*>(fallback_.data()), n)) {
+        fallback_.clear();
+        return false;
+    }
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped_ && data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+}
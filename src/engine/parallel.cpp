@@ -0,0 +1,154 @@
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+namespace {
+
+struct Pool {
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    // Current job, published under mtx and identified by generation.
+    const std::function<void(int, int)>* job = nullptr;
+    int job_count = 0;
+    int job_chunks = 0;
+    int next_chunk = 0;
+    int pending = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    int workers = 1;
+    int min_chunk_override = 0;
+
+    static void chunk_bounds(int count, int chunks, int idx, int& begin,
+                             int& end) {
+        int base = count / chunks;
+        int extra = count % chunks;
+        begin = idx * base + std::min(idx, extra);
+        end = begin + base + (idx < extra ? 1 : 0);
+    }
+
+    void worker_loop() {
+        unsigned seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            work_cv.wait(lock,
+                         [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+
+            while (next_chunk < job_chunks) {
+                int idx = next_chunk++;
+                const auto* fn = job;
+                int count = job_count, chunks = job_chunks;
+                lock.unlock();
+
+                int begin, end;
+                chunk_bounds(count, chunks, idx, begin, end);
+                (*fn)(begin, end);
+
+                lock.lock();
+                if (--pending == 0) done_cv.notify_one();
+            }
+        }
+    }
+
+    void start(int count) {
+        stop();
+        workers = count;
+        stopping = false;
+        for (int i = 1; i < workers; i++) {
+            threads.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        for (auto& t : threads) t.join();
+        threads.clear();
+        workers = 1;
+    }
+
+    void run(int count, int min_chunk,
+             const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        if (min_chunk_override > 0) min_chunk = min_chunk_override;
+        int max_chunks = std::max(1, count / std::max(1, min_chunk));
+        int chunks = std::min(workers, max_chunks);
+        if (chunks <= 1) {
+            fn(0, count);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = &fn;
+            job_count = count;
+            job_chunks = chunks;
+            next_chunk = 1;  // chunk 0 is ours
+            pending = chunks - 1;
+            generation++;
+        }
+        work_cv.notify_all();
+
+        int begin, end;
+        chunk_bounds(count, chunks, 0, begin, end);
+        fn(begin, end);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        // Help drain any chunks the workers have not picked up yet
+        while (next_chunk < job_chunks) {
+            int idx = next_chunk++;
+            lock.unlock();
+            chunk_bounds(count, chunks, idx, begin, end);
+            fn(begin, end);
+            lock.lock();
+            --pending;
+        }
+        done_cv.wait(lock, [&] { return pending == 0; });
+        job = nullptr;
+    }
+
+    ~Pool() { stop(); }
+};
+
+Pool& pool() {
+    static Pool p;
+    return p;
+}
+
+}  // namespace
+
+void set_worker_count(int count) {
+    count = std::clamp(count, 1, MAX_WORKERS);
+    if (count == pool().workers) return;
+    pool().start(count);
+}
+
+int worker_count() { return pool().workers; }
+
+void for_range(int count, int min_chunk,
+               const std::function<void(int, int)>& fn) {
+    pool().run(count, min_chunk, fn);
+}
+
+void set_min_chunk_override(int items) {
+    pool().min_chunk_override = std::max(0, items);
+}
+
+void shutdown() { pool().stop(); }
+
+}  // namespace parallel
@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <functional>
+
+// Fixed-size worker pool for data-parallel simulation kernels.
+//
+// Work is split into contiguous index ranges; the calling thread always
+// takes the first range, so a worker count of 1 runs everything inline with
+// no synchronization. Kernels must write only to their own indices so the
+// result is identical for any worker count.
+namespace parallel {
+
+// Number of threads (including the caller) used by for_range. Clamped to
+// [1, MAX_WORKERS]. Safe to call between ticks only.
+constexpr int MAX_WORKERS = 64;
+void set_worker_count(int count);
+[[nodiscard]] int worker_count();
+
+// Call fn(begin, end) over [0, count) in up to worker_count() chunks of at
+// least min_chunk items. Blocks until every chunk has finished.
+void for_range(int count, int min_chunk,
+               const std::function<void(int, int)>& fn);
+
+// Force every for_range to split into chunks of at most `items` (0 = off),
+// ignoring the caller's min_chunk. Lets tests exercise real multi-threaded
+// splits on small crowds.
+void set_min_chunk_override(int items);
+
+// Stop and join all workers (called from cleanup).
+void shutdown();
+
+}  // namespace parallel
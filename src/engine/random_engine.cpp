@@ -2,6 +2,7 @@
 #include "random_engine.h"
 
 #include <functional>
+#include <sstream>
 
 RandomEngine RandomEngine::instance;
 bool RandomEngine::created = false;
@@ -29,6 +30,7 @@ void RandomEngine::_set_seed(const std::string& new_seed) {
     hashed_seed = std::hash<std::string>{}(seed);
     rng_engine.seed(hashed_seed);
     rng_std.seed(static_cast<unsigned int>(hashed_seed));
+    stream_counter = 0;
 }
 
 bool RandomEngine::get_bool() { return int_dist(rng_std) % 2 == 0; }
@@ -72,3 +74,43 @@ vec2 RandomEngine::get_vec(float mn_a, float mx_a, float mn_b, float mx_b) {
 }
 
 std::mt19937& RandomEngine::rng() { return instance.rng_std; }
+
+RandomStream RandomEngine::stream(uint64_t id) {
+    return RandomStream(static_cast<uint64_t>(get().hashed_seed), id);
+}
+
+uint64_t RandomEngine::next_stream_id() { return get().stream_counter++; }
+
+uint64_t RandomEngine::stream_count() { return get().stream_counter; }
+
+void RandomEngine::set_stream_count(uint64_t count) {
+    get().stream_counter = count;
+}
+
+RandomEngine::State RandomEngine::save_state() {
+    auto& e = get();
+    return State{e.seed, e.hashed_seed, e.rng_engine, e.rng_std,
+                 e.stream_counter};
+}
+
+void RandomEngine::restore_state(const State& state) {
+    auto& e = get();
+    e.seed = state.seed;
+    e.hashed_seed = state.hashed_seed;
+    e.rng_engine = state.pcg;
+    e.rng_std = state.mt;
+    e.stream_counter = state.stream_counter;
+}
+
+std::string RandomEngine::state_to_text(const State& state) {
+    std::ostringstream out;
+    out << state.hashed_seed << ' ' << state.stream_counter << ' '
+        << state.pcg << ' ' << state.mt;
+    return out.str();
+}
+
+bool RandomEngine::state_from_text(const std::string& text, State& state) {
+    std::istringstream in(text);
+    in >> state.hashed_seed >> state.stream_counter >> state.pcg >> state.mt;
+    return !in.fail();
+}
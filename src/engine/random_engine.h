@@ -30,11 +30,43 @@
 #define __PRETTY_FUNCTION__ __FUNCSIG__
 #endif
 
+#include <cstdint>
 #include <random>
 #include <string>
+#include <utility>
 
 #include "../rl.h"
 
+// Independent pcg32 stream keyed by (master seed, stream id).
+//
+// Each agent owns one, so simulation code never touches the shared engine
+// and can run on any worker thread. Draws depend only on the seed, the id
+// and how many values this stream has produced, never on thread count or
+// on the order other streams were used.
+struct RandomStream {
+    pcg32 rng;
+
+    RandomStream() = default;
+    RandomStream(uint64_t seed, uint64_t id) : rng(seed, id) {}
+
+    [[nodiscard]] uint32_t next() { return rng(); }
+
+    // Inclusive [a, b], unbiased via pcg's bounded draw.
+    [[nodiscard]] int get_int(int a, int b) {
+        if (a > b) std::swap(a, b);
+        uint32_t span = static_cast<uint32_t>(b - a) + 1u;
+        return a + static_cast<int>(rng(span));
+    }
+
+    [[nodiscard]] float get_float(float a, float b) {
+        if (a > b) std::swap(a, b);
+        float t = static_cast<float>(rng() >> 8) * (1.f / 16777216.f);
+        return a + (b - a) * t;
+    }
+
+    [[nodiscard]] bool get_bool() { return (rng() & 1u) == 0; }
+};
+
 struct RandomEngine {
     static void create();
     [[nodiscard]] static RandomEngine& get();
@@ -56,12 +88,38 @@ struct RandomEngine {
     [[nodiscard]] static pcg32 generator() { return instance.rng_engine; }
     [[nodiscard]] static std::mt19937& rng();
 
+    // Stream `id` of the current seed. Same seed + id -> same sequence.
+    [[nodiscard]] static RandomStream stream(uint64_t id);
+    // Hands out stream ids in creation order; restarts on set_seed so a
+    // reseeded run gives every agent the same stream as last time.
+    [[nodiscard]] static uint64_t next_stream_id();
+    // Save/load: restore the counter so loaded runs keep fresh ids
+    [[nodiscard]] static uint64_t stream_count();
+    static void set_stream_count(uint64_t count);
+
+    // Full generator state (replay keyframes)
+    struct State {
+        std::string seed;
+        size_t hashed_seed = 0;
+        pcg32 pcg;
+        std::mt19937 mt;
+        uint64_t stream_counter = 0;
+    };
+    [[nodiscard]] static State save_state();
+    static void restore_state(const State& state);
+    // Engines only expose their state through iostreams; `seed` is not
+    // part of the text (save it separately)
+    [[nodiscard]] static std::string state_to_text(const State& state);
+    [[nodiscard]] static bool state_from_text(const std::string& text,
+                                              State& state);
+
    private:
     void _set_seed(const std::string& new_seed);
     std::string seed = "default_seed";
     size_t hashed_seed;
     pcg32 rng_engine;
     std::mt19937 rng_std;
+    uint64_t stream_counter = 0;
     std::uniform_int_distribution<int> int_dist;
     std::uniform_real_distribution<float> float_dist;
 
@@ -0,0 +1,147 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Uniform-grid spatial hash over a flat set of 2D points.
+//
+// Rebuilt from scratch each tick with a counting sort: one pass to count
+// points per cell, a prefix sum, and one pass to scatter. Every cell's
+// points end up contiguous in `xs`/`zs`/`ids`, so neighbor queries walk
+// plain float arrays (SoA) that the compiler can vectorize.
+struct SpatialHash {
+    float origin = 0.f;
+    float cell_size = 1.f;
+    float inv_cell = 1.f;
+    int cols = 0;
+
+    // cell_start[c] .. cell_start[c + 1] is cell c's slice of xs/zs/ids.
+    std::vector<int> cell_start;
+    std::vector<float> xs;
+    std::vector<float> zs;
+    std::vector<int> ids;  // index of each sorted point in the input arrays
+
+    // Per input point: its cell, kept so queries don't rehash.
+    std::vector<int> point_cell;
+
+    // Square world of `extent` units starting at `world_origin`.
+    void init(float world_origin, float extent, float cell) {
+        origin = world_origin;
+        cell_size = cell;
+        inv_cell = 1.f / cell;
+        cols = std::max(1, static_cast<int>(std::ceil(extent * inv_cell)));
+        cell_start.assign(static_cast<size_t>(cols * cols + 1), 0);
+    }
+
+    [[nodiscard]] int cell_coord(float v) const {
+        int c = static_cast<int>((v - origin) * inv_cell);
+        return std::clamp(c, 0, cols - 1);
+    }
+
+    [[nodiscard]] int cell_of(float x, float z) const {
+        return cell_coord(z) * cols + cell_coord(x);
+    }
+
+    void build(const float* px, const float* pz, int count) {
+        size_t n = static_cast<size_t>(count);
+        xs.resize(n);
+        zs.resize(n);
+        ids.resize(n);
+        point_cell.resize(n);
+        std::fill(cell_start.begin(), cell_start.end(), 0);
+
+        for (int i = 0; i < count; i++) {
+            int c = cell_of(px[i], pz[i]);
+            point_cell[i] = c;
+            cell_start[c + 1]++;
+        }
+        for (size_t c = 1; c < cell_start.size(); c++) {
+            cell_start[c] += cell_start[c - 1];
+        }
+
+        // Scatter using a running cursor per cell; cell_start[c] is restored
+        // afterwards by shifting the cursors back one slot.
+        for (int i = 0; i < count; i++) {
+            int dst = cell_start[point_cell[i]]++;
+            xs[dst] = px[i];
+            zs[dst] = pz[i];
+            ids[dst] = i;
+        }
+        for (size_t c = cell_start.size() - 1; c > 0; c--) {
+            cell_start[c] = cell_start[c - 1];
+        }
+        cell_start[0] = 0;
+    }
+
+    [[nodiscard]] int size() const { return static_cast<int>(xs.size()); }
+};
+
+// Boids-style separation: for each point in [begin, end) sum a push away
+// from every neighbor closer than `radius`, scaled by overlap. Writes only
+// out_dx[i]/out_dz[i], so disjoint ranges can run on different threads and
+// the result never depends on how the range was split.
+//
+// Exactly coincident points (spawned on the same spot) have no direction to
+// push along; they get a fixed direction from their `point_seeds` entry so
+// stacks still fan out deterministically. Seeds should follow the point's
+// identity, not its index, so the fan-out survives reordering.
+inline void compute_separation(const SpatialHash& hash, const float* px,
+                               const float* pz, float radius,
+                               const uint32_t* point_seeds, int begin,
+                               int end, float* out_dx, float* out_dz) {
+    const float r2 = radius * radius;
+    const float inv_r = 1.f / radius;
+    const int cols = hash.cols;
+    const float* hx = hash.xs.data();
+    const float* hz = hash.zs.data();
+    const int* hid = hash.ids.data();
+
+    for (int i = begin; i < end; i++) {
+        const float x = px[i];
+        const float z = pz[i];
+        const int c = hash.point_cell[i];
+        const int cx = c % cols;
+        const int cz = c / cols;
+
+        float sx = 0.f, sz = 0.f;
+        int coincident = 0;
+
+        for (int nz = std::max(cz - 1, 0); nz <= std::min(cz + 1, cols - 1);
+             nz++) {
+            const int row = nz * cols;
+            const int lo = hash.cell_start[row + std::max(cx - 1, 0)];
+            const int hi =
+                hash.cell_start[row + std::min(cx + 1, cols - 1) + 1];
+
+            // Branch-free inner loop over one contiguous row of cells.
+            for (int k = lo; k < hi; k++) {
+                float dx = x - hx[k];
+                float dz = z - hz[k];
+                float d2 = dx * dx + dz * dz;
+                bool near = d2 < r2 && d2 > 0.f;
+                float d = std::sqrt(d2 + 1e-12f);
+                float w = near ? (1.f - d * inv_r) / d : 0.f;
+                sx += dx * w;
+                sz += dz * w;
+                coincident += (d2 == 0.f && hid[k] != i) ? 1 : 0;
+            }
+        }
+
+        if (coincident > 0) {
+            uint32_t h = point_seeds[i] * 0x9E3779B9u;
+            h ^= h >> 16;
+            h *= 0x45d9f3bu;
+            h ^= h >> 16;
+            float angle =
+                static_cast<float>(h & 0xFFFF) * (6.2831853f / 65536.f);
+            sx += std::cos(angle);
+            sz += std::sin(angle);
+        }
+
+        out_dx[i] = sx;
+        out_dz[i] = sz;
+    }
+}
@@ -3,9 +3,12 @@
 #include "afterhours/src/core/entity_query.h"
 #include "afterhours/src/plugins/input_system.h"
 #include "afterhours/src/plugins/window_manager.h"
+#include "autosave.h"
+#include "density_history.h"
 #include "engine/random_engine.h"
 #include "game.h"
 #include "input_mapping.h"
+#include "replay.h"
 
 using namespace afterhours;
 
@@ -53,6 +56,12 @@ Entity& make_sophie() {
     sophie.addComponent<VisibleRegion>();
     EntityHelper::registerSingleton<VisibleRegion>(sophie);
 
+    sophie.addComponent<MacroCrowd>();
+    EntityHelper::registerSingleton<MacroCrowd>(sophie);
+
+    sophie.addComponent<CrushForecast>();
+    EntityHelper::registerSingleton<CrushForecast>(sophie);
+
     // Initialize the grid
     auto& grid_ref = sophie.get<Grid>();
     grid_ref.init_perimeter();
@@ -75,6 +84,7 @@ Entity& make_agent(int grid_x, int grid_z, FacilityType want, int target_x,
     auto* grid = EntityHelper::get_singleton_cmp<Grid>();
 
     Entity& e = EntityHelper::createEntity();
+    telemetry::bump(telemetry::EntitiesCreated);
 
     // Convert grid position to world position
     ::vec2 world_pos = grid ? grid->grid_to_world(grid_x, grid_z)
@@ -83,10 +93,14 @@ Entity& make_agent(int grid_x, int grid_z, FacilityType want, int target_x,
     e.addComponent<Agent>(want, target_x, target_z);
     e.addComponent<AgentHealth>();
 
-    auto& rng = RandomEngine::get();
+    // Each agent draws from its own stream from here on
+    Agent& agent = e.get<Agent>();
+    agent.rng_id = RandomEngine::next_stream_id();
+    agent.rng = RandomEngine::stream(agent.rng_id);
+    auto& rng = agent.rng;
 
     // Random color variety
-    e.get<Agent>().color_idx = static_cast<uint8_t>(rng.get_int(0, 7));
+    agent.color_idx = static_cast<uint8_t>(rng.get_int(0, 7));
     e.addComponent<AgentNeeds>();
     auto& needs = e.get<AgentNeeds>();
     needs.bathroom_threshold = rng.get_float(30.f, 90.f);
@@ -117,7 +131,9 @@ void reset_game_state() {
             tile.agent_count = 0;
             tile.pheromone = {0, 0, 0, 0, 0};
         }
+        grid->pheromone_decay_timer = 0.f;
         grid->init_perimeter();
+        grid->bump_density_version();
     }
 
     // Reset game state
@@ -145,6 +161,12 @@ void reset_game_state() {
         ss->manual_override = false;
     }
 
+    // New run: next autosave is a full interval away, any replay
+    // recording or playback belongs to the old one, history starts over
+    autosave::reset_timer();
+    replay::stop();
+    density_history::clear();
+
     // Reset game clock
     auto* clock = EntityHelper::get_singleton_cmp<GameClock>();
     if (clock) {
@@ -184,6 +206,13 @@ void reset_game_state() {
         diff->event_timer = 0.f;
         diff->next_event_time = 120.f;
     }
+
+    // Drop aggregated populations (hybrid sim stays on/off as configured)
+    auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+    if (mc) mc->clear();
+
+    auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+    if (cf) cf->clear();
 }
 
 bool should_escape_quit() {
@@ -70,6 +70,7 @@ struct RandomEventSystem : System<> {
 
         int event_id = rng.get_int(0, 3);
         Entity& ev_entity = EntityHelper::createEntity();
+        telemetry::bump(telemetry::EntitiesCreated);
         ev_entity.addComponent<ActiveEvent>();
         auto& ev = ev_entity.get<ActiveEvent>();
 
@@ -101,9 +102,9 @@ struct RandomEventSystem : System<> {
 };
 
 void register_event_effect_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<ApplyEventEffectsSystem>());
+    sm.register_update_system(timed<ApplyEventEffectsSystem>());
 }
 
 void register_event_random_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<RandomEventSystem>());
+    sm.register_update_system(timed<RandomEventSystem>());
 }
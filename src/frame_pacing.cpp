@@ -0,0 +1,246 @@
+// Frame pacing domain: per-frame render/skip decision, loop rate cap and
+// idle detection.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "frame_pacing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "afterhours/src/core/entity_helper.h"
+#include "afterhours/src/core/entity_query.h"
+#include "components.h"
+#include "rl.h"
+
+namespace frame_pacing {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Used when the monitor does not report a refresh rate (hidden windows)
+constexpr int FALLBACK_DISPLAY_FPS = 60;
+
+struct State {
+    Config config;
+    std::function<void()> render_fn;
+    int redraws = 0;           // requested frames still to draw
+    bool drawn = false;        // this frame
+    bool fresh = false;        // last drawn frame shows the latest update
+    float quiet = 0.f;         // seconds without activity
+    float since_render = 0.f;  // seconds since the last drawn frame
+    int applied_fps = -1;      // last cap handed to the backend, -1 none
+    Clock::time_point frame_mark = Clock::now();
+    Clock::time_point dt_mark = Clock::now();  // last frame_dt()
+    vec2 last_mouse{};
+    Stats stats;
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+int display_fps() {
+#ifdef AFTER_HOURS_USE_RAYLIB
+    int hz = raylib::GetMonitorRefreshRate(raylib::GetCurrentMonitor());
+    if (hz > 0) return hz;
+#endif
+    return FALLBACK_DISPLAY_FPS;
+}
+
+// Resolves DISPLAY_RATE / UNCAPPED to a backend cap (0 = none)
+int resolve(int fps) {
+    if (fps == UNCAPPED) return 0;
+    if (fps == DISPLAY_RATE) return display_fps();
+    return fps;
+}
+
+void apply_loop_fps(int fps) {
+    auto& s = state();
+    s.stats.loop_fps = fps;
+    if (s.applied_fps == fps) return;
+    s.applied_fps = fps;
+#ifdef AFTER_HOURS_USE_RAYLIB
+    raylib::SetTargetFPS(fps);
+#endif
+}
+
+bool window_focused() {
+#ifdef AFTER_HOURS_USE_RAYLIB
+    return raylib::IsWindowFocused();
+#else
+    return true;
+#endif
+}
+
+// Mouse input this frame, including presses injected by tests; the
+// render pass handles hover and clicks, so these frames must be drawn
+bool mouse_active() {
+    auto& s = state();
+    using afterhours::input;
+    vec2 mouse = input::get_mouse_position();
+    bool moved = mouse.x != s.last_mouse.x || mouse.y != s.last_mouse.y;
+    s.last_mouse = mouse;
+    if (moved || input::get_mouse_wheel_move() != 0.f) return true;
+    for (int button : {MOUSE_BUTTON_LEFT, MOUSE_BUTTON_RIGHT}) {
+        if (input::is_mouse_button_down(button) ||
+            input::is_mouse_button_pressed(button))
+            return true;
+    }
+    return false;
+}
+
+// Anything the player is doing this frame
+bool input_active(bool mouse) {
+    if (mouse) return true;
+    auto collector = afterhours::input::get_input_collector();
+    return collector.valid() && !collector.inputs().empty();
+}
+
+// Something on screen moves even with the sim stopped
+bool animating() {
+    return afterhours::EntityQuery()
+               .whereHasComponent<ToastMessage>()
+               .gen_count() > 0;
+}
+
+bool sim_running() {
+    using afterhours::EntityHelper;
+    auto* clock = EntityHelper::get_singleton_cmp<GameClock>();
+    auto* gs = EntityHelper::get_singleton_cmp<GameState>();
+    if (gs && gs->is_game_over()) return false;
+    return clock && clock->speed != GameSpeed::Paused;
+}
+
+bool adaptive_should_render(float dt, bool mouse) {
+    auto& s = state();
+    const Config& c = s.config;
+    bool active = input_active(mouse) || animating() || s.redraws > 0;
+    s.quiet = active ? 0.f : s.quiet + dt;
+
+    bool running = sim_running();
+    bool idle = (!running || !window_focused()) && s.quiet >= c.idle_after;
+    s.stats.idle = idle;
+    if (!idle) {
+        apply_loop_fps(resolve(c.fps));
+        return true;
+    }
+    // Nothing advances: slow the whole loop down
+    if (!running) {
+        apply_loop_fps(resolve(c.idle_fps));
+        return true;
+    }
+    // Unfocused but simulating: keep stepping at full rate, draw rarely
+    apply_loop_fps(resolve(c.fps));
+    return c.idle_fps <= 0 || s.since_render >= 1.f / (float) c.idle_fps;
+}
+
+}  // namespace
+
+void configure(const Config& config) {
+    state().config = config;
+    state().applied_fps = -1;
+}
+
+const Config& config() { return state().config; }
+
+void set_mode(Mode mode) {
+    state().config.mode = mode;
+    state().quiet = 0.f;
+}
+
+std::optional<Mode> parse_mode(std::string_view name) {
+    if (name == "adaptive") return Mode::Adaptive;
+    if (name == "fixed") return Mode::Fixed;
+    if (name == "on-demand") return Mode::OnDemand;
+    return std::nullopt;
+}
+
+void set_render_fn(std::function<void()> fn) {
+    state().render_fn = std::move(fn);
+}
+
+float frame_dt() {
+    auto& s = state();
+    auto now = Clock::now();
+    float dt = std::chrono::duration<float>(now - s.dt_mark).count();
+    s.dt_mark = now;
+    return std::clamp(dt, 0.f, MAX_FRAME_DT);
+}
+
+bool should_render(float dt) {
+    auto& s = state();
+    s.drawn = false;
+    s.since_render += dt;
+    bool mouse = mouse_active();
+
+    bool draw = true;
+    switch (s.config.mode) {
+        case Mode::Adaptive:
+            draw = adaptive_should_render(dt, mouse);
+            break;
+        case Mode::Fixed:
+            apply_loop_fps(resolve(s.config.fps));
+            break;
+        case Mode::OnDemand:
+            apply_loop_fps(resolve(s.config.fps));
+            draw = s.redraws > 0 || mouse;
+            break;
+    }
+    if (draw && s.redraws > 0) s.redraws--;
+    return draw;
+}
+
+void mark_rendered() {
+    auto& s = state();
+    s.drawn = true;
+    s.fresh = true;
+    s.since_render = 0.f;
+    s.stats.rendered++;
+}
+
+void mark_updated() { state().fresh = false; }
+
+void render_now() {
+    auto& s = state();
+    if (s.fresh || !s.render_fn) return;
+    s.render_fn();
+    mark_rendered();
+}
+
+void end_frame() {
+    auto& s = state();
+    if (s.drawn) {
+        // Presenting already waited out the frame
+        s.frame_mark = Clock::now();
+        return;
+    }
+    s.stats.skipped++;
+#ifdef AFTER_HOURS_USE_RAYLIB
+    raylib::PollInputEvents();
+#endif
+    if (s.stats.loop_fps > 0) {
+        auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / s.stats.loop_fps));
+        std::this_thread::sleep_until(s.frame_mark + period);
+    }
+    s.frame_mark = Clock::now();
+}
+
+void request_redraw(int frames) {
+    auto& s = state();
+    s.redraws = std::max(s.redraws, frames);
+}
+
+Stats stats() { return state().stats; }
+
+void reset_stats() {
+    auto& s = state();
+    s.stats.rendered = 0;
+    s.stats.skipped = 0;
+}
+
+}  // namespace frame_pacing
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+// Decides, once per frame, whether the render systems run and how fast
+// the main loop spins.
+//
+//   Adaptive  loop capped to the display refresh rate; once the game is
+//             paused (or the window unfocused) and nothing has moved for
+//             idle_after seconds (no input, no toasts fading), redraws
+//             drop to idle_fps until something happens again
+//   Fixed     loop capped to fps, every frame drawn (the old behavior)
+//   OnDemand  update systems run every frame but nothing is drawn unless
+//             a redraw was requested: screenshots, injected input, e2e
+//             commands that read the screen (test and MCP runs)
+//
+// Frames that skip rendering still poll input and sleep out the rest of
+// the frame, so an idle window costs next to nothing. Any mouse input
+// (real or injected) forces a draw in every mode, since clicks and hover
+// are handled by render systems.
+namespace frame_pacing {
+
+enum class Mode { Adaptive, Fixed, OnDemand };
+
+constexpr int DISPLAY_RATE = 0;  // fps: follow the monitor refresh rate
+constexpr int UNCAPPED = -1;     // fps: no limit
+
+// Longest step frame_dt() reports (stalls, debugger breaks)
+constexpr float MAX_FRAME_DT = 0.25f;
+
+struct Config {
+    Mode mode = Mode::Adaptive;
+    int fps = DISPLAY_RATE;  // loop rate while active
+    int idle_fps = 10;       // redraw rate while idle (Adaptive)
+    float idle_after = 0.5f;  // seconds of quiet before going idle
+};
+
+void configure(const Config& config);
+[[nodiscard]] const Config& config();
+void set_mode(Mode mode);
+
+// "adaptive", "fixed", "on-demand"
+[[nodiscard]] std::optional<Mode> parse_mode(std::string_view name);
+
+// Draws one full frame immediately (set by main; used for screenshots
+// taken on frames that were not drawn)
+void set_render_fn(std::function<void()> fn);
+
+// ── Frame loop (main.cpp) ──
+
+// Seconds since the previous call, clamped to MAX_FRAME_DT. Measured here
+// because the backend's frame time only advances on drawn frames.
+[[nodiscard]] float frame_dt();
+
+// Call first in every frame; true = run update and render systems,
+// false = update systems only
+[[nodiscard]] bool should_render(float dt);
+
+// A frame was drawn (by the loop or by render_now)
+void mark_rendered();
+
+// Update systems ran without drawing; the screen is now behind
+void mark_updated();
+
+// Draw now unless the screen already shows the latest update
+void render_now();
+
+// Call last in every frame; paces frames that were not drawn
+void end_frame();
+
+// ── Wake-ups ──
+
+// Draw the next `frames` frames whatever the mode
+void request_redraw(int frames = 1);
+
+struct Stats {
+    uint64_t rendered = 0;
+    uint64_t skipped = 0;
+    int loop_fps = 0;  // current cap, 0 = uncapped
+    bool idle = false;
+};
+[[nodiscard]] Stats stats();
+void reset_stats();
+
+}  // namespace frame_pacing
@@ -33,6 +33,12 @@ constexpr int STAGE_SIZE = 4;  // 4x4 footprint
 constexpr float SPEED_PATH = 0.5f;
 constexpr float SPEED_GRASS = 0.25f;
 
+// Sub-tile agent separation (boids)
+constexpr float SEPARATION_RADIUS = 0.25f;      // tiles
+constexpr float SEPARATION_STRENGTH = 0.6f;     // tiles/sec at full overlap
+constexpr float SEPARATION_TILE_INSET = 0.45f;  // max offset from tile center
+constexpr int SEPARATION_MIN_CHUNK = 2048;      // agents per worker thread
+
 // Spawn rate
 constexpr float DEFAULT_SPAWN_INTERVAL = 2.0f;  // seconds between spawns
 
@@ -60,6 +66,17 @@ constexpr float DENSITY_CRITICAL = 0.90f;   // 36 agents — crush damage
 constexpr float CRUSH_DAMAGE_RATE = 0.2f;   // HP/sec in critical zone
 constexpr int MAX_DEATHS = 10;
 
+// Crush forecasting (rolling tile inflow/outflow windows)
+constexpr int FORECAST_BUCKETS = 8;              // window = buckets * width
+constexpr float FORECAST_BUCKET_SECONDS = 0.5f;  // 4 second window
+constexpr float FORECAST_HORIZON = 20.f;         // seconds; overlay ETA cutoff
+
+// Hybrid (macroscopic) crowd simulation
+constexpr float MACRO_STEP = 0.25f;          // seconds between continuum steps
+constexpr int MACRO_AGGREGATE_MIN = 8;       // agents before a tile aggregates
+constexpr int MACRO_RELEASE_BELOW = 4;       // re-materialize below this count
+constexpr float MACRO_TILE_CAPACITY = 30.f;  // inflow cap (dangerous density)
+
 // Version
 constexpr std::string_view VERSION = "0.0.1";
 
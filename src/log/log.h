@@ -2,14 +2,23 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <magic_enum/magic_enum.hpp>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 
 #include "log_level.h"
@@ -40,6 +49,14 @@ inline bool g_log_to_stderr = true;
 inline bool g_log_to_stderr = false;
 #endif
 
+inline void write_log_line(LogLevel level, std::string_view line) {
+    const std::string_view color_start = level >= LogLevel::LOG_WARN  //
+                                             ? color_red
+                                             : color_white;
+    fmt::print(g_log_to_stderr ? stderr : stdout, "{}{}{}\n", color_start,
+               line, color_reset);
+}
+
 inline void vlog(LogLevel level, const char *file, int line,
                  fmt::string_view format, fmt::format_args args) {
     if (level < AFTER_HOURS_LOG_LEVEL) return;
@@ -49,23 +66,293 @@ inline void vlog(LogLevel level, const char *file, int line,
         file_info = "";
     }
 
-    const std::string_view color_start = level >= LogLevel::LOG_WARN  //
-                                             ? color_red
-                                             : color_white;
-
     const auto message = fmt::vformat(format, args);
     const auto full_output = fmt::format("{}{}", file_info, message);
-    if (g_log_to_stderr) {
-        fmt::print(stderr, "{}{}{}\n", color_start, full_output, color_reset);
+    write_log_line(level, full_output);
+}
+
+// Asynchronous backend.
+//
+// Callers claim a slot in a bounded lock-free MPSC ring (Vyukov sequence
+// numbers), fill it and return; a background thread formats and writes.
+// Arithmetic and enum arguments are copied into the slot and formatted on
+// the log thread. Anything else (strings, custom types) may not outlive
+// the call, so it is formatted into the slot on the caller, still without
+// allocating. The format string itself must be a literal, as at every
+// call site in the tree.
+//
+// A full ring never blocks: the message is dropped and counted, and the
+// log thread reports the count. Errors, and messages too long for a slot,
+// flush the ring and are written synchronously so they keep their order
+// (and land before log_error's assert).
+namespace log_async {
+
+constexpr size_t QUEUE_SLOTS = 4096;  // power of two
+constexpr size_t PAYLOAD_BYTES = 224;
+
+struct Record;
+using FormatFn = void (*)(const Record &, fmt::memory_buffer &);
+
+struct Record {
+    LogLevel level;
+    int line;
+    const char *file;
+    const char *format;
+    FormatFn format_fn;  // nullptr: payload holds the formatted message
+    size_t len;
+    alignas(std::max_align_t) char payload[PAYLOAD_BYTES];
+};
+
+struct Stats {
+    uint64_t enqueued = 0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;     // ring full
+    uint64_t suppressed = 0;  // swallowed by per-callsite rate limits
+};
+
+enum State { UNSTARTED, RUNNING, STOPPED };
+inline std::atomic<int> g_state{UNSTARTED};
+inline std::atomic<bool> g_enabled{true};
+
+class Backend {
+   public:
+    Backend() : slots(new Slot[QUEUE_SLOTS]) {
+        for (size_t i = 0; i < QUEUE_SLOTS; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        g_state.store(RUNNING, std::memory_order_release);
+        worker = std::thread([this] { run(); });
+    }
+
+    // Static destruction: anything logged later is written synchronously
+    ~Backend() {
+        g_state.store(STOPPED, std::memory_order_release);
+        stop.store(true, std::memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
+
+    Backend(const Backend &) = delete;
+    Backend &operator=(const Backend &) = delete;
+
+    // Claim a slot and let `fill` write the record; false when full
+    template<typename Fill>
+    bool push(Fill &&fill) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &slots[pos & (QUEUE_SLOTS - 1)];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = (intptr_t) seq - (intptr_t) pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->rec);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Wait until everything queued so far has been written
+    void flush() {
+        size_t target = enqueue_pos.load(std::memory_order_acquire);
+        while (consumed.load(std::memory_order_acquire) < target &&
+               !stop.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void count_suppressed() {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Stats stats() const {
+        Stats st;
+        st.enqueued = enqueue_pos.load(std::memory_order_relaxed);
+        st.written = consumed.load(std::memory_order_relaxed);
+        st.dropped = dropped.load(std::memory_order_relaxed);
+        st.suppressed = suppressed.load(std::memory_order_relaxed);
+        return st;
+    }
+
+   private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        Record rec;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> consumed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<bool> stop{false};
+    std::thread worker;
+
+    // Log thread only
+    fmt::memory_buffer line_buf;
+    uint64_t reported_drops = 0;
+
+    bool pop_one() {
+        size_t pos = consumed.load(std::memory_order_relaxed);
+        Slot &slot = slots[pos & (QUEUE_SLOTS - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) return false;
+        write(slot.rec);
+        slot.seq.store(pos + QUEUE_SLOTS, std::memory_order_release);
+        consumed.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void write(const Record &rec) {
+        line_buf.clear();
+        auto out = std::back_inserter(line_buf);
+        if (rec.line != -1) {
+            fmt::format_to(out, "{}: {}: {}: ", rec.file, rec.line,
+                           level_to_string(rec.level));
+        }
+        if (rec.format_fn) {
+            try {
+                rec.format_fn(rec, line_buf);
+            } catch (const fmt::format_error &err) {
+                fmt::format_to(out, "<format error: {}> {}", err.what(),
+                               rec.format);
+            }
+        } else {
+            line_buf.append(rec.payload, rec.payload + rec.len);
+        }
+        write_log_line(rec.level,
+                       std::string_view(line_buf.data(), line_buf.size()));
+    }
+
+    void report_drops() {
+        uint64_t n = dropped.load(std::memory_order_relaxed);
+        if (n == reported_drops) return;
+        write_log_line(LogLevel::LOG_WARN,
+                       fmt::format("log: {} messages dropped (queue full)",
+                                   n - reported_drops));
+        reported_drops = n;
+    }
+
+    void run() {
+        int idle = 0;
+        for (;;) {
+            bool wrote = false;
+            while (pop_one()) wrote = true;
+            report_drops();
+            if (wrote) {
+                std::fflush(nullptr);
+                idle = 0;
+                continue;
+            }
+            if (stop.load(std::memory_order_acquire)) break;
+            // Back off from a short poll to 1ms once the game goes quiet
+            std::this_thread::sleep_for(idle++ < 64
+                                            ? std::chrono::microseconds(50)
+                                            : std::chrono::microseconds(1000));
+        }
+    }
+};
+
+inline Backend &backend() {
+    static Backend b;
+    return b;
+}
+
+template<typename T>
+constexpr bool is_deferrable_v =
+    std::is_arithmetic_v<std::decay_t<T>> || std::is_enum_v<std::decay_t<T>>;
+
+template<typename Tuple>
+inline void format_deferred(const Record &rec, fmt::memory_buffer &out) {
+    const auto &args =
+        *std::launder(reinterpret_cast<const Tuple *>(rec.payload));
+    std::apply(
+        [&](const auto &...a) {
+            fmt::vformat_to(std::back_inserter(out), rec.format,
+                            fmt::make_format_args(a...));
+        },
+        args);
+}
+
+inline void flush() {
+    if (g_state.load(std::memory_order_acquire) == RUNNING) {
+        backend().flush();
+    }
+}
+
+template<typename... Args>
+inline void submit(LogLevel level, const char *file, int line,
+                   const char *format, Args &&...args) {
+    if (level < AFTER_HOURS_LOG_LEVEL) return;
+    if (level >= LogLevel::LOG_ERROR ||
+        !g_enabled.load(std::memory_order_relaxed) ||
+        g_state.load(std::memory_order_acquire) == STOPPED) {
+        flush();
+        vlog(level, file, line, format, fmt::make_format_args(args...));
+        return;
+    }
+
+    using Tuple = std::tuple<std::decay_t<Args>...>;
+    if constexpr ((is_deferrable_v<Args> && ...) &&
+                  sizeof(Tuple) <= PAYLOAD_BYTES) {
+        backend().push([&](Record &rec) {
+            rec.level = level;
+            rec.line = line;
+            rec.file = file;
+            rec.format = format;
+            rec.format_fn = &format_deferred<Tuple>;
+            rec.len = 0;
+            new (rec.payload) Tuple(args...);
+        });
     } else {
-        fmt::print("{}{}{}\n", color_start, full_output, color_reset);
+        char text[PAYLOAD_BYTES];
+        auto res = fmt::vformat_to_n(text, PAYLOAD_BYTES, format,
+                                     fmt::make_format_args(args...));
+        if (res.size > PAYLOAD_BYTES) {
+            flush();
+            vlog(level, file, line, format, fmt::make_format_args(args...));
+            return;
+        }
+        backend().push([&](Record &rec) {
+            rec.level = level;
+            rec.line = line;
+            rec.file = file;
+            rec.format = format;
+            rec.format_fn = nullptr;
+            rec.len = res.size;
+            std::memcpy(rec.payload, text, res.size);
+        });
     }
 }
 
+}  // namespace log_async
+
+// Write out everything queued so far (before exit, crash reports, tests)
+inline void log_flush() { log_async::flush(); }
+
+// false: every message is formatted and written on the calling thread
+inline void log_set_async(bool enabled) {
+    log_async::flush();
+    log_async::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+[[nodiscard]] inline log_async::Stats log_stats() {
+    if (log_async::g_state.load(std::memory_order_acquire) ==
+        log_async::UNSTARTED)
+        return {};
+    return log_async::backend().stats();
+}
+
 template<typename... Args>
 inline void log_me(LogLevel level, const char *file, int line,
                    const char *format, Args &&...args) {
-    vlog(level, file, line, format, fmt::make_format_args(args...));
+    log_async::submit(level, file, line, format, std::forward<Args>(args)...);
 }
 
 template<typename... Args>
@@ -77,7 +364,7 @@ inline void log_me(LogLevel level, const char *file, int line,
 template<>
 inline void log_me(LogLevel level, const char *file, int line,
                    const char *format, const char *&&args) {
-    vlog(level, file, line, format, fmt::make_format_args(args));
+    log_async::submit(level, file, line, format, args);
 }
 
 // Thread-safe storage for log_once_per timing
@@ -107,4 +394,60 @@ inline void log_once_per(std::chrono::milliseconds interval, Level level,
     }
 }
 
+// Per-callsite rate limit behind LOG_SITE and log_*_limited: at most
+// `burst` messages per `interval`. What it swallows is counted and
+// reported with the next message it lets through. Lock-free, so it is
+// safe on worker threads.
+struct LogSite {
+    LogLevel level;
+    const char *file;
+    int line;
+    int burst;
+    int64_t interval_ns;
+    // Current window number (upper 32 bits) and lines let through in it
+    // (lower 32): one word, so starting a window and counting against it
+    // are both a single compare-exchange and can't lose updates
+    std::atomic<uint64_t> window{0};
+    std::atomic<uint32_t> suppressed{0};
+
+    LogSite(LogLevel level_, const char *file_, int line_, int burst_,
+            std::chrono::nanoseconds interval)
+        : level(level_),
+          file(file_),
+          line(line_),
+          burst(burst_),
+          interval_ns(std::max<int64_t>(1, interval.count())) {}
+
+    bool allow() {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+        // +1 so the zero-initialized word never matches a live window
+        uint64_t current = (uint64_t) (now / interval_ns + 1) & 0xffffffffu;
+        uint64_t seen = window.load(std::memory_order_relaxed);
+        bool allowed = false;
+        while (true) {
+            uint64_t used = (seen >> 32) == current ? seen & 0xffffffffu : 0;
+            if (used >= (uint64_t) burst) break;
+            if (window.compare_exchange_weak(seen, (current << 32) | (used + 1),
+                                             std::memory_order_relaxed)) {
+                allowed = true;
+                break;
+            }
+        }
+        if (!allowed) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            if (log_async::g_state.load(std::memory_order_acquire) ==
+                log_async::RUNNING)
+                log_async::backend().count_suppressed();
+            return false;
+        }
+        uint32_t n = suppressed.exchange(0, std::memory_order_relaxed);
+        if (n > 0) {
+            log_me(level, file, line, "({} similar messages suppressed)", n);
+        }
+        return true;
+    }
+};
+
 #include "log_macros.h"
@@ -35,3 +35,28 @@
 
 #define LOG_ONCE_PER(interval, level, ...) \
     log_once_per(interval, level, __FILE__, __LINE__, __VA_ARGS__)
+
+// Rate limiter owned by this call site (see LogSite); arguments must be
+// constants. Use directly to gate a group of lines:
+//   if (LOG_SITE(LogLevel::LOG_WARN, 5, std::chrono::seconds(10)).allow())
+#define LOG_SITE(level, burst, interval)                                      \
+    ([]() -> LogSite & {                                                      \
+        static LogSite log_site_{level, __FILE__, __LINE__, burst, interval}; \
+        return log_site_;                                                     \
+    }())
+
+#define log_info_limited(burst, interval, ...)                          \
+    do {                                                                \
+        if (static_cast<int>(LogLevel::LOG_INFO) >=                     \
+                static_cast<int>(AFTER_HOURS_LOG_LEVEL) &&              \
+            LOG_SITE(LogLevel::LOG_INFO, burst, interval).allow())      \
+            log_me(LogLevel::LOG_INFO, __FILE__, __LINE__, __VA_ARGS__); \
+    } while (0)
+
+#define log_warn_limited(burst, interval, ...)                          \
+    do {                                                                \
+        if (static_cast<int>(LogLevel::LOG_WARN) >=                     \
+                static_cast<int>(AFTER_HOURS_LOG_LEVEL) &&              \
+            LOG_SITE(LogLevel::LOG_WARN, burst, interval).allow())      \
+            log_me(LogLevel::LOG_WARN, __FILE__, __LINE__, __VA_ARGS__); \
+    } while (0)
@@ -0,0 +1,361 @@
+// Macro crowd domain: hybrid continuum simulation for tiles the camera
+// cannot resolve (aggregate, flow, re-materialize).
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "afterhours/src/core/entity_helper.h"
+#include "afterhours/src/core/entity_query.h"
+#include "components.h"
+#include "entity_makers.h"
+#include "systems.h"
+#include "update_helpers.h"
+
+// Mean need intervals of an individual agent (see make_agent thresholds);
+// the continuum converts watchers into facility-seekers at these rates.
+static constexpr float MACRO_BATHROOM_INTERVAL = 60.f;
+static constexpr float MACRO_FOOD_INTERVAL = 82.5f;
+
+static constexpr int MACRO_DX[] = {1, -1, 0, 0};
+static constexpr int MACRO_DZ[] = {0, 0, 1, -1};
+
+static bool is_goal_tile(FacilityType want, TileType type) {
+    if (want == FacilityType::Stage) return type == TileType::StageFloor;
+    return type == facility_type_to_tile(want);
+}
+
+static bool is_fast_tile(TileType type) {
+    return type == TileType::Path || type == TileType::Gate ||
+           type == TileType::StageFloor || type == TileType::Bathroom ||
+           type == TileType::Food || type == TileType::MedTent;
+}
+
+// A tile may hold an aggregate population only while nobody can see its
+// individual agents: at Far LOD, or outside the visible region.
+static bool tile_unresolved(const VisibleRegion* vr, int x, int z) {
+    if (!vr) return false;
+    if (vr->lod == LODLevel::Far) return true;
+    return x < vr->min_x || x > vr->max_x || z < vr->min_z || z > vr->max_z;
+}
+
+// Multi-source BFS from every goal tile of each desire.
+static void rebuild_goal_fields(const Grid& grid, MacroCrowd& mc) {
+    std::vector<int> frontier;
+    frontier.reserve(MacroCrowd::NUM_TILES);
+    for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+        auto want = static_cast<FacilityType>(d);
+        auto& dist = mc.goal_dist[d];
+        dist.fill(MacroCrowd::UNREACHABLE);
+        frontier.clear();
+        for (int i = 0; i < MacroCrowd::NUM_TILES; i++) {
+            if (is_goal_tile(want, grid.tiles[i].type)) {
+                dist[i] = 0;
+                frontier.push_back(i);
+            }
+        }
+        for (size_t head = 0; head < frontier.size(); head++) {
+            int idx = frontier[head];
+            int x = idx % MAP_SIZE, z = idx / MAP_SIZE;
+            for (int k = 0; k < 4; k++) {
+                int nx = x + MACRO_DX[k], nz = z + MACRO_DZ[k];
+                if (!grid.in_bounds(nx, nz)) continue;
+                int nidx = grid.index(nx, nz);
+                if (dist[nidx] != MacroCrowd::UNREACHABLE) continue;
+                if (tile_blocks_movement(grid.tiles[nidx].type)) continue;
+                dist[nidx] = static_cast<uint16_t>(dist[idx] + 1);
+                frontier.push_back(nidx);
+            }
+        }
+    }
+}
+
+// Turn `count` aggregate agents on (x, z) back into entities.
+static void materialize(Grid& grid, int x, int z, FacilityType want,
+                        int count) {
+    for (int i = 0; i < count; i++) {
+        FacilityType w = want;
+        std::pair<int, int> target{-1, -1};
+        if (w != FacilityType::Stage) {
+            int best = INT_MAX;
+            for (auto [fx, fz] :
+                 grid.get_facility_positions(facility_type_to_tile(w))) {
+                int dist = std::abs(fx - x) + std::abs(fz - z);
+                if (dist < best) {
+                    best = dist;
+                    target = {fx, fz};
+                }
+            }
+            if (target.first < 0) w = FacilityType::Stage;
+        }
+        if (w == FacilityType::Stage) target = best_stage_spot(x, z);
+        make_agent(x, z, w, target.first, target.second);
+    }
+}
+
+// Populations are sums of whole absorbed agents moved around in fractions,
+// so they only round-trip to whole numbers up to float error.
+static constexpr float CONSERVE_EPS = 1e-3f;
+
+// Turn a tile's population back into entities: as many whole agents as
+// the tile holds in total, split by desire (largest remainders get the
+// extra agents). The fractional rest stays on the tile, in the desire
+// with the largest share left, so the crowd count is conserved.
+static int release_tile(Grid& grid, MacroCrowd& mc, int idx) {
+    auto& pop = mc.pop[idx];
+    float total = mc.tile_total(idx);
+    int whole = static_cast<int>(std::floor(total + CONSERVE_EPS));
+    std::array<int, Tile::NUM_DESIRES> n{};
+    int assigned = 0;
+    for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+        n[d] = static_cast<int>(std::max(0.f, pop[d]));
+        assigned += n[d];
+    }
+    for (; assigned < whole; assigned++) {
+        int best = 0;
+        for (int d = 1; d < Tile::NUM_DESIRES; d++) {
+            if (pop[d] - n[d] > pop[best] - n[best]) best = d;
+        }
+        n[best]++;
+    }
+
+    int x = idx % MAP_SIZE, z = idx / MAP_SIZE;
+    int rest_desire = 0;
+    float rest_share = -1.f;
+    for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+        if (n[d] > 0)
+            materialize(grid, x, z, static_cast<FacilityType>(d), n[d]);
+        if (pop[d] - n[d] > rest_share) {
+            rest_share = pop[d] - n[d];
+            rest_desire = d;
+        }
+    }
+    float rest = total - static_cast<float>(whole);
+    pop.fill(0.f);
+    if (rest > CONSERVE_EPS) pop[rest_desire] = rest;
+    return whole;
+}
+
+static void release_all(Grid& grid, MacroCrowd& mc) {
+    int spawned = 0;
+    for (int i = 0; i < MacroCrowd::NUM_TILES; i++) {
+        if (mc.tile_total(i) > 0.f) spawned += release_tile(grid, mc, i);
+    }
+
+    // Per-tile remainders add up to whole agents; spawn them on the tiles
+    // holding the largest shares
+    std::vector<int> rest;
+    float rest_total = 0.f;
+    for (int i = 0; i < MacroCrowd::NUM_TILES; i++) {
+        float t = mc.tile_total(i);
+        if (t <= 0.f) continue;
+        rest.push_back(i);
+        rest_total += t;
+    }
+    int extra = std::min(static_cast<int>(std::lround(rest_total)),
+                         static_cast<int>(rest.size()));
+    std::partial_sort(rest.begin(), rest.begin() + extra, rest.end(),
+                      [&](int a, int b) {
+                          return mc.tile_total(a) > mc.tile_total(b);
+                      });
+    for (int k = 0; k < extra; k++) {
+        int i = rest[k];
+        int d = static_cast<int>(
+            std::max_element(mc.pop[i].begin(), mc.pop[i].end()) -
+            mc.pop[i].begin());
+        materialize(grid, i % MAP_SIZE, i / MAP_SIZE,
+                    static_cast<FacilityType>(d), 1);
+    }
+    spawned += extra;
+
+    mc.clear();
+    if (spawned > 0) {
+        EntityHelper::merge_entity_arrays();
+        log_info("Hybrid sim: re-materialized all {} aggregate agents",
+                 spawned);
+    }
+}
+
+struct MacroCrowdSystem : System<> {
+    std::array<std::array<float, Tile::NUM_DESIRES>, MacroCrowd::NUM_TILES>
+        next{};
+    std::array<float, MacroCrowd::NUM_TILES> incoming{};
+
+    void once(float dt) override {
+        if (skip_game_logic()) return;
+        auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        if (!mc || !grid) return;
+
+        // Exodus and carryover bookkeeping work per agent, so the continuum
+        // hands everyone back before the gates open.
+        auto* clock = EntityHelper::get_singleton_cmp<GameClock>();
+        bool exodus = clock && clock->get_phase() == GameClock::Phase::Exodus;
+        if (!mc->enabled || exodus) {
+            release_all(*grid, *mc);
+            return;
+        }
+
+        mc->step_timer += dt;
+        if (mc->step_timer < MACRO_STEP) return;
+        float step = mc->step_timer;
+        mc->step_timer = 0.f;
+
+        auto* vr = EntityHelper::get_singleton_cmp<VisibleRegion>();
+        rebuild_goal_fields(*grid, *mc);
+        aggregate(*grid, *mc, vr);
+        flow(*grid, *mc, step);
+        release(*grid, *mc, vr);
+    }
+
+    // Absorb individual agents standing on dense, unresolved tiles.
+    void aggregate(Grid& grid, MacroCrowd& mc, const VisibleRegion* vr) {
+        int absorbed = 0;
+        auto agents = EntityQuery()
+                          .whereHasComponent<Agent>()
+                          .whereHasComponent<Transform>()
+                          .gen();
+        for (Entity& e : agents) {
+            if (!e.is_missing<BeingServiced>()) continue;
+            auto& tf = e.get<Transform>();
+            auto [gx, gz] = grid.world_to_grid(tf.position.x, tf.position.y);
+            if (!grid.in_bounds(gx, gz) || !tile_unresolved(vr, gx, gz))
+                continue;
+            int idx = grid.index(gx, gz);
+            if (!mc.active[idx] &&
+                grid.at(gx, gz).agent_count < MACRO_AGGREGATE_MIN)
+                continue;
+
+            mc.active[idx] = true;
+            int want = static_cast<int>(e.get<Agent>().want);
+            mc.pop[idx][want] += 1.f;
+            e.cleanup = true;
+            absorbed++;
+        }
+        if (absorbed > 0) EntityHelper::cleanup();
+    }
+
+    // One continuum step: each desire's population on an active tile moves
+    // a speed-proportional fraction to the neighbor closest to its goal,
+    // limited by the room left on that neighbor. Populations at their goal
+    // are served (facilities) or slowly develop needs (stage).
+    void flow(Grid& grid, MacroCrowd& mc, float step) {
+        auto* gs = EntityHelper::get_singleton_cmp<GameState>();
+        float speed_mult = gs ? gs->speed_multiplier : 1.f;
+        if (event_flags::rain_active) speed_mult *= 0.5f;
+        float need_mult = event_flags::heat_active ? 2.f : 1.f;
+
+        next = mc.pop;
+        incoming.fill(0.f);
+        float served = 0.f;
+
+        constexpr int STAGE = static_cast<int>(FacilityType::Stage);
+        constexpr int BATHROOM = static_cast<int>(FacilityType::Bathroom);
+        constexpr int FOOD = static_cast<int>(FacilityType::Food);
+
+        for (int idx = 0; idx < MacroCrowd::NUM_TILES; idx++) {
+            if (!mc.active[idx]) continue;
+            int x = idx % MAP_SIZE, z = idx / MAP_SIZE;
+            TileType type = grid.tiles[idx].type;
+            float speed = is_fast_tile(type) ? SPEED_PATH : SPEED_GRASS;
+            float frac = std::min(1.f, speed * speed_mult * step);
+
+            for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+                float p = mc.pop[idx][d];
+                if (p <= 0.f) continue;
+                auto want = static_cast<FacilityType>(d);
+
+                if (is_goal_tile(want, type)) {
+                    if (d == STAGE) {
+                        float to_bath = 0.f, to_food = 0.f;
+                        if (mc.goal_dist[BATHROOM][idx] !=
+                            MacroCrowd::UNREACHABLE)
+                            to_bath = p * need_mult * step /
+                                      MACRO_BATHROOM_INTERVAL;
+                        if (mc.goal_dist[FOOD][idx] != MacroCrowd::UNREACHABLE)
+                            to_food =
+                                p * need_mult * step / MACRO_FOOD_INTERVAL;
+                        next[idx][STAGE] -= to_bath + to_food;
+                        next[idx][BATHROOM] += to_bath;
+                        next[idx][FOOD] += to_food;
+                    } else {
+                        float done = std::min(p, p * step / SERVICE_TIME);
+                        next[idx][d] -= done;
+                        next[idx][STAGE] += done;
+                        served += done;
+                    }
+                    continue;
+                }
+
+                uint16_t here = mc.goal_dist[d][idx];
+                int best = -1;
+                uint16_t best_dist = here;
+                for (int k = 0; k < 4; k++) {
+                    int nx = x + MACRO_DX[k], nz = z + MACRO_DZ[k];
+                    if (!grid.in_bounds(nx, nz)) continue;
+                    int nidx = grid.index(nx, nz);
+                    if (mc.goal_dist[d][nidx] < best_dist) {
+                        best_dist = mc.goal_dist[d][nidx];
+                        best = nidx;
+                    }
+                }
+                if (best < 0) continue;
+
+                float room = MACRO_TILE_CAPACITY -
+                             static_cast<float>(grid.tiles[best].agent_count) -
+                             incoming[best];
+                float amount = std::min(p * frac, std::max(0.f, room));
+                if (amount <= 0.f) continue;
+                next[idx][d] -= amount;
+                next[best][d] += amount;
+                incoming[best] += amount;
+            }
+        }
+
+        mc.pop = next;
+
+        mc.served_carry += served;
+        int whole = static_cast<int>(mc.served_carry);
+        if (whole > 0 && gs) {
+            gs->total_agents_served += whole;
+            mc.served_carry -= static_cast<float>(whole);
+        }
+    }
+
+    // Hand populations back to individual agents where the camera can see
+    // them, where they thinned out, or where flow spilled onto a tile that
+    // is not aggregated.
+    void release(Grid& grid, MacroCrowd& mc, const VisibleRegion* vr) {
+        int spawned = 0;
+        for (int idx = 0; idx < MacroCrowd::NUM_TILES; idx++) {
+            float total = mc.tile_total(idx);
+            if (total <= 0.f) {
+                mc.active[idx] = false;
+                continue;
+            }
+            int x = idx % MAP_SIZE, z = idx / MAP_SIZE;
+            bool unresolved = tile_unresolved(vr, x, z);
+
+            if (mc.active[idx]) {
+                if (unresolved && total >= MACRO_RELEASE_BELOW) continue;
+                spawned += release_tile(grid, mc, idx);
+                mc.active[idx] = false;
+                continue;
+            }
+
+            // Spill-over onto an inactive tile: join the aggregate if the
+            // tile qualifies, otherwise spawn whole agents and keep the
+            // fractional remainder for the next step.
+            int individuals = grid.tiles[idx].agent_count;
+            if (unresolved && total + individuals >= MACRO_AGGREGATE_MIN) {
+                mc.active[idx] = true;
+                continue;
+            }
+            if (total + CONSERVE_EPS >= 1.f)
+                spawned += release_tile(grid, mc, idx);
+        }
+        if (spawned > 0) EntityHelper::merge_entity_arrays();
+    }
+};
+
+void register_macro_crowd_systems(SystemManager& sm) {
+    sm.register_update_system(timed<MacroCrowdSystem>());
+}
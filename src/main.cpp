@@ -1,18 +1,31 @@
 
 #include <argh.h>
 
+#include <chrono>
+#include <fstream>
+
 #include "audio.h"
+#include "autosave.h"
+#include "engine/parallel.h"
 #include "entity_makers.h"
+#include "frame_pacing.h"
 #include "game.h"
 #include "gfx3d.h"
 #include "mcp_integration.h"
+#include "state_stream.h"
 #include "render_helpers.h"
+#include "replay.h"
+#include "save_system.h"
 #include "systems.h"
+#include "testing/parallel_runner.h"
 
 #include "afterhours/src/plugins/e2e_testing/e2e_testing.h"
 #include "afterhours/src/plugins/e2e_testing/test_input.h"
 
 bool g_test_mode = false;
+float g_fixed_dt = 0.f;
+float g_fast_step = 0.f;
+bool g_update_golden = false;
 
 using namespace afterhours;
 namespace gfx = afterhours::graphics;
@@ -20,6 +33,7 @@ namespace gfx = afterhours::graphics;
 gfx::RenderTextureType g_render_texture;
 
 int main(int argc, char* argv[]) {
+    auto launch = std::chrono::steady_clock::now();
     argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
 
     bool mcp_mode = cmdl[{"--mcp"}];
@@ -31,6 +45,80 @@ int main(int argc, char* argv[]) {
     std::string test_dir;
     cmdl("--test-dir") >> test_dir;
 
+    // Parallel runner: --test-dir with --jobs N runs each script in its own
+    // headless child process and exits with the aggregate result
+    int jobs = 0;
+    cmdl("--jobs", 0) >> jobs;
+    if (jobs > 0 && !test_dir.empty()) {
+        e2e_parallel::Options opt;
+        opt.exe = argv[0];
+        opt.test_dir = test_dir;
+        opt.jobs = jobs;
+        cmdl("--test-timeout", opt.timeout) >> opt.timeout;
+        cmdl("--junit") >> opt.junit_path;
+        cmdl("--e2e-work-dir", opt.work_dir) >> opt.work_dir;
+        // Simulation settings every child inherits from this invocation
+        for (const char* flag : {"--threads", "--fixed-dt"}) {
+            std::string value;
+            if (cmdl(flag) >> value) {
+                opt.child_args.push_back(flag);
+                opt.child_args.push_back(value);
+            }
+        }
+        if (cmdl[{"--sync-log"}]) opt.child_args.push_back("--sync-log");
+        return e2e_parallel::run(opt);
+    }
+
+    // Hidden window, and simulated frame time with no FPS cap
+    bool headless = cmdl[{"--headless"}];
+    // Written when the test script runs to its end: "PASS" or "FAIL"
+    std::string result_file;
+    cmdl("--result-file") >> result_file;
+    bool fast = cmdl[{"--fast"}];
+    if (fast) g_fast_step = 1.f / 60.f;
+
+    std::string save_dir;
+    if (cmdl("--save-dir") >> save_dir) save::set_save_dir(save_dir);
+    // Synthesized SFX and music, keyed by their generation parameters
+    audio_synth::set_cache_dir(save::save_dir() + "/audio_cache");
+
+    // Logging is formatted and written on a background thread; --sync-log
+    // writes every line on the calling thread (debugging crashes)
+    if (cmdl[{"--sync-log"}]) log_set_async(false);
+
+    // Worker threads for parallel simulation kernels (1 = single-threaded)
+    int threads = 1;
+    cmdl("--threads", 1) >> threads;
+    parallel::set_worker_count(threads);
+
+    // Fixed simulation step for reproducible runs (0 = real frame time)
+    cmdl("--fixed-dt", 0.f) >> g_fixed_dt;
+    g_update_golden = cmdl[{"--update-golden"}];
+
+    // Replays: record this session to a file, or play one back
+    std::string record_replay_path, replay_path;
+    cmdl("--record-replay") >> record_replay_path;
+    cmdl("--replay") >> replay_path;
+
+    // Binary state stream for MCP tooling (see state_stream.h)
+    std::string stream_path;
+    cmdl("--state-stream") >> stream_path;
+    if (!stream_path.empty()) {
+        state_stream::Subscription sub;
+        std::string planes;
+        if (cmdl("--stream-planes") >> planes) {
+            sub.planes = state_stream::parse_planes(planes);
+            if (sub.planes == 0) {
+                log_warn("Unknown --stream-planes '{}', streaming all",
+                         planes);
+                sub.planes = state_stream::ALL_PLANES;
+            }
+        }
+        cmdl("--stream-every", 1) >> sub.every;
+        state_stream::subscribe(sub);
+        state_stream::open(stream_path);
+    }
+
     if (mcp_mode) {
         gfx::set_trace_log_level(7);  // LOG_NONE
         g_log_to_stderr = true;
@@ -45,16 +133,47 @@ int main(int argc, char* argv[]) {
         gfx::set_trace_log_level(7);
     }
 
+    // Background autosave; off in test runs (--test-mode or --test-dir)
+    // unless asked for
+    float autosave_interval =
+        g_test_mode ? 0.f : autosave::DEFAULT_INTERVAL;
+    int autosave_keep = autosave::DEFAULT_KEEP;
+    cmdl("--autosave-interval", autosave_interval) >> autosave_interval;
+    cmdl("--autosave-keep", autosave_keep) >> autosave_keep;
+    autosave::configure(autosave_interval, autosave_keep);
+
+    // Frame pacing: interactive play follows the display and idles when
+    // nothing moves; test and MCP runs draw only when something asks
+    frame_pacing::Config pacing;
+    if (g_test_mode || mcp_mode) {
+        pacing.mode = frame_pacing::Mode::OnDemand;
+        pacing.fps = 500;
+    }
+    if (fast) pacing.fps = frame_pacing::UNCAPPED;
+    std::string pacing_mode;
+    if (cmdl("--frame-pacing") >> pacing_mode) {
+        if (auto mode = frame_pacing::parse_mode(pacing_mode))
+            pacing.mode = *mode;
+        else
+            log_warn("Unknown --frame-pacing '{}'", pacing_mode);
+    }
+    cmdl("--fps", pacing.fps) >> pacing.fps;
+    cmdl("--idle-fps", pacing.idle_fps) >> pacing.idle_fps;
+    frame_pacing::configure(pacing);
+
     log_info("Starting Endless Dance Chaos v{}", VERSION);
 
     SystemManager systems;
     testing::E2ERunner runner;
+    float last_dt = 0.f;
+    int exit_code = 0;  // 1 when a test script failed
 
     gfx::RunConfig cfg;
     cfg.width = DEFAULT_SCREEN_WIDTH;
     cfg.height = DEFAULT_SCREEN_HEIGHT;
     cfg.title = "Endless Dance Chaos";
-    cfg.target_fps = 500;
+    // Starting cap; on raylib frame_pacing adjusts it as the game idles
+    cfg.target_fps = std::max(pacing.fps, 0);
 
     cfg.init = [&]() {
         gfx::set_exit_key(0);
@@ -76,8 +195,24 @@ int main(int argc, char* argv[]) {
         make_sophie();
         EntityHelper::merge_entity_arrays();
 
+        // Headless tick for replay seeks: update systems only
+        replay::set_step_fn([&](float step_dt) {
+            systems.tick_all(EntityHelper::get_entities_for_mod(), step_dt);
+            EntityHelper::merge_entity_arrays();
+        });
+        if (!replay_path.empty()) {
+            if (!replay::load_file(replay_path))
+                log_warn("Could not load replay {}", replay_path);
+        } else if (!record_replay_path.empty()) {
+            replay::start_recording();
+        }
+
+        // Frames drawn outside the loop (screenshots after skipped frames)
+        frame_pacing::set_render_fn([&]() { systems.render_all(last_dt); });
+
         auto setup_screenshot_callback = [&]() {
             runner.set_screenshot_callback([](const std::string& name) {
+                frame_pacing::render_now();
                 std::filesystem::create_directories("tests/e2e/screenshots");
                 std::string path = "tests/e2e/screenshots/" + name + ".png";
 #ifdef AFTER_HOURS_USE_METAL
@@ -106,7 +241,15 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    bool first_frame = true;
     cfg.frame = [&]() {
+        if (first_frame) {
+            first_frame = false;
+            log_info("Startup: first frame after {:.1f} ms",
+                     std::chrono::duration<float, std::milli>(
+                         std::chrono::steady_clock::now() - launch)
+                         .count());
+        }
         if (g_test_mode) {
             afterhours::testing::test_input::reset_frame();
         }
@@ -114,15 +257,36 @@ int main(int argc, char* argv[]) {
         bool escape_should_quit =
             gfx::is_key_pressed(KEY_ESCAPE) && should_escape_quit();
 
-        float dt = gfx::get_frame_time();
-        systems.run(dt);
+        replay::service_seek();
+        float step = g_fixed_dt > 0.f ? g_fixed_dt : g_fast_step;
+        // Not gfx::get_frame_time(): it is stale after skipped frames
+        float real_dt = frame_pacing::frame_dt();
+        float dt = step > 0.f ? step : real_dt;
+        dt = replay::playback_dt(dt);
+        last_dt = dt;
+        if (frame_pacing::should_render(dt)) {
+            systems.run(dt);
+            frame_pacing::mark_rendered();
+        } else {
+            systems.tick_all(EntityHelper::get_entities_for_mod(), dt);
+            // Normally cleared by the render pass
+            mcp_integration::clear_frame_state();
+            frame_pacing::mark_updated();
+        }
 
         if (g_test_mode && runner.has_commands()) {
             runner.tick(dt);
             EntityHelper::merge_entity_arrays();
+            // Commands other than waits may read the screen next frame
+            if (e2e_command_pending()) frame_pacing::render_now();
 
             if (runner.is_finished()) {
                 runner.print_results();
+                if (runner.has_failed()) exit_code = 1;
+                if (!result_file.empty()) {
+                    std::ofstream(result_file)
+                        << (exit_code == 0 ? "PASS" : "FAIL") << "\n";
+                }
                 gfx::request_quit();
             }
         }
@@ -130,17 +294,29 @@ int main(int argc, char* argv[]) {
         if (escape_should_quit) {
             gfx::request_quit();
         }
+        frame_pacing::end_frame();
     };
 
     cfg.cleanup = [&]() {
         mcp_integration::shutdown();
+        state_stream::close();
+        autosave::shutdown();
+        if (!record_replay_path.empty() && replay::length() > 0) {
+            replay::write_file(record_replay_path);
+        }
         get_audio().shutdown();
         afterhours::CloseAudioDevice();
         unload_render_texture(g_render_texture);
+        parallel::shutdown();
     };
 
+#ifdef AFTER_HOURS_USE_RAYLIB
+    // Must precede InitWindow (inside run) or the window flashes up first
+    if (headless) raylib::SetConfigFlags(raylib::FLAG_WINDOW_HIDDEN);
+#endif
     gfx::run(cfg);
 
     log_info("Goodbye!");
-    return 0;
+    log_flush();
+    return exit_code;
 }
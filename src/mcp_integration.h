@@ -9,10 +9,16 @@
 #include <afterhours/src/plugins/input_system.h>
 #include <afterhours/src/plugins/mcp_server.h>
 
+#include <algorithm>
 #include <set>
 #include <sstream>
 
+#include "afterhours/src/core/entity_helper.h"
+#include "components.h"
+#include "density_history.h"
+#include "frame_pacing.h"
 #include "game.h"
+#include "state_stream.h"
 
 namespace mcp_integration {
 
@@ -39,10 +45,67 @@ inline std::pair<int, int> get_screen_size() {
     return {DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT};
 }
 
+// Tiles forecast to go critical within FORECAST_HORIZON, soonest first
+inline void dump_crush_forecast(std::ostringstream& ss, int max_tiles = 16) {
+    auto* cf = afterhours::EntityHelper::get_singleton_cmp<CrushForecast>();
+    auto* grid = afterhours::EntityHelper::get_singleton_cmp<Grid>();
+    if (!cf || !grid) return;
+
+    std::vector<std::pair<float, int>> soon;
+    for (int idx : cf->tracked) {
+        float ttc = cf->time_to_critical(idx);
+        if (ttc >= 0.f && ttc < FORECAST_HORIZON) soon.push_back({ttc, idx});
+    }
+    std::sort(soon.begin(), soon.end());
+    soon.erase(std::unique(soon.begin(), soon.end()), soon.end());
+
+    ss << "Crush Forecast (" << soon.size() << " tiles):\n";
+    int shown = 0;
+    for (auto [ttc, idx] : soon) {
+        if (shown++ >= max_tiles) break;
+        ss << "  (" << idx % MAP_SIZE << "," << idx / MAP_SIZE
+           << ") eta=" << ttc << "s count=" << grid->tiles[idx].agent_count
+           << " in=" << cf->inflow[idx] << " out=" << cf->outflow[idx]
+           << "\n";
+    }
+}
+
+// History stats plus the tiles that peaked highest over the whole run
+inline void dump_density_history(std::ostringstream& ss, int max_tiles = 8) {
+    auto st = density_history::stats();
+    ss << "Density History: samples=" << st.samples
+       << " frames=" << st.frames << " blocks=" << st.blocks
+       << " bytes=" << st.bytes << " merges=" << st.merges << " span=["
+       << st.oldest << "s, " << st.newest << "s]\n";
+
+    density_history::Window w;
+    if (!density_history::query_all(w)) return;
+    std::vector<std::pair<int, int>> peaks;
+    for (int i = 0; i < density_history::NUM_TILES; i++) {
+        if (w.max[i] > 0) peaks.push_back({-(int) w.max[i], i});
+    }
+    int n = std::min((int) peaks.size(), max_tiles);
+    std::partial_sort(peaks.begin(), peaks.begin() + n, peaks.end());
+    for (int k = 0; k < n; k++) {
+        int idx = peaks[k].second;
+        ss << "  (" << idx % MAP_SIZE << "," << idx / MAP_SIZE
+           << ") peak=" << (int) w.max[idx] << " mean=" << w.mean[idx]
+           << "\n";
+    }
+}
+
 inline std::string dump_ui_tree() {
     std::ostringstream ss;
     ss << "UI Tree Dump:\n";
     ss << "  (No UI components registered yet)\n";
+    dump_crush_forecast(ss);
+    dump_density_history(ss);
+    if (state_stream::is_open()) {
+        const auto& st = state_stream::stats();
+        ss << "State Stream: frames=" << st.frames_queued
+           << " skipped=" << st.ticks_skipped << " bytes=" << st.bytes_written
+           << " queued=" << st.queued_bytes << "\n";
+    }
     return ss.str();
 }
 
@@ -50,17 +113,23 @@ inline afterhours::mcp::MCPConfig create_config() {
     afterhours::mcp::MCPConfig config;
 
     config.get_screen_size = get_screen_size;
-    config.capture_screenshot = capture_screenshot;
+    // Draw first if frames were skipped since the last one
+    config.capture_screenshot = []() {
+        frame_pacing::render_now();
+        return capture_screenshot();
+    };
     config.dump_ui_tree = dump_ui_tree;
 
     config.mouse_move = [](int x, int y) {
         mouse_position = {static_cast<float>(x), static_cast<float>(y)};
+        frame_pacing::request_redraw();
     };
 
     config.mouse_click = [](int x, int y, int button) {
         mouse_position = {static_cast<float>(x), static_cast<float>(y)};
         mouse_clicked = true;
         mouse_button_clicked = button;
+        frame_pacing::request_redraw();
     };
 
     config.key_down = [](int keycode) {
@@ -68,11 +137,13 @@ inline afterhours::mcp::MCPConfig create_config() {
             keys_pressed_this_frame.insert(keycode);
         }
         keys_down.insert(keycode);
+        frame_pacing::request_redraw();
     };
 
     config.key_up = [](int keycode) {
         keys_down.erase(keycode);
         keys_released_this_frame.insert(keycode);
+        frame_pacing::request_redraw();
     };
 
     return config;
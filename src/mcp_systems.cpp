@@ -1,7 +1,9 @@
 #include "mcp_integration.h"
 #include "render_helpers.h"
 #include "rl.h"
+#include "state_stream.h"
 #include "systems.h"
+#include "update_helpers.h"
 
 namespace gfx = afterhours::graphics;
 
@@ -14,6 +16,14 @@ struct MCPUpdateSystem : System<> {
     }
 };
 
+// Encode one state-stream frame per sim tick (no-op unless opened)
+struct MCPStateStreamSystem : System<> {
+    void once(float) override {
+        if (!state_stream::is_open() || skip_game_logic()) return;
+        state_stream::tick();
+    }
+};
+
 struct MCPRenderUISystem : System<> {
     void once(float) const override {
         if (mcp_integration::is_enabled()) {
@@ -27,10 +37,11 @@ struct MCPClearFrameSystem : System<> {
 };
 
 void register_mcp_update_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<MCPUpdateSystem>());
+    sm.register_update_system(timed<MCPUpdateSystem>());
+    sm.register_update_system(timed<MCPStateStreamSystem>());
 }
 
 void register_mcp_render_systems(SystemManager& sm) {
-    sm.register_render_system(std::make_unique<MCPRenderUISystem>());
-    sm.register_render_system(std::make_unique<MCPClearFrameSystem>());
+    sm.register_render_system(timed<MCPRenderUISystem>());
+    sm.register_render_system(timed<MCPClearFrameSystem>());
 }
@@ -41,6 +41,7 @@ static void create_nuxes() {
     auto make_nux = [&](const char* text, std::function<bool()> trigger,
                         std::function<bool()> complete) {
         Entity& e = EntityHelper::createEntity();
+        telemetry::bump(telemetry::EntitiesCreated);
         e.addComponent<NuxHint>();
         auto& nux = e.get<NuxHint>();
         nux.text = text;
@@ -238,7 +239,7 @@ struct UpdateDeathMarkersSystem : System<DeathMarker> {
 };
 
 void register_polish_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<NuxSystem>());
-    sm.register_update_system(std::make_unique<BottleneckCheckSystem>());
-    sm.register_update_system(std::make_unique<UpdateDeathMarkersSystem>());
+    sm.register_update_system(timed<NuxSystem>());
+    sm.register_update_system(timed<BottleneckCheckSystem>());
+    sm.register_update_system(timed<UpdateDeathMarkersSystem>());
 }
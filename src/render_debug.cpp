@@ -1,4 +1,4 @@
-// Render domain: debug panel with tuning sliders.
+// Render domain: debug panel with tuning sliders and hot-path telemetry.
 #define AFTER_HOURS_REPLACE_LOGGING
 #include "log.h"
 
@@ -7,6 +7,7 @@
 #include "components.h"
 #include "render_helpers.h"
 #include "systems.h"
+#include "telemetry.h"
 
 // Debug panel with sliders for tuning
 struct RenderDebugPanelSystem : System<> {
@@ -90,13 +91,100 @@ struct RenderDebugPanelSystem : System<> {
 
         int agent_count =
             (int) EntityQuery().whereHasComponent<Agent>().gen_count();
+        auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+        int macro_count = mc ? mc->total_agents() : 0;
         std::string info =
-            fmt::format("Agents: {}  Deaths: {}", agent_count, gs->death_count);
+            macro_count > 0
+                ? fmt::format("Agents: {} (+{} aggregate)  Deaths: {}",
+                              agent_count, macro_count, gs->death_count)
+                : fmt::format("Agents: {}  Deaths: {}", agent_count,
+                              gs->death_count);
         draw_text_ex(get_font(), info.c_str(), {sx, py + 200}, 16, FONT_SPACING,
                      Color{160, 160, 160, 255});
+
+        draw_telemetry(px + pw + 10);
+    }
+
+    // Scratch for history copies, reused every frame
+    std::vector<float> series;
+
+    // Polyline of `values` scaled to [0, top] inside the box
+    static void draw_sparkline(const std::vector<float>& values, float x,
+                               float y, float w, float h, float top,
+                               Color color) {
+        draw_rect(x, y, w, h, Color{30, 30, 40, 255});
+        if (values.size() < 2 || top <= 0.f) return;
+        float step = w / (float) (telemetry::HISTORY - 1);
+        float x0 = x + w - step * (float) (values.size() - 1);
+        auto y_of = [&](float v) {
+            return y + h - std::min(v / top, 1.f) * h;
+        };
+        for (size_t i = 1; i < values.size(); i++) {
+            draw_line(x0 + step * (float) (i - 1), y_of(values[i - 1]),
+                      x0 + step * (float) i, y_of(values[i]), color);
+        }
+    }
+
+    // Per-tick counters as sparklines, then frame time and its histogram
+    void draw_telemetry(float px) {
+        constexpr float ROW_H = 24.f;
+        constexpr float SPARK_W = 120.f;
+        constexpr float HIST_H = 40.f;
+        float pw = 340;
+        float rows_h = ROW_H * (float) telemetry::NUM_COUNTERS;
+        float ph = 40 + rows_h + 40 + HIST_H + 30;
+        float py = DEFAULT_SCREEN_HEIGHT - 54 - ph - 10;
+
+        draw_rect(px, py, pw, ph, Color{15, 15, 25, 230});
+        draw_rect_lines(px, py, pw, ph, Color{100, 100, 120, 255});
+        draw_text_ex(get_font(), "Per tick (last / avg)", {px + 10, py + 8},
+                     18, FONT_SPACING, Color{255, 200, 80, 255});
+
+        float spark_x = px + pw - SPARK_W - 12;
+        float y = py + 36;
+        for (int c = 0; c < telemetry::NUM_COUNTERS; c++) {
+            auto counter = (telemetry::Counter) c;
+            auto st = telemetry::stats(counter);
+            std::string row =
+                fmt::format("{} {} / {:.1f}", telemetry::counter_name(counter),
+                            st.last, st.mean);
+            draw_text_ex(get_font(), row.c_str(), {px + 12, y}, 14,
+                         FONT_SPACING, Color{190, 190, 190, 255});
+            telemetry::history(counter, series);
+            draw_sparkline(series, spark_x, y, SPARK_W, ROW_H - 8,
+                           (float) st.peak, Color{80, 200, 140, 255});
+            y += ROW_H;
+        }
+
+        telemetry::frame_history(series);
+        std::string frame =
+            fmt::format("frame ms p50 {:.1f}  p99 {:.1f}",
+                        telemetry::frame_percentile(0.5f),
+                        telemetry::frame_percentile(0.99f));
+        draw_text_ex(get_font(), frame.c_str(), {px + 12, y + 4}, 14,
+                     FONT_SPACING, Color{190, 190, 190, 255});
+        draw_sparkline(series, spark_x, y + 4, SPARK_W, ROW_H - 8, 50.f,
+                       Color{255, 200, 80, 255});
+        y += 36;
+
+        // Histogram bars, normalized to the fullest bucket
+        const auto& buckets = telemetry::frame_histogram();
+        uint64_t most = *std::max_element(buckets.begin(), buckets.end());
+        float bar_w = (pw - 24) / (float) telemetry::NUM_FRAME_BUCKETS;
+        for (int i = 0; i < telemetry::NUM_FRAME_BUCKETS; i++) {
+            float bh = most ? HIST_H * (float) buckets[i] / (float) most : 0;
+            bool slow = i >= 4;  // over the 16.7ms budget
+            draw_rect(px + 12 + bar_w * i + 1, y + HIST_H - bh, bar_w - 2, bh,
+                      slow ? Color{220, 90, 80, 255}
+                           : Color{80, 140, 220, 255});
+        }
+        draw_text_ex(get_font(), "<4ms", {px + 12, y + HIST_H + 4}, 12,
+                     FONT_SPACING, Color{140, 140, 140, 255});
+        draw_text_ex(get_font(), ">100ms", {px + pw - 56, y + HIST_H + 4}, 12,
+                     FONT_SPACING, Color{140, 140, 140, 255});
     }
 };
 
 void register_render_debug_systems(SystemManager& sm) {
-    sm.register_render_system(std::make_unique<RenderDebugPanelSystem>());
+    sm.register_render_system(timed<RenderDebugPanelSystem>());
 }
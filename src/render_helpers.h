@@ -129,3 +129,29 @@ inline Color tile_color(TileType type, float night_t) {
     int idx = static_cast<int>(type);
     return lerp_color(TILE_DAY_COLORS[idx], TILE_NIGHT_COLORS[idx], night_t);
 }
+
+// Desire pip colors, indexed by Tile::desire_counts slot
+inline constexpr Color DESIRE_COLORS[] = {
+    {126, 207, 192, 255},  // Bathroom
+    {244, 164, 164, 255},  // Food
+    {255, 217, 61, 255},   // Stage
+    {68, 136, 170, 255},   // Exit/Gate
+    {255, 100, 100, 255},  // MedTent
+};
+
+// Heat ramp for density / MAX_AGENTS_PER_TILE: yellow -> orange -> red
+inline Color density_color(float density_ratio) {
+    if (density_ratio < 0.50f) {
+        float t = density_ratio / 0.50f;
+        return Color{255, 255, 0, static_cast<unsigned char>(t * 180)};
+    } else if (density_ratio < 0.75f) {
+        float t = (density_ratio - 0.50f) / 0.25f;
+        return Color{255, static_cast<unsigned char>(255 - t * 90), 0, 180};
+    } else if (density_ratio < 0.90f) {
+        float t = (density_ratio - 0.75f) / 0.15f;
+        return Color{255, static_cast<unsigned char>(165 - t * 165), 0, 200};
+    } else {
+        float t = std::min((density_ratio - 0.90f) / 0.10f, 1.0f);
+        return Color{static_cast<unsigned char>(255 - t * 255), 0, 0, 220};
+    }
+}
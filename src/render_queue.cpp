@@ -0,0 +1,251 @@
+// Render queue domain: per-frame command buffer for the 3D world pass,
+// sorted into opaque / overlay / translucent passes and drawn in runs.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "render_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace render_queue {
+
+namespace {
+
+enum class Prim : uint8_t { Cube, Plane, Cylinder, Sphere, Line, Count };
+constexpr size_t NUM_PRIMS = static_cast<size_t>(Prim::Count);
+
+struct Command {
+    Prim prim = Prim::Cube;
+    Color color{};
+    int slices = 0;            // cylinder
+    unsigned int texture = 0;  // overlay plane
+    float depth = 0.f;         // along the view axis, translucent only
+    uint32_t seq = 0;          // submission index, translucent only
+    vec3 a{};  // cube/plane/sphere center, cylinder base, line start
+    vec3 b{};  // cube w/h/l, plane x/-/z, cylinder r_top/r_bottom/height,
+               // sphere radius/-/-, line end
+};
+
+struct Queue {
+    // Opaque commands are already grouped by bucketing on the primitive
+    std::array<std::vector<Command>, NUM_PRIMS> opaque;
+    std::vector<Command> overlay;
+    std::vector<Command> translucent;
+    Stats stats;
+};
+
+Queue& queue() {
+    static Queue q;
+    return q;
+}
+
+void push(const Command& cmd) {
+    auto& q = queue();
+    if (cmd.color.a == 255)
+        q.opaque[static_cast<size_t>(cmd.prim)].push_back(cmd);
+    else {
+        q.translucent.push_back(cmd);
+        q.translucent.back().seq = (uint32_t) (q.translucent.size() - 1);
+    }
+}
+
+#ifdef AFTER_HOURS_USE_RAYLIB
+// Top and side faces as corner signs (the bottom is never seen from the
+// isometric camera), wound like raylib's DrawCube
+constexpr int8_t CUBE_FACES[5][4][3] = {
+    {{-1, 1, -1}, {-1, 1, 1}, {1, 1, 1}, {1, 1, -1}},
+    {{-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}},
+    {{-1, -1, -1}, {-1, 1, -1}, {1, 1, -1}, {1, -1, -1}},
+    {{1, -1, -1}, {1, 1, -1}, {1, 1, 1}, {1, -1, 1}},
+    {{-1, -1, -1}, {-1, -1, 1}, {-1, 1, 1}, {-1, 1, -1}},
+};
+constexpr int VERTS_PER_CUBE = 5 * 4;
+constexpr int VERTS_PER_PLANE = 4;
+
+// Quads per rlBegin; keeps each batch-limit check small
+constexpr size_t QUAD_CHUNK = 256;
+
+void emit_cube(const Command& c) {
+    float hw = c.b.x * 0.5f, hh = c.b.y * 0.5f, hl = c.b.z * 0.5f;
+    raylib::rlColor4ub(c.color.r, c.color.g, c.color.b, c.color.a);
+    for (const auto& face : CUBE_FACES) {
+        for (const auto& v : face) {
+            raylib::rlVertex3f(c.a.x + v[0] * hw, c.a.y + v[1] * hh,
+                               c.a.z + v[2] * hl);
+        }
+    }
+}
+
+// Same corners and uv as raylib's DrawPlane
+void emit_plane(const Command& c) {
+    float x0 = c.a.x - c.b.x * 0.5f, x1 = c.a.x + c.b.x * 0.5f;
+    float z0 = c.a.z - c.b.z * 0.5f, z1 = c.a.z + c.b.z * 0.5f;
+    raylib::rlColor4ub(c.color.r, c.color.g, c.color.b, c.color.a);
+    raylib::rlNormal3f(0.f, 1.f, 0.f);
+    raylib::rlTexCoord2f(0.f, 0.f);
+    raylib::rlVertex3f(x0, c.a.y, z0);
+    raylib::rlTexCoord2f(0.f, 1.f);
+    raylib::rlVertex3f(x0, c.a.y, z1);
+    raylib::rlTexCoord2f(1.f, 1.f);
+    raylib::rlVertex3f(x1, c.a.y, z1);
+    raylib::rlTexCoord2f(1.f, 0.f);
+    raylib::rlVertex3f(x1, c.a.y, z0);
+}
+#endif
+
+void draw_one(const Command& c) {
+    switch (c.prim) {
+        case Prim::Cube:
+            draw_cube(c.a, c.b.x, c.b.y, c.b.z, c.color);
+            break;
+        case Prim::Plane:
+            draw_plane(c.a, {c.b.x, c.b.z}, c.color);
+            break;
+        case Prim::Cylinder:
+            draw_cylinder(c.a, c.b.x, c.b.y, c.b.z, c.slices, c.color);
+            break;
+        case Prim::Sphere:
+            draw_sphere(c.a, c.b.x, c.color);
+            break;
+        case Prim::Line:
+            draw_line_3d(c.a, c.b, c.color);
+            break;
+        case Prim::Count:
+            break;
+    }
+}
+
+// Commands [first, first + n) share primitive and texture
+void draw_run(const Command* first, size_t n) {
+#ifdef AFTER_HOURS_USE_RAYLIB
+    Prim prim = first->prim;
+    if (prim == Prim::Cube || prim == Prim::Plane) {
+        int verts = prim == Prim::Cube ? VERTS_PER_CUBE : VERTS_PER_PLANE;
+        raylib::rlSetTexture(first->texture);
+        for (size_t start = 0; start < n; start += QUAD_CHUNK) {
+            size_t end = std::min(n, start + QUAD_CHUNK);
+            raylib::rlCheckRenderBatchLimit((int) (end - start) * verts);
+            raylib::rlBegin(RL_QUADS);
+            for (size_t i = start; i < end; i++) {
+                if (prim == Prim::Cube)
+                    emit_cube(first[i]);
+                else
+                    emit_plane(first[i]);
+            }
+            raylib::rlEnd();
+        }
+        raylib::rlSetTexture(0);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) draw_one(first[i]);
+}
+
+// Split `cmds` into maximal same-state runs, in order
+void draw_runs(const std::vector<Command>& cmds, Stats& stats) {
+    size_t i = 0;
+    while (i < cmds.size()) {
+        size_t j = i + 1;
+        while (j < cmds.size() && cmds[j].prim == cmds[i].prim &&
+               cmds[j].texture == cmds[i].texture)
+            j++;
+        draw_run(&cmds[i], j - i);
+        stats.commands += j - i;
+        stats.runs++;
+        i = j;
+    }
+}
+
+}  // namespace
+
+void cube(vec3 center, float w, float h, float l, Color color) {
+    push({.prim = Prim::Cube, .color = color, .a = center, .b = {w, h, l}});
+}
+
+void plane(vec3 center, vec2 size, Color color) {
+    push({.prim = Prim::Plane,
+          .color = color,
+          .a = center,
+          .b = {size.x, 0.f, size.y}});
+}
+
+void cylinder(vec3 base, float radius_top, float radius_bottom, float height,
+              int slices, Color color) {
+    push({.prim = Prim::Cylinder,
+          .color = color,
+          .slices = slices,
+          .a = base,
+          .b = {radius_top, radius_bottom, height}});
+}
+
+void sphere(vec3 center, float radius, Color color) {
+    push({.prim = Prim::Sphere,
+          .color = color,
+          .a = center,
+          .b = {radius, 0.f, 0.f}});
+}
+
+void line(vec3 from, vec3 to, Color color) {
+    push({.prim = Prim::Line, .color = color, .a = from, .b = to});
+}
+
+void overlay(vec3 center, vec2 size, Color color, unsigned int texture) {
+    queue().overlay.push_back({.prim = Prim::Plane,
+                               .color = color,
+                               .texture = texture,
+                               .a = center,
+                               .b = {size.x, 0.f, size.y}});
+}
+
+void flush(const Camera3D& camera) {
+    auto& q = queue();
+    Stats stats;
+
+    for (const auto& cmds : q.opaque) draw_runs(cmds, stats);
+
+    if (!q.overlay.empty()) {
+#ifdef AFTER_HOURS_USE_RAYLIB
+        raylib::rlDrawRenderBatchActive();
+        raylib::rlDisableDepthMask();
+#endif
+        draw_runs(q.overlay, stats);
+#ifdef AFTER_HOURS_USE_RAYLIB
+        raylib::rlDrawRenderBatchActive();
+        raylib::rlEnableDepthMask();
+#endif
+    }
+
+    // Back to front; ties fall back to submission order so coplanar
+    // layers of one system still stack the way they were queued (the key
+    // is unique, so std::sort suffices and needs no scratch buffer)
+    vec3 fwd = {camera.target.x - camera.position.x,
+                camera.target.y - camera.position.y,
+                camera.target.z - camera.position.z};
+    for (auto& c : q.translucent) {
+        c.depth = (c.a.x - camera.position.x) * fwd.x +
+                  (c.a.y - camera.position.y) * fwd.y +
+                  (c.a.z - camera.position.z) * fwd.z;
+    }
+    std::sort(q.translucent.begin(), q.translucent.end(),
+              [](const Command& l, const Command& r) {
+                  if (l.depth != r.depth) return l.depth > r.depth;
+                  return l.seq < r.seq;
+              });
+    draw_runs(q.translucent, stats);
+
+    clear();
+    q.stats = stats;
+}
+
+void clear() {
+    auto& q = queue();
+    for (auto& cmds : q.opaque) cmds.clear();
+    q.overlay.clear();
+    q.translucent.clear();
+}
+
+Stats last_stats() { return queue().stats; }
+
+}  // namespace render_queue
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gfx3d.h"
+#include "render_helpers.h"
+
+// Command buffer for the 3D world pass.
+//
+// World render systems append primitives here instead of drawing them;
+// EndMode3DSystem flushes once per frame in three passes:
+//   Opaque      alpha 255, grouped by primitive so each group is one run
+//               of the immediate-mode batch
+//   Overlay     flat tile layers, submission order, no depth writes (so
+//               a transparent texel never hides what is drawn after it)
+//   Translucent alpha < 255, sorted back to front along the view axis
+// On raylib cubes and planes go straight into the batch as quads; other
+// primitives and backends fall back to the afterhours draw calls.
+namespace render_queue {
+
+void cube(vec3 center, float w, float h, float l, Color color);
+void plane(vec3 center, vec2 size, Color color);
+void cylinder(vec3 base, float radius_top, float radius_bottom, float height,
+              int slices, Color color);
+void sphere(vec3 center, float radius, Color color);
+void line(vec3 from, vec3 to, Color color);
+
+// Overlay-pass plane; `texture` (raylib texture id, 0 for none) spans it
+// with uv (0,0) at -x,-z and (1,1) at +x,+z
+void overlay(vec3 center, vec2 size, Color color, unsigned int texture = 0);
+
+// Sort and draw everything queued this frame, then clear the queue.
+// `camera` orders the translucent pass; call inside the 3D mode.
+void flush(const Camera3D& camera);
+
+// Drop everything queued this frame without drawing (no camera)
+void clear();
+
+struct Stats {
+    size_t commands = 0;  // primitives drawn by the last flush
+    size_t runs = 0;      // contiguous same-state runs they were drawn in
+};
+[[nodiscard]] Stats last_stats();
+
+}  // namespace render_queue
@@ -11,6 +11,9 @@ void register_render_debug_systems(SystemManager& sm);
 void register_render_end_system(SystemManager& sm);
 
 void register_render_systems(SystemManager& sm) {
+    sm.register_render_system(std::make_unique<system_timing::SectionMark>(
+        system_timing::RENDER, true));
+
     // 3D world pass (grid, glow, agents, overlays, particles, preview)
     register_render_world_systems(sm);
 
@@ -20,6 +23,10 @@ void register_render_systems(SystemManager& sm) {
     // Debug panel (sliders)
     register_render_debug_systems(sm);
 
+    // Render section ends before the present, which may wait on vsync
+    sm.register_render_system(std::make_unique<system_timing::SectionMark>(
+        system_timing::RENDER, false));
+
     // End render (flush texture to screen)
     register_render_end_system(sm);
 }
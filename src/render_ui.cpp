@@ -6,10 +6,13 @@
 #include "afterhours/src/core/entity_query.h"
 #include "afterhours/src/plugins/e2e_testing/visible_text.h"
 #include "components.h"
+#include "density_history.h"
 #include "gfx3d.h"
 #include "render_helpers.h"
+#include "replay.h"
 #include "save_system.h"
 #include "systems.h"
+#include "text_cache.h"
 #include "update_helpers.h"
 
 // Update hover grid position from mouse
@@ -93,16 +96,13 @@ struct RenderFacilityLabelsSystem : System<> {
                 screen.y < -50 || screen.y > DEFAULT_SCREEN_HEIGHT + 50)
                 continue;
 
-            float font_size = 13;
-            vec2 m =
-                measure_text_ex(get_font(), lbl.text, font_size, FONT_SPACING);
+            const auto& text = text_cache::get(lbl.text, 13);
+            vec2 m = text.extent;
             float tx = screen.x - m.x / 2.f;
             float ty = screen.y - m.y / 2.f;
 
             draw_rect(tx - 3, ty - 2, m.x + 6, m.y + 4, Color{0, 0, 0, 160});
-            Color color = {lbl.r, lbl.g, lbl.b, 255};
-            draw_text_ex(get_font(), lbl.text, {tx, ty}, font_size,
-                         FONT_SPACING, color);
+            text_cache::draw(text, tx, ty, Color{lbl.r, lbl.g, lbl.b, 255});
 
             // Fill bar for serviceable facilities (not stage/gate)
             bool is_facility = (std::strcmp(lbl.text, "WC") == 0 ||
@@ -128,28 +128,29 @@ struct RenderFacilityLabelsSystem : System<> {
     }
 };
 
-// Shared UI text helpers
-static void ui_draw_text(const std::string& text, float x, float y, float size,
+// Shared UI text helpers (layouts come from text_cache)
+static void ui_draw_text(std::string_view text, float x, float y, float size,
                          Color color) {
-    draw_text_ex(get_font(), text.c_str(), {x, y}, size, FONT_SPACING, color);
+    text_cache::draw(text_cache::get(text, size), x, y, color);
 }
 
-static vec2 ui_measure_text(const std::string& text, float size) {
-    return measure_text_ex(get_font(), text.c_str(), size, FONT_SPACING);
+static vec2 ui_measure_text(std::string_view text, float size) {
+    return text_cache::get(text, size).extent;
 }
 
-static void ui_draw_text_bg(const std::string& text, float x, float y,
+static void ui_draw_text_bg(std::string_view text, float x, float y,
                             float size, Color color) {
-    auto m = ui_measure_text(text, size);
+    const auto& layout = text_cache::get(text, size);
+    auto m = layout.extent;
     draw_rect(x - 6, y - 3, m.x + 12, m.y + 6, Color{0, 0, 0, 240});
-    ui_draw_text(text, x, y, size, color);
+    text_cache::draw(layout, x, y, color);
 }
 
-static void ui_draw_text_centered(const std::string& text, float y, float size,
+static void ui_draw_text_centered(std::string_view text, float y, float size,
                                   Color color) {
-    auto m = ui_measure_text(text, size);
-    float x = (DEFAULT_SCREEN_WIDTH - m.x) / 2.f;
-    ui_draw_text(text, x, y, size, color);
+    const auto& layout = text_cache::get(text, size);
+    float x = (DEFAULT_SCREEN_WIDTH - layout.extent.x) / 2.f;
+    text_cache::draw(layout, x, y, color);
 }
 
 struct ToolInfo {
@@ -180,14 +181,16 @@ struct RenderTopBarSystem : System<> {
         draw_rect(0, 0, DEFAULT_SCREEN_WIDTH, 44, Color{0, 0, 0, 180});
         float bar_x = 12;
         if (clock) {
-            std::string time_str = clock->format_time();
-            ui_draw_text(time_str, bar_x, 10, 22, Color{255, 255, 255, 255});
-            vtr.register_text(time_str);
+            const auto& time_text = text_cache::format(
+                22, "{:02d}:{:02d}", clock->get_hour(), clock->get_minute());
+            text_cache::draw(time_text, bar_x, 10, Color{255, 255, 255, 255});
+            vtr.register_text(time_text.text);
             bar_x += 90;
-            std::string phase_str = GameClock::phase_name(clock->get_phase());
-            ui_draw_text(phase_str, bar_x, 11, 20, Color{255, 220, 100, 255});
-            vtr.register_text(phase_str);
-            bar_x += ui_measure_text(phase_str, 20).x + 16;
+            const auto& phase_text = text_cache::get(
+                GameClock::phase_name(clock->get_phase()), 20);
+            text_cache::draw(phase_text, bar_x, 11, Color{255, 220, 100, 255});
+            vtr.register_text(phase_text.text);
+            bar_x += phase_text.extent.x + 16;
 
             auto mouse = input::get_mouse_position();
             bool mouse_click =
@@ -212,10 +215,14 @@ struct RenderTopBarSystem : System<> {
                 float iy = 8;
                 float ih = 28;
 
-                if (mouse_click && !game_is_over() && mouse.x >= ix &&
+                if (mouse_click && !game_is_over() &&
+                    !replay::is_playing() && mouse.x >= ix &&
                     mouse.x <= ix + icon_w && mouse.y >= iy &&
                     mouse.y <= iy + ih) {
                     clock->speed = SPEED_ICONS[i].speed;
+                    replay::record_between_ticks(
+                        {.kind = replay::ActionKind::SetSpeed,
+                         .value = (uint8_t) clock->speed});
                     active = true;
                     col = Color{255, 255, 255, 255};
                 }
@@ -231,25 +238,29 @@ struct RenderTopBarSystem : System<> {
             bar_x += 8;
         }
         if (gs) {
-            std::string death_text =
-                fmt::format("Deaths: {}/{}", gs->death_count, gs->max_deaths);
+            const auto& death_text = text_cache::format(
+                20, "Deaths: {}/{}", gs->death_count, gs->max_deaths);
             Color dc = gs->death_count >= 7 ? Color{255, 80, 80, 255}
                                             : Color{255, 255, 255, 255};
-            ui_draw_text(death_text, bar_x, 11, 20, dc);
-            vtr.register_text(death_text);
+            text_cache::draw(death_text, bar_x, 11, dc);
+            vtr.register_text(death_text.text);
             bar_x += 170;
             int agent_count =
                 (int) EntityQuery().whereHasComponent<Agent>().gen_count();
-            std::string att_text = fmt::format("Attendees: {}", agent_count);
-            ui_draw_text(att_text, bar_x, 11, 20, Color{255, 255, 255, 255});
-            vtr.register_text(att_text);
-            bar_x += ui_measure_text(att_text, 20).x + 20;
+            auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+            if (mc) agent_count += mc->total_agents();
+            const auto& att_text =
+                text_cache::format(20, "Attendees: {}", agent_count);
+            text_cache::draw(att_text, bar_x, 11, Color{255, 255, 255, 255});
+            vtr.register_text(att_text.text);
+            bar_x += att_text.extent.x + 20;
         }
         auto* diff = EntityHelper::get_singleton_cmp<DifficultyState>();
         if (diff) {
-            std::string day_text = fmt::format("Day {}", diff->day_number);
-            ui_draw_text(day_text, bar_x, 11, 20, Color{180, 220, 255, 255});
-            vtr.register_text(day_text);
+            const auto& day_text =
+                text_cache::format(20, "Day {}", diff->day_number);
+            text_cache::draw(day_text, bar_x, 11, Color{180, 220, 255, 255});
+            vtr.register_text(day_text.text);
             bar_x += 90;
         }
 
@@ -258,19 +269,18 @@ struct RenderTopBarSystem : System<> {
             for (Entity& ev_e : events) {
                 auto& ev = ev_e.get<ActiveEvent>();
                 float remain = ev.duration - ev.elapsed;
-                std::string ev_text =
-                    fmt::format("{} ({:.0f}s)", ev.description, remain);
-                ui_draw_text(ev_text, bar_x, 11, 16, Color{255, 200, 80, 255});
-                vtr.register_text(ev_text);
-                bar_x += ui_measure_text(ev_text, 16).x + 12;
+                const auto& ev_text = text_cache::format(
+                    16, "{} ({:.0f}s)", ev.description, remain);
+                text_cache::draw(ev_text, bar_x, 11, Color{255, 200, 80, 255});
+                vtr.register_text(ev_text.text);
+                bar_x += ev_text.extent.x + 12;
             }
         }
 
         int fps = get_fps();
-        std::string fps_text = fmt::format("FPS: {}", fps);
-        auto fps_measure = ui_measure_text(fps_text, 18);
-        ui_draw_text(
-            fps_text, DEFAULT_SCREEN_WIDTH - 150 - fps_measure.x - 10, 12, 18,
+        const auto& fps_text = text_cache::format(18, "FPS: {}", fps);
+        text_cache::draw(
+            fps_text, DEFAULT_SCREEN_WIDTH - 150 - fps_text.extent.x - 10, 12,
             fps >= 55 ? Color{100, 255, 100, 255} : Color{255, 80, 80, 255});
     }
 };
@@ -344,13 +354,13 @@ struct RenderToastsSystem : System<> {
                 alpha = (toast.lifetime - toast.elapsed) / toast.fade_duration;
             }
             unsigned char a = static_cast<unsigned char>(alpha * 255);
-            auto tm = ui_measure_text(toast.text, 20);
+            const auto& text = text_cache::get(toast.text, 20);
+            auto tm = text.extent;
             float tx = (DEFAULT_SCREEN_WIDTH - tm.x) / 2.f;
 
             draw_rect(tx - 8, toast_y - 4, tm.x + 16, tm.y + 8,
                       Color{30, 120, 60, a});
-            draw_text_ex(get_font(), toast.text.c_str(), {tx, toast_y}, 20,
-                         FONT_SPACING, Color{255, 255, 255, a});
+            text_cache::draw(text, tx, toast_y, Color{255, 255, 255, a});
             vtr.register_text(toast.text);
             toast_y += tm.y + 16;
         }
@@ -492,6 +502,12 @@ static bool g_minimap_initialized = false;
 static constexpr int MINIMAP_SIZE = 150;
 static constexpr float MINIMAP_SCALE = 150.0f / 52.0f;
 
+// Agent layer: one cell per tile from the density plane, redrawn at
+// MINIMAP_AGENT_HZ so its cost tracks the map size, not the crowd size
+static afterhours::graphics::RenderTextureType g_minimap_agents_texture = {};
+static constexpr float MINIMAP_AGENT_HZ = 10.f;
+static float g_minimap_agents_next = 0.f;
+
 // Timeline sidebar showing artist schedule
 struct RenderTimelineSidebarSystem : System<> {
     void once(float) const override {
@@ -507,8 +523,8 @@ struct RenderTimelineSidebarSystem : System<> {
         draw_rect(sidebar_x, sidebar_y, sidebar_w, sidebar_h,
                   Color{15, 15, 25, 200});
 
-        draw_text_ex(get_font(), "LINEUP", {sidebar_x + 10, 8}, 18,
-                     FONT_SPACING, Color{255, 220, 100, 255});
+        ui_draw_text("LINEUP", sidebar_x + 10, 8, 18,
+                     Color{255, 220, 100, 255});
         auto& vtr = afterhours::testing::VisibleTextRegistry::instance();
         vtr.register_text("LINEUP");
 
@@ -520,8 +536,8 @@ struct RenderTimelineSidebarSystem : System<> {
         float now_y = sidebar_y + sidebar_h * 0.2f;
         draw_line(sidebar_x, now_y, sidebar_x + sidebar_w, now_y,
                   Color{255, 100, 100, 255});
-        draw_text_ex(get_font(), "NOW", {sidebar_x + 6, now_y - 18}, 16,
-                     FONT_SPACING, Color{255, 100, 100, 255});
+        ui_draw_text("NOW", sidebar_x + 6, now_y - 18, 16,
+                     Color{255, 100, 100, 255});
 
         float now_minutes = clock->game_time_minutes;
         float px_per_minute = 2.4f;
@@ -540,24 +556,19 @@ struct RenderTimelineSidebarSystem : System<> {
             draw_rect_lines(sidebar_x + 4, block_y, sidebar_w - 8, block_h,
                             Color{100, 100, 120, 200});
 
-            std::string label =
-                a.performing ? fmt::format("> {}", a.name) : a.name;
+            const auto& label = text_cache::format(
+                16, "{}{}", a.performing ? "> " : "", a.name);
             Color name_col = a.performing ? Color{255, 230, 80, 255}
                                           : Color{255, 255, 255, 255};
-            draw_text_ex(get_font(), label.c_str(),
-                         {sidebar_x + 11, block_y + 5}, 16, FONT_SPACING,
-                         Color{0, 0, 0, 120});
-            draw_text_ex(get_font(), label.c_str(),
-                         {sidebar_x + 10, block_y + 4}, 16, FONT_SPACING,
-                         name_col);
+            text_cache::draw_shadowed(label, sidebar_x + 10, block_y + 4,
+                                      name_col, 1, 1, Color{0, 0, 0, 120});
 
             int h = (int) (a.start_time_minutes / 60) % 24;
             int m = (int) a.start_time_minutes % 60;
-            std::string info =
-                fmt::format("{:02d}:{:02d}  ~{} ppl", h, m, a.expected_crowd);
-            draw_text_ex(get_font(), info.c_str(),
-                         {sidebar_x + 10, block_y + 24}, 14, FONT_SPACING,
-                         Color{190, 190, 210, 255});
+            const auto& info = text_cache::format(
+                14, "{:02d}:{:02d}  ~{} ppl", h, m, a.expected_crowd);
+            text_cache::draw(info, sidebar_x + 10, block_y + 24,
+                             Color{190, 190, 210, 255});
         }
 
         end_scissor_mode();
@@ -574,14 +585,37 @@ struct RenderMinimapSystem : System<> {
         {255, 100, 100, 255},  // MedTent
     };
 
+    // Each occupied tile in the color of what most of its agents want.
+    // Opaque: blending into the cleared texture would square the alpha.
+    static void draw_agent_layer(const Grid& grid) {
+        begin_texture_mode(g_minimap_agents_texture);
+        clear_background({0, 0, 0, 0});
+        for (int z = 0; z < MAP_SIZE; z++) {
+            for (int x = 0; x < MAP_SIZE; x++) {
+                const Tile& tile = grid.at(x, z);
+                if (tile.agent_count <= 0) continue;
+                int di = 0;
+                for (int d = 1; d < Tile::NUM_DESIRES; d++) {
+                    if (tile.desire_counts[d] > tile.desire_counts[di]) di = d;
+                }
+                draw_rect(x * MINIMAP_SCALE, z * MINIMAP_SCALE, MINIMAP_SCALE,
+                          MINIMAP_SCALE, AGENT_DOT_COLORS[di % 5]);
+            }
+        }
+        end_texture_mode();
+    }
+
     void once(float) const override {
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
         if (!grid) return;
 
         if (!g_minimap_initialized) {
             g_minimap_texture = load_render_texture(MINIMAP_SIZE, MINIMAP_SIZE);
+            g_minimap_agents_texture =
+                load_render_texture(MINIMAP_SIZE, MINIMAP_SIZE);
             g_minimap_initialized = true;
             grid->minimap_dirty = true;
+            g_minimap_agents_next = 0.f;
         }
 
         if (grid->minimap_dirty) {
@@ -605,32 +639,22 @@ struct RenderMinimapSystem : System<> {
             end_texture_mode();
         }
 
+        float now = get_time();
+        if (now >= g_minimap_agents_next) {
+            g_minimap_agents_next = now + 1.f / MINIMAP_AGENT_HZ;
+            draw_agent_layer(*grid);
+        }
+
         begin_texture_mode(g_render_texture);
 
         float sidebar_x = DEFAULT_SCREEN_WIDTH - 150.f;
         float minimap_y = DEFAULT_SCREEN_HEIGHT - MINIMAP_SIZE;
 
-        // Draw cached tile layer
+        // Draw cached tile layer, then the throttled agent layer
         draw_render_texture(g_minimap_texture, sidebar_x, minimap_y,
                             Color{255, 255, 255, 255});
-
-        // Draw agent dots (per-frame)
-        auto agents = EntityQuery()
-                          .whereHasComponent<Agent>()
-                          .whereHasComponent<Transform>()
-                          .gen();
-        for (Entity& ae : agents) {
-            if (!ae.is_missing<BeingServiced>()) continue;
-            auto& tf = ae.get<Transform>();
-            float gx = tf.position.x / TILESIZE;
-            float gz = tf.position.y / TILESIZE;
-            float px = sidebar_x + gx * MINIMAP_SCALE;
-            float py = minimap_y + gz * MINIMAP_SCALE;
-
-            int di = static_cast<int>(ae.get<Agent>().want);
-            Color dot_col = AGENT_DOT_COLORS[di % 5];
-            draw_rect(px, py, 2, 2, dot_col);
-        }
+        draw_render_texture(g_minimap_agents_texture, sidebar_x, minimap_y,
+                            Color{255, 255, 255, 255});
 
         // Draw camera viewport rectangle
         auto* cam = EntityHelper::get_singleton_cmp<ProvidesCamera>();
@@ -663,11 +687,42 @@ struct RenderGameOverSystem : System<> {
         draw_rect(0, 0, DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT,
                   Color{0, 0, 0, 200});
 
+        // Run-long peak density, recomputed only when history changes
+        static density_history::Window heat;
+        static uint64_t heat_version = ~0ull;
+        auto hist = density_history::stats();
+        if (hist.version != heat_version) {
+            density_history::query_all(heat);
+            heat_version = hist.version;
+        }
+        constexpr float HEAT_CELL = 3.f;
+        constexpr float HEAT_SIZE = MAP_SIZE * HEAT_CELL;
+        bool show_heat = !heat.empty();
+
+        // Text column stays centered; the heatmap extends the panel right
         float pw = 460, ph = 360;
         float px = (DEFAULT_SCREEN_WIDTH - pw) / 2.f;
         float py = (DEFAULT_SCREEN_HEIGHT - ph) / 2.f;
-        draw_rect(px, py, pw, ph, Color{20, 20, 30, 240});
-        draw_rect_lines(px, py, pw, ph, Color{255, 80, 80, 255});
+        float frame_w = show_heat ? pw + HEAT_SIZE + 20 : pw;
+        draw_rect(px, py, frame_w, ph, Color{20, 20, 30, 240});
+        draw_rect_lines(px, py, frame_w, ph, Color{255, 80, 80, 255});
+
+        if (show_heat) {
+            float hx = px + pw;
+            float hy = py + 90;
+            ui_draw_text("Crowd pressure (peak)", hx, hy - 24, 14,
+                         Color{180, 200, 255, 255});
+            draw_rect(hx, hy, HEAT_SIZE, HEAT_SIZE, Color{30, 32, 40, 255});
+            for (int i = 0; i < density_history::NUM_TILES; i++) {
+                if (heat.max[i] == 0) continue;
+                float ratio = heat.max[i] / (float) MAX_AGENTS_PER_TILE;
+                draw_rect(hx + (i % MAP_SIZE) * HEAT_CELL,
+                          hy + (i / MAP_SIZE) * HEAT_CELL, HEAT_CELL,
+                          HEAT_CELL, density_color(ratio));
+            }
+            draw_rect_lines(hx, hy, HEAT_SIZE, HEAT_SIZE,
+                            Color{100, 100, 120, 255});
+        }
 
         std::string title = "FESTIVAL SHUT DOWN";
         ui_draw_text_centered(title, py + 20, 34, Color{255, 80, 80, 255});
@@ -727,19 +782,19 @@ struct EndRenderSystem : System<> {
 };
 
 void register_render_ui_systems(SystemManager& sm) {
-    sm.register_render_system(std::make_unique<HoverTrackingSystem>());
-    sm.register_render_system(std::make_unique<RenderFacilityLabelsSystem>());
-    sm.register_render_system(std::make_unique<RenderTopBarSystem>());
-    sm.register_render_system(std::make_unique<RenderBuildBarSystem>());
-    sm.register_render_system(std::make_unique<RenderToastsSystem>());
-    sm.register_render_system(std::make_unique<RenderNuxBannerSystem>());
-    sm.register_render_system(std::make_unique<RenderCompassSystem>());
-    sm.register_render_system(std::make_unique<RenderHoverInfoSystem>());
-    sm.register_render_system(std::make_unique<RenderTimelineSidebarSystem>());
-    sm.register_render_system(std::make_unique<RenderMinimapSystem>());
-    sm.register_render_system(std::make_unique<RenderGameOverSystem>());
+    sm.register_render_system(timed<HoverTrackingSystem>());
+    sm.register_render_system(timed<RenderFacilityLabelsSystem>());
+    sm.register_render_system(timed<RenderTopBarSystem>());
+    sm.register_render_system(timed<RenderBuildBarSystem>());
+    sm.register_render_system(timed<RenderToastsSystem>());
+    sm.register_render_system(timed<RenderNuxBannerSystem>());
+    sm.register_render_system(timed<RenderCompassSystem>());
+    sm.register_render_system(timed<RenderHoverInfoSystem>());
+    sm.register_render_system(timed<RenderTimelineSidebarSystem>());
+    sm.register_render_system(timed<RenderMinimapSystem>());
+    sm.register_render_system(timed<RenderGameOverSystem>());
 }
 
 void register_render_end_system(SystemManager& sm) {
-    sm.register_render_system(std::make_unique<EndRenderSystem>());
+    sm.register_render_system(timed<EndRenderSystem>());
 }
@@ -5,8 +5,10 @@
 #include "afterhours/src/core/entity_helper.h"
 #include "afterhours/src/core/entity_query.h"
 #include "components.h"
+#include "crowd_heatmap.h"
 #include "gfx3d.h"
 #include "render_helpers.h"
+#include "render_queue.h"
 #include "systems.h"
 
 static constexpr float LOD_CLOSE_MAX = 25.0f;
@@ -92,8 +94,8 @@ struct RenderGridSystem : System<> {
             for (int x = x0; x <= x1; x++) {
                 const Tile& tile = grid->at(x, z);
                 Color color = ::tile_color(tile.type, night_t);
-                draw_plane({x * TILESIZE, 0.01f, z * TILESIZE},
-                           {tile_size, tile_size}, color);
+                render_queue::plane({x * TILESIZE, 0.01f, z * TILESIZE},
+                                    {tile_size, tile_size}, color);
             }
         }
     }
@@ -115,8 +117,8 @@ struct RenderStageGlowSystem : System<> {
             float ts = TILESIZE * 0.98f;
             for (int z = STAGE_Z; z < STAGE_Z + STAGE_SIZE; z++)
                 for (int x = STAGE_X; x < STAGE_X + STAGE_SIZE; x++)
-                    draw_plane({x * TILESIZE, 0.06f, z * TILESIZE}, {ts, ts},
-                               glow);
+                    render_queue::plane({x * TILESIZE, 0.06f, z * TILESIZE},
+                                        {ts, ts}, glow);
             return;
         }
 
@@ -131,7 +133,8 @@ struct RenderStageGlowSystem : System<> {
         float ts = TILESIZE * 0.98f;
         for (int z = STAGE_Z; z < STAGE_Z + STAGE_SIZE; z++)
             for (int x = STAGE_X; x < STAGE_X + STAGE_SIZE; x++)
-                draw_plane({x * TILESIZE, 0.06f, z * TILESIZE}, {ts, ts}, glow);
+                render_queue::plane({x * TILESIZE, 0.06f, z * TILESIZE},
+                                    {ts, ts}, glow);
 
         float beam_h = 2.5f + pulse * 0.5f;
         float beam_r = 0.06f;
@@ -152,28 +155,21 @@ struct RenderStageGlowSystem : System<> {
             float angle = t * 1.5f + i * 1.57f;
             float sway_x = std::sin(angle) * 0.3f;
             float sway_z = std::cos(angle * 0.7f) * 0.3f;
-            draw_cylinder({corners[i][0], 0.0f, corners[i][1]}, beam_r,
-                          beam_r * 0.3f, beam_h, 4, beam_colors[i]);
-            draw_sphere(
+            render_queue::cylinder({corners[i][0], 0.0f, corners[i][1]},
+                                   beam_r, beam_r * 0.3f, beam_h, 4,
+                                   beam_colors[i]);
+            render_queue::sphere(
                 {corners[i][0] + sway_x, beam_h, corners[i][1] + sway_z}, 0.08f,
                 beam_colors[i]);
         }
 
         auto spot_alpha = static_cast<unsigned char>(80 + pulse * 80);
-        draw_cylinder({stage_cx, 0.0f, stage_cz}, 0.1f, 0.6f + pulse * 0.2f,
-                      2.0f + pulse * 0.5f, 6, {255, 255, 200, spot_alpha});
+        render_queue::cylinder({stage_cx, 0.0f, stage_cz}, 0.1f,
+                               0.6f + pulse * 0.2f, 2.0f + pulse * 0.5f, 6,
+                               {255, 255, 200, spot_alpha});
     }
 };
 
-// Desire pip colors
-static constexpr Color DESIRE_COLORS[] = {
-    {126, 207, 192, 255},  // Bathroom
-    {244, 164, 164, 255},  // Food
-    {255, 217, 61, 255},   // Stage
-    {68, 136, 170, 255},   // Exit/Gate
-    {255, 100, 100, 255},  // MedTent
-};
-
 static float hash_scatter(int seed) {
     uint32_t h = static_cast<uint32_t>(seed);
     h ^= h >> 16;
@@ -193,7 +189,6 @@ static constexpr float BODY_W = 0.14f;
 static constexpr float BODY_H = 0.32f;
 static constexpr float PIP_W = 0.09f;
 static constexpr float PIP_H = 0.08f;
-static constexpr float SCATTER_RANGE = 0.35f;
 
 struct RenderAgentsSystem : System<> {
     void once(float) const override {
@@ -201,66 +196,57 @@ struct RenderAgentsSystem : System<> {
         if (vr && vr->lod != LODLevel::Close) return;
 
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        if (!grid) return;
 
-        auto agents = EntityQuery()
-                          .whereHasComponent<Agent>()
-                          .whereHasComponent<Transform>()
-                          .gen();
-
-        for (Entity& e : agents) {
-            if (!e.is_missing<BeingServiced>()) continue;
-
-            auto& agent = e.get<Agent>();
-            auto& tf = e.get<Transform>();
-
-            if (vr && grid) {
-                auto [gx, gz] =
-                    grid->world_to_grid(tf.position.x, tf.position.y);
-                if (gx < vr->min_x || gx > vr->max_x || gz < vr->min_z ||
-                    gz > vr->max_z)
-                    continue;
-            }
-
-            float wx = tf.position.x;
-            float wz = tf.position.y;
-
-            int eid = static_cast<int>(e.id);
-            float ox = hash_scatter(eid * 7 + 3) * SCATTER_RANGE;
-            float oz = hash_scatter(eid * 13 + 7) * SCATTER_RANGE;
-            wx += ox;
-            wz += oz;
-
-            Color body_col = AGENT_PALETTE[agent.color_idx % 8];
-
-            float bob_y = 0.0f;
-            if (!e.is_missing<WatchingStage>()) {
-                auto& ws = e.get<WatchingStage>();
-                bob_y = std::sin(ws.watch_timer * 6.0f) * 0.03f;
-            }
+        // Visit only the rows of tiles in view; each is one run of the
+        // index the sim rebuilt at the end of the tick
+        int min_x = 0, max_x = MAP_SIZE - 1;
+        int min_z = 0, max_z = MAP_SIZE - 1;
+        if (vr) {
+            min_x = std::max(vr->min_x, 0);
+            max_x = std::min(vr->max_x, MAP_SIZE - 1);
+            min_z = std::max(vr->min_z, 0);
+            max_z = std::min(vr->max_z, MAP_SIZE - 1);
+        }
+        if (min_x > max_x) return;
+
+        const auto& index = grid->agent_index;
+        const auto& hash = index.hash;
+        for (int z = min_z; z <= max_z; z++) {
+            auto [first, last] = index.row(z, min_x, max_x);
+            for (int k = first; k < last; k++)
+                draw_agent(hash.xs[k], hash.zs[k],
+                           index.entries[hash.ids[k]]);
+        }
+    }
 
-            if (!e.is_missing<AgentHealth>()) {
-                float hp = e.get<AgentHealth>().hp;
-                if (hp < 0.5f) {
-                    float t = hp / 0.5f;
-                    body_col.r = static_cast<unsigned char>(body_col.r * t +
-                                                            255 * (1.f - t));
-                    body_col.g = static_cast<unsigned char>(body_col.g * t);
-                    body_col.b = static_cast<unsigned char>(body_col.b * t);
-                }
-            }
+    static void draw_agent(float wx, float wz,
+                           const AgentTileIndex::Entry& agent) {
+        // Positions are already spread within the tile by
+        // AgentSeparationSystem, so no render-side scatter is needed.
+        Color body_col = AGENT_PALETTE[agent.color_idx % 8];
+
+        if (agent.hp < 0.5f) {
+            float t = agent.hp / 0.5f;
+            body_col.r = static_cast<unsigned char>(body_col.r * t +
+                                                    255 * (1.f - t));
+            body_col.g = static_cast<unsigned char>(body_col.g * t);
+            body_col.b = static_cast<unsigned char>(body_col.b * t);
+        }
 
-            float base_y = 0.16f + bob_y;
-            draw_cube({wx, base_y, wz}, BODY_W, BODY_H, BODY_W, body_col);
+        float base_y = 0.16f + agent.bob;
+        render_queue::cube({wx, base_y, wz}, BODY_W, BODY_H, BODY_W,
+                           body_col);
 
-            int desire_idx = static_cast<int>(agent.want);
-            Color pip_col = DESIRE_COLORS[desire_idx];
-            float pip_y = base_y + BODY_H * 0.5f + PIP_H * 0.5f;
-            draw_cube({wx, pip_y, wz}, PIP_W, PIP_H, PIP_W, pip_col);
-        }
+        Color pip_col = DESIRE_COLORS[agent.want];
+        float pip_y = base_y + BODY_H * 0.5f + PIP_H * 0.5f;
+        render_queue::cube({wx, pip_y, wz}, PIP_W, PIP_H, PIP_W, pip_col);
     }
 };
 
-// Medium LOD: per-tile scattered cubes based on agent_count
+// Medium LOD: per-tile scattered cubes based on agent_count.
+// Scatter offsets and jitter phases come from a table built once, so a
+// frame evaluates sin/cos of the time only once.
 struct RenderMediumLODSystem : System<> {
     static constexpr int MAX_DOTS_PER_TILE = 8;
     static constexpr float DOT_W = 0.22f;
@@ -268,6 +254,44 @@ struct RenderMediumLODSystem : System<> {
     static constexpr float JITTER_SPEED = 0.5f;
     static constexpr float JITTER_AMOUNT = 0.05f;
 
+    struct DotTable {
+        static constexpr int SLOTS = MAP_SIZE * MAP_SIZE * MAX_DOTS_PER_TILE;
+        // Static offset inside the tile, per (tile, dot)
+        std::array<float, SLOTS> ox{}, oz{};
+        // sin/cos of the jitter phase, per (column or row, dot)
+        std::array<float, MAP_SIZE * MAX_DOTS_PER_TILE> sx{}, cx{}, sz{}, cz{};
+    };
+
+    static const DotTable& dot_table() {
+        static const auto table = [] {
+            auto t = std::make_unique<DotTable>();
+            for (int i = 0; i < MAP_SIZE * MAP_SIZE; i++) {
+                int x = i % MAP_SIZE, z = i / MAP_SIZE;
+                int tile_seed = x * 1000 + z * 100;
+                for (int k = 0; k < MAX_DOTS_PER_TILE; k++) {
+                    int slot = i * MAX_DOTS_PER_TILE + k;
+                    t->ox[slot] = hash_scatter(tile_seed + k * 7 + 3) * 0.38f;
+                    t->oz[slot] = hash_scatter(tile_seed + k * 13 + 7) * 0.38f;
+                }
+            }
+            for (int c = 0; c < MAP_SIZE; c++) {
+                for (int k = 0; k < MAX_DOTS_PER_TILE; k++) {
+                    int slot = c * MAX_DOTS_PER_TILE + k;
+                    t->sx[slot] = std::sin(k * 1.7f + c);
+                    t->cx[slot] = std::cos(k * 1.7f + c);
+                    t->sz[slot] = std::sin(k * 2.3f + c);
+                    t->cz[slot] = std::cos(k * 2.3f + c);
+                }
+            }
+            return t;
+        }();
+        return *table;
+    }
+
+    static void emit_dot(float wx, float wz, Color c) {
+        render_queue::cube({wx, DOT_H * 0.5f, wz}, DOT_W, DOT_H, DOT_W, c);
+    }
+
     void once(float) const override {
         auto* vr = EntityHelper::get_singleton_cmp<VisibleRegion>();
         if (!vr || vr->lod != LODLevel::Medium) return;
@@ -275,7 +299,14 @@ struct RenderMediumLODSystem : System<> {
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
         if (!grid) return;
 
+        const DotTable& table = dot_table();
+
+        // Jitter is sin(a + phase_x) and cos(b + phase_z); expand both so
+        // only the time-dependent half is evaluated per frame
         float t = get_time();
+        float a = t * JITTER_SPEED, b = t * JITTER_SPEED * 0.8f;
+        float sin_a = std::sin(a), cos_a = std::cos(a);
+        float sin_b = std::sin(b), cos_b = std::cos(b);
 
         for (int z = vr->min_z; z <= vr->max_z; z++) {
             for (int x = vr->min_x; x <= vr->max_x; x++) {
@@ -283,7 +314,6 @@ struct RenderMediumLODSystem : System<> {
                 if (tile.agent_count <= 0) continue;
 
                 int dots = std::min(tile.agent_count, MAX_DOTS_PER_TILE);
-                int tile_seed = x * 1000 + z * 100;
 
                 // Distribute dots proportionally across desires
                 int desire_dots[Tile::NUM_DESIRES] = {};
@@ -301,26 +331,22 @@ struct RenderMediumLODSystem : System<> {
                     }
                 }
 
+                int tile_slot = (z * MAP_SIZE + x) * MAX_DOTS_PER_TILE;
+                int col_slot = x * MAX_DOTS_PER_TILE;
+                int row_slot = z * MAX_DOTS_PER_TILE;
                 int dot_idx = 0;
                 for (int d = 0; d < Tile::NUM_DESIRES; d++) {
                     for (int j = 0; j < desire_dots[d]; j++, dot_idx++) {
-                        float ox =
-                            hash_scatter(tile_seed + dot_idx * 7 + 3) * 0.38f;
-                        float oz =
-                            hash_scatter(tile_seed + dot_idx * 13 + 7) * 0.38f;
-
-                        float jx =
-                            std::sin(t * JITTER_SPEED + dot_idx * 1.7f + x) *
-                            JITTER_AMOUNT;
-                        float jz = std::cos(t * JITTER_SPEED * 0.8f +
-                                            dot_idx * 2.3f + z) *
+                        int k = std::min(dot_idx, MAX_DOTS_PER_TILE - 1);
+                        float jx = (sin_a * table.cx[col_slot + k] +
+                                    cos_a * table.sx[col_slot + k]) *
                                    JITTER_AMOUNT;
-
-                        float wx = x * TILESIZE + ox + jx;
-                        float wz = z * TILESIZE + oz + jz;
-
-                        draw_cube({wx, DOT_H * 0.5f, wz}, DOT_W, DOT_H, DOT_W,
-                                  DESIRE_COLORS[d]);
+                        float jz = (cos_b * table.cz[row_slot + k] -
+                                    sin_b * table.sz[row_slot + k]) *
+                                   JITTER_AMOUNT;
+                        float wx = x * TILESIZE + table.ox[tile_slot + k] + jx;
+                        float wz = z * TILESIZE + table.oz[tile_slot + k] + jz;
+                        emit_dot(wx, wz, DESIRE_COLORS[d]);
                     }
                 }
             }
@@ -328,85 +354,68 @@ struct RenderMediumLODSystem : System<> {
     }
 };
 
-// Far LOD: desire-colored blobs that merge across adjacent tiles.
-// Color reflects what agents on each tile want (stage=gold, bathroom=teal,
-// etc.) Large overlapping disks with neighbor-blended colors create seamless
-// merging.
-struct RenderFarLODSystem : System<> {
-    static constexpr int DISK_SEGMENTS = 16;
-
-    static Color desire_blend(const Tile& tile) {
-        if (tile.agent_count <= 0) return {180, 180, 180, 255};
-        float inv = 1.0f / tile.agent_count;
-        float r = 0, g = 0, b = 0;
-        for (int i = 0; i < Tile::NUM_DESIRES; i++) {
-            float w = tile.desire_counts[i] * inv;
-            r += DESIRE_COLORS[i].r * w;
-            g += DESIRE_COLORS[i].g * w;
-            b += DESIRE_COLORS[i].b * w;
-        }
-        return {static_cast<unsigned char>(std::clamp(r, 0.f, 255.f)),
-                static_cast<unsigned char>(std::clamp(g, 0.f, 255.f)),
-                static_cast<unsigned char>(std::clamp(b, 0.f, 255.f)), 255};
-    }
-
-    static Color neighbor_blend(const Grid& grid, int cx, int cz) {
-        Color center = desire_blend(grid.at(cx, cz));
-        float total_w = static_cast<float>(grid.at(cx, cz).agent_count);
-        float r = center.r * total_w;
-        float g = center.g * total_w;
-        float b = center.b * total_w;
-
-        static constexpr int dx[] = {1, -1, 0, 0, 1, -1, 1, -1};
-        static constexpr int dz[] = {0, 0, 1, -1, 1, 1, -1, -1};
-        for (int d = 0; d < 8; d++) {
-            int nx = cx + dx[d], nz = cz + dz[d];
-            if (!grid.in_bounds(nx, nz)) continue;
-            const Tile& nb = grid.at(nx, nz);
-            if (nb.agent_count <= 0) continue;
-            float w = nb.agent_count * (d < 4 ? 0.5f : 0.25f);
-            Color nc = desire_blend(nb);
-            r += nc.r * w;
-            g += nc.g * w;
-            b += nc.b * w;
-            total_w += w;
-        }
-
-        if (total_w < 1.f) return center;
-        float inv = 1.0f / total_w;
-        return {static_cast<unsigned char>(std::clamp(r * inv, 0.f, 255.f)),
-                static_cast<unsigned char>(std::clamp(g * inv, 0.f, 255.f)),
-                static_cast<unsigned char>(std::clamp(b * inv, 0.f, 255.f)),
-                255};
-    }
-
-    static bool has_occupied_neighbor(const Grid& grid, int cx, int cz) {
-        static constexpr int dx[] = {1, -1, 0, 0};
-        static constexpr int dz[] = {0, 0, 1, -1};
-        for (int d = 0; d < 4; d++) {
-            int nx = cx + dx[d], nz = cz + dz[d];
-            if (grid.in_bounds(nx, nz) && grid.at(nx, nz).agent_count > 0)
-                return true;
+// A MAP_SIZE x MAP_SIZE RGBA layer (row-major by z) drawn as one quad over
+// the map, texel centers on tile centers. Backends without a texture
+// upload path draw one plane per visible non-transparent texel instead.
+struct TileLayer {
+    bool smooth = false;  // bilinear (blobs) rather than point (data view)
+    const std::vector<Color>* texels = nullptr;
+#ifdef AFTER_HOURS_USE_RAYLIB
+    raylib::Texture2D tex = {};
+#endif
+
+    void upload(const std::vector<Color>& src) {
+        texels = &src;
+#ifdef AFTER_HOURS_USE_RAYLIB
+        static_assert(sizeof(Color) == 4, "texels must be RGBA8");
+        if (tex.id != 0) {
+            raylib::UpdateTexture(tex, src.data());
+            return;
         }
-        return false;
+        raylib::Image img = {const_cast<Color*>(src.data()), MAP_SIZE,
+                             MAP_SIZE, 1,
+                             raylib::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        tex = raylib::LoadTextureFromImage(img);
+        raylib::SetTextureFilter(tex, smooth ? raylib::TEXTURE_FILTER_BILINEAR
+                                             : raylib::TEXTURE_FILTER_POINT);
+        raylib::SetTextureWrap(tex, raylib::TEXTURE_WRAP_CLAMP);
+#endif
     }
 
-    static bool has_empty_cardinal(const Grid& grid, int cx, int cz) {
-        static constexpr int dx[] = {1, -1, 0, 0};
-        static constexpr int dz[] = {0, 0, 1, -1};
-        for (int d = 0; d < 4; d++) {
-            int nx = cx + dx[d], nz = cz + dz[d];
-            if (!grid.in_bounds(nx, nz) || grid.at(nx, nz).agent_count <= 0)
-                return true;
+    // `tint` multiplies every texel (per-frame fades and pulses)
+    void draw(const VisibleRegion& vr, float y, Color tint) const {
+        if (!texels || tint.a == 0) return;
+#ifdef AFTER_HOURS_USE_RAYLIB
+        (void) vr;
+        float mid = (MAP_SIZE - 1) * 0.5f * TILESIZE;
+        float span = MAP_SIZE * TILESIZE;
+        render_queue::overlay({mid, y, mid}, {span, span}, tint, tex.id);
+#else
+        auto mul = [](unsigned char a, unsigned char b) {
+            return static_cast<unsigned char>(a * b / 255);
+        };
+        for (int z = vr.min_z; z <= vr.max_z; z++) {
+            for (int x = vr.min_x; x <= vr.max_x; x++) {
+                Color c = (*texels)[z * MAP_SIZE + x];
+                if (c.a == 0) continue;
+                c = {mul(c.r, tint.r), mul(c.g, tint.g), mul(c.b, tint.b),
+                     mul(c.a, tint.a)};
+                render_queue::overlay({x * TILESIZE, y, z * TILESIZE},
+                                      {TILESIZE, TILESIZE}, c);
+            }
         }
-        return false;
+#endif
     }
+};
 
-    static unsigned char scale_alpha(float base_alpha, float opacity) {
-        return static_cast<unsigned char>(
-            std::clamp(base_alpha * opacity, 0.f, 255.f));
-    }
+// Far LOD: desire-colored blobs that merge across adjacent tiles.
+// Color reflects what agents on each tile want (stage=gold, bathroom=teal,
+// etc.) The blurred per-tile field (crowd_heatmap) is drawn as one
+// bilinear-filtered layer, faded in by zoom through the tint.
+static TileLayer g_far_heatmap_layer{true};
+static uint64_t g_far_heatmap_version = 0;
 
+struct RenderFarLODSystem : System<> {
     void once(float) const override {
         auto* vr = EntityHelper::get_singleton_cmp<VisibleRegion>();
         if (!vr || vr->lod == LODLevel::Close) return;
@@ -414,9 +423,6 @@ struct RenderFarLODSystem : System<> {
         auto* gs = EntityHelper::get_singleton_cmp<GameState>();
         if (gs && gs->show_data_layer) return;
 
-        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
-        if (!grid) return;
-
         // Blob opacity: 0% at full zoom in (fovy=5), 100% at max zoom out
         // (fovy=50). Smooth transition across Medium→Far LOD range.
         constexpr float FOVY_MIN = 5.0f;
@@ -425,80 +431,16 @@ struct RenderFarLODSystem : System<> {
             std::clamp((vr->fovy - FOVY_MIN) / (FOVY_MAX - FOVY_MIN), 0.f, 1.f);
         if (opacity < 0.01f) return;
 
-        float t = get_time();
-
-        // Pass 1: solid quads that tile seamlessly.
-        // Adjacent occupied tiles share edges so the fill is continuous.
-        for (int z = vr->min_z; z <= vr->max_z; z++) {
-            for (int x = vr->min_x; x <= vr->max_x; x++) {
-                const Tile& tile = grid->at(x, z);
-                if (tile.agent_count <= 0) continue;
-
-                float density = std::min(
-                    tile.agent_count / static_cast<float>(MAX_AGENTS_PER_TILE),
-                    1.0f);
-
-                Color c1 = neighbor_blend(*grid, x, z);
-                c1.a = scale_alpha(180 + density * 75, opacity);
-
-                draw_plane({x * TILESIZE, 0.019f, z * TILESIZE},
-                           {TILESIZE, TILESIZE}, c1);
-            }
-        }
-
-        // Pass 2: soft edge circles on perimeter tiles (those with at
-        // least one empty cardinal neighbor). This softens the blob boundary
-        // with an organic rounded falloff instead of hard square edges.
-        for (int z = vr->min_z; z <= vr->max_z; z++) {
-            for (int x = vr->min_x; x <= vr->max_x; x++) {
-                const Tile& tile = grid->at(x, z);
-                if (tile.agent_count <= 0) continue;
-                if (!has_empty_cardinal(*grid, x, z)) continue;
-
-                float density = std::min(
-                    tile.agent_count / static_cast<float>(MAX_AGENTS_PER_TILE),
-                    1.0f);
-
-                float phase = hash_scatter(x * 31 + z * 57) * 3.14159f;
-                float pulse = (std::sin(t * 1.5f + phase) + 1.0f) * 0.5f;
-
-                float r1 = (0.8f + density * 0.4f) + pulse * 0.08f;
-                Color c1 = neighbor_blend(*grid, x, z);
-                c1.a = scale_alpha(100 + density * 80, opacity);
-
-                draw_cylinder({x * TILESIZE, 0.020f, z * TILESIZE}, r1, r1,
-                              0.001f, DISK_SEGMENTS, c1);
-            }
-        }
+        auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+        if (!grid) return;
 
-        // Pass 3: bright core highlights on dense tiles for visual interest
-        for (int z = vr->min_z; z <= vr->max_z; z++) {
-            for (int x = vr->min_x; x <= vr->max_x; x++) {
-                const Tile& tile = grid->at(x, z);
-                if (tile.agent_count < 3) continue;
-
-                float density = std::min(
-                    tile.agent_count / static_cast<float>(MAX_AGENTS_PER_TILE),
-                    1.0f);
-                if (density < 0.15f) continue;
-
-                float phase = hash_scatter(x * 31 + z * 57) * 3.14159f;
-                float pulse = (std::sin(t * 2.5f + phase + 2.0f) + 1.0f) * 0.5f;
-
-                float r3 = (0.3f + density * 0.3f) + pulse * 0.03f;
-                Color c3 = desire_blend(tile);
-                c3.r = static_cast<unsigned char>(
-                    std::min(255, static_cast<int>(c3.r) + 40));
-                c3.g = static_cast<unsigned char>(
-                    std::min(255, static_cast<int>(c3.g) + 40));
-                c3.b = static_cast<unsigned char>(
-                    std::min(255, static_cast<int>(c3.b) + 40));
-                c3.a = scale_alpha(200 + density * 55, opacity);
-
-                draw_cylinder({x * TILESIZE, 0.022f, z * TILESIZE}, r3, r3,
-                              0.001f, DISK_SEGMENTS, c3);
-            }
+        crowd_heatmap::refresh(*grid);
+        if (g_far_heatmap_version != crowd_heatmap::version()) {
+            g_far_heatmap_version = crowd_heatmap::version();
+            g_far_heatmap_layer.upload(crowd_heatmap::texels());
         }
+        auto alpha = static_cast<unsigned char>(opacity * 255.f);
+        g_far_heatmap_layer.draw(*vr, 0.019f, {255, 255, 255, alpha});
     }
 };
 
@@ -526,92 +468,133 @@ struct RenderBuildPreviewSystem : System<> {
                     bool already_path = grid->at(x, z).type == TileType::Path;
                     Color color =
                         already_path ? PREVIEW_EXISTING : PREVIEW_VALID;
-                    draw_plane({x * TILESIZE, preview_y, z * TILESIZE},
-                               {tile_size, tile_size}, color);
+                    render_queue::plane(
+                        {x * TILESIZE, preview_y, z * TILESIZE},
+                        {tile_size, tile_size}, color);
                 }
             }
         }
 
         Color cursor_color = pds->demolish_mode ? HOVER_DEMOLISH : HOVER_NORMAL;
-        draw_plane(
+        render_queue::plane(
             {pds->hover_x * TILESIZE, preview_y, pds->hover_z * TILESIZE},
             {tile_size, tile_size}, cursor_color);
     }
 };
 
 // Merged density system: handles both TAB-toggle heat map and always-on danger
-// flash. Uses VisibleRegion for culling.
+// flash. The heat map and the two flash masks are tile layers rebuilt only
+// when the densities changed, the heat map only while it is shown; the
+// flash pulse is a per-frame tint.
+struct DensityLayers {
+    std::vector<Color> heat = std::vector<Color>(MAP_SIZE * MAP_SIZE);
+    std::vector<Color> danger = std::vector<Color>(MAP_SIZE * MAP_SIZE);
+    std::vector<Color> critical = std::vector<Color>(MAP_SIZE * MAP_SIZE);
+    TileLayer heat_layer, danger_layer, critical_layer;
+    uint64_t flash_version = ~0ull;  // Grid densities built from
+    uint64_t heat_version = ~0ull;
+};
+
+static DensityLayers g_density_layers;
+
 struct RenderDensitySystem : System<> {
-    static Color get_density_color(float density_ratio) {
-        if (density_ratio < 0.50f) {
-            float t = density_ratio / 0.50f;
-            return Color{255, 255, 0, static_cast<unsigned char>(t * 180)};
-        } else if (density_ratio < 0.75f) {
-            float t = (density_ratio - 0.50f) / 0.25f;
-            return Color{255, static_cast<unsigned char>(255 - t * 90), 0, 180};
-        } else if (density_ratio < 0.90f) {
-            float t = (density_ratio - 0.75f) / 0.15f;
-            return Color{255, static_cast<unsigned char>(165 - t * 165), 0,
-                         200};
-        } else {
-            float t = std::min((density_ratio - 0.90f) / 0.10f, 1.0f);
-            return Color{static_cast<unsigned char>(255 - t * 255), 0, 0, 220};
+    // density_color for every agent count up to a full tile
+    static const std::array<Color, MAX_AGENTS_PER_TILE + 1>& density_lut() {
+        static const auto lut = [] {
+            std::array<Color, MAX_AGENTS_PER_TILE + 1> out{};
+            for (int n = 1; n <= MAX_AGENTS_PER_TILE; n++) {
+                out[n] = density_color(
+                    n / static_cast<float>(MAX_AGENTS_PER_TILE));
+            }
+            return out;
+        }();
+        return lut;
+    }
+
+    static void rebuild_heat(const Grid& grid) {
+        auto& dl = g_density_layers;
+        const auto& lut = density_lut();
+        for (int i = 0; i < MAP_SIZE * MAP_SIZE; i++) {
+            int n = grid.tiles[i].agent_count;
+            dl.heat[i] = lut[std::clamp(n, 0, MAX_AGENTS_PER_TILE)];
         }
+        dl.heat_layer.upload(dl.heat);
+        dl.heat_version = grid.density_version;
+    }
+
+    static void rebuild_flash(const Grid& grid) {
+        auto& dl = g_density_layers;
+        int danger_threshold =
+            static_cast<int>(DENSITY_DANGEROUS * MAX_AGENTS_PER_TILE);
+        constexpr Color NONE = {0, 0, 0, 0};
+        for (int i = 0; i < MAP_SIZE * MAP_SIZE; i++) {
+            int n = grid.tiles[i].agent_count;
+            bool danger = n >= danger_threshold;
+            bool critical =
+                danger && n / static_cast<float>(MAX_AGENTS_PER_TILE) >=
+                              DENSITY_CRITICAL;
+            dl.danger[i] =
+                danger && !critical ? Color{255, 140, 0, 255} : NONE;
+            dl.critical[i] = critical ? Color{255, 40, 40, 255} : NONE;
+        }
+        dl.danger_layer.upload(dl.danger);
+        dl.critical_layer.upload(dl.critical);
+        dl.flash_version = grid.density_version;
     }
 
     void once(float) const override {
         auto* grid = EntityHelper::get_singleton_cmp<Grid>();
-        if (!grid) return;
+        auto* vr = EntityHelper::get_singleton_cmp<VisibleRegion>();
+        if (!grid || !vr) return;
 
         auto* gs = EntityHelper::get_singleton_cmp<GameState>();
         bool show_overlay = gs && gs->show_data_layer;
 
-        auto* vr = EntityHelper::get_singleton_cmp<VisibleRegion>();
-        int x0 = vr ? vr->min_x : 0;
-        int x1 = vr ? vr->max_x : MAP_SIZE - 1;
-        int z0 = vr ? vr->min_z : 0;
-        int z1 = vr ? vr->max_z : MAP_SIZE - 1;
-
+        const auto& dl = g_density_layers;
+        if (dl.flash_version != grid->density_version) rebuild_flash(*grid);
+        if (show_overlay && dl.heat_version != grid->density_version)
+            rebuild_heat(*grid);
         float t = get_time();
         float tile_size = TILESIZE * 0.98f;
-        int danger_threshold =
-            static_cast<int>(DENSITY_DANGEROUS * MAX_AGENTS_PER_TILE);
 
-        for (int z = z0; z <= z1; z++) {
-            for (int x = x0; x <= x1; x++) {
-                const Tile& tile = grid->at(x, z);
-                if (tile.agent_count <= 0) continue;
-
-                float density =
-                    tile.agent_count / static_cast<float>(MAX_AGENTS_PER_TILE);
-
-                // TAB-toggle heat map overlay
-                if (show_overlay) {
-                    Color color = get_density_color(density);
-                    draw_plane({x * TILESIZE, 0.05f, z * TILESIZE},
-                               {tile_size, tile_size}, color);
-                }
-
-                // Always-on danger flash (>=75% density)
-                if (tile.agent_count >= danger_threshold) {
-                    bool critical = density >= DENSITY_CRITICAL;
-                    float freq = critical ? 3.0f : 1.0f;
-                    float pulse = (std::sin(t * freq * 6.283f) + 1.0f) * 0.5f;
-
-                    unsigned char alpha;
-                    Color flash_color;
-                    if (critical) {
-                        alpha = static_cast<unsigned char>(40 + pulse * 100);
-                        flash_color = {255, 40, 40, alpha};
-                    } else {
-                        alpha = static_cast<unsigned char>(pulse * 80);
-                        flash_color = {255, 140, 0, alpha};
-                    }
-                    draw_plane({x * TILESIZE, 0.04f, z * TILESIZE},
-                               {tile_size, tile_size}, flash_color);
-                }
+        // TAB-toggle heat map overlay
+        if (show_overlay) {
+            g_density_layers.heat_layer.draw(*vr, 0.05f,
+                                             {255, 255, 255, 255});
+
+            // Forecast: magenta inset deepens as the ETA to critical
+            // shrinks (tiles already critical flash below)
+            auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+            static const std::vector<int> NO_TILES;
+            const auto& tracked = cf ? cf->tracked : NO_TILES;
+            for (int idx : tracked) {
+                int x = idx % MAP_SIZE, z = idx / MAP_SIZE;
+                if (x < vr->min_x || x > vr->max_x || z < vr->min_z ||
+                    z > vr->max_z)
+                    continue;
+                if (grid->tiles[idx].agent_count <= 0) continue;
+                float ttc = cf->time_to_critical(idx);
+                if (ttc <= 0.f || ttc >= FORECAST_HORIZON) continue;
+                float urgency = 1.f - ttc / FORECAST_HORIZON;
+                float inset = tile_size * 0.6f;
+                auto alpha = static_cast<unsigned char>(60 + urgency * 160);
+                render_queue::plane({x * TILESIZE, 0.06f, z * TILESIZE},
+                                    {inset, inset}, Color{220, 0, 220, alpha});
             }
         }
+
+        // Always-on danger flash: >=75% density pulses orange at 1 Hz,
+        // critical tiles red at 3 Hz
+        auto pulse = [t](float freq) {
+            return (std::sin(t * freq * 6.283f) + 1.0f) * 0.5f;
+        };
+        g_density_layers.danger_layer.draw(
+            *vr, 0.04f,
+            {255, 255, 255, static_cast<unsigned char>(pulse(1.f) * 80)});
+        g_density_layers.critical_layer.draw(
+            *vr, 0.04f,
+            {255, 255, 255,
+             static_cast<unsigned char>(40 + pulse(3.f) * 100)});
     }
 };
 
@@ -628,8 +611,8 @@ struct RenderDeathMarkersSystem : System<DeathMarker> {
         float wx = dm.position.x;
         float wz = dm.position.y;
 
-        draw_line_3d({wx - s, y, wz - s}, {wx + s, y, wz + s}, color);
-        draw_line_3d({wx - s, y, wz + s}, {wx + s, y, wz - s}, color);
+        render_queue::line({wx - s, y, wz - s}, {wx + s, y, wz + s}, color);
+        render_queue::line({wx - s, y, wz + s}, {wx + s, y, wz - s}, color);
     }
 };
 
@@ -642,27 +625,34 @@ struct RenderParticlesSystem : System<Particle, Transform> {
         float life_t = 1.0f - (p.lifetime / p.max_lifetime);
         float y = 0.1f + life_t * 0.5f;
 
-        draw_cube({wx, y, wz}, s, s, s, p.color);
+        render_queue::cube({wx, y, wz}, s, s, s, p.color);
     }
 };
 
+// Draws everything the world systems queued this frame
 struct EndMode3DSystem : System<> {
     void once(float) const override {
         auto* cam = EntityHelper::get_singleton_cmp<ProvidesCamera>();
-        if (cam) end_3d();
+        if (!cam) {
+            // BeginRenderSystem never entered the 3D mode
+            render_queue::clear();
+            return;
+        }
+        render_queue::flush(cam->cam.camera);
+        end_3d();
     }
 };
 
 void register_render_world_systems(SystemManager& sm) {
-    sm.register_render_system(std::make_unique<BeginRenderSystem>());
-    sm.register_render_system(std::make_unique<RenderGridSystem>());
-    sm.register_render_system(std::make_unique<RenderStageGlowSystem>());
-    sm.register_render_system(std::make_unique<RenderAgentsSystem>());
-    sm.register_render_system(std::make_unique<RenderMediumLODSystem>());
-    sm.register_render_system(std::make_unique<RenderFarLODSystem>());
-    sm.register_render_system(std::make_unique<RenderDensitySystem>());
-    sm.register_render_system(std::make_unique<RenderDeathMarkersSystem>());
-    sm.register_render_system(std::make_unique<RenderParticlesSystem>());
-    sm.register_render_system(std::make_unique<RenderBuildPreviewSystem>());
-    sm.register_render_system(std::make_unique<EndMode3DSystem>());
+    sm.register_render_system(timed<BeginRenderSystem>());
+    sm.register_render_system(timed<RenderGridSystem>());
+    sm.register_render_system(timed<RenderStageGlowSystem>());
+    sm.register_render_system(timed<RenderAgentsSystem>());
+    sm.register_render_system(timed<RenderMediumLODSystem>());
+    sm.register_render_system(timed<RenderFarLODSystem>());
+    sm.register_render_system(timed<RenderDensitySystem>());
+    sm.register_render_system(timed<RenderDeathMarkersSystem>());
+    sm.register_render_system(timed<RenderParticlesSystem>());
+    sm.register_render_system(timed<RenderBuildPreviewSystem>());
+    sm.register_render_system(timed<EndMode3DSystem>());
 }
@@ -0,0 +1,384 @@
+// Replay domain: input recording, keyframes and headless seeking.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "engine/random_engine.h"
+#include "save_system.h"
+#include "state_hash.h"
+
+namespace replay {
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x50524445;  // "EDRP"
+// 2: actions and checkpoints written field by field (no struct padding)
+constexpr uint32_t VERSION = 2;
+// Longest recording a file may expand to (~77 hours at 60 ticks/s)
+constexpr size_t MAX_TICKS = size_t{1} << 24;
+
+struct Keyframe {
+    uint32_t tick = 0;
+    std::vector<uint8_t> image;  // save::encode_snapshot
+    RandomEngine::State rng;
+};
+
+struct Recorder {
+    Mode mode = Mode::Off;
+    bool seeking = false;
+    float keyframe_seconds = DEFAULT_KEYFRAME_SECONDS;
+
+    // elapsed[t] = sim seconds before tick t; dts[t] = dt of tick t
+    std::vector<float> dts;
+    std::vector<double> elapsed{0.0};
+    std::vector<Action> actions;  // sorted by tick
+    std::vector<Keyframe> keyframes;
+    // State hash at every keyframe taken while recording; re-simulation
+    // checks itself against these
+    struct Checkpoint {
+        uint32_t tick;
+        uint64_t hash;
+    };
+    std::vector<Checkpoint> checkpoints;
+
+    uint32_t current = 0;
+    uint32_t next = 0;
+    int64_t pending_seek = -1;
+
+    Stats stats;
+    std::function<void(float)> step;
+
+    void clear() {
+        dts.clear();
+        elapsed.assign(1, 0.0);
+        actions.clear();
+        keyframes.clear();
+        checkpoints.clear();
+        current = next = 0;
+        pending_seek = -1;
+        stats = {};
+    }
+
+    void capture_keyframe(uint32_t tick) {
+        Keyframe kf;
+        kf.tick = tick;
+        kf.image = save::encode_snapshot(save::capture_snapshot());
+        kf.rng = RandomEngine::save_state();
+        stats.keyframe_bytes += kf.image.size();
+        keyframes.push_back(std::move(kf));
+        stats.keyframes = (uint32_t) keyframes.size();
+        if (mode != Mode::Playing) {
+            checkpoints.push_back({tick, state_hash::compute()});
+        }
+    }
+
+    void verify(uint32_t tick) {
+        auto it = std::lower_bound(
+            checkpoints.begin(), checkpoints.end(), tick,
+            [](const Checkpoint& c, uint32_t t) { return c.tick < t; });
+        if (it == checkpoints.end() || it->tick != tick) return;
+        stats.verified++;
+        uint64_t hash = state_hash::compute();
+        if (hash != it->hash) {
+            stats.desyncs++;
+            log_warn("Replay: desync at tick {} ({:016x} != {:016x})", tick,
+                     hash, it->hash);
+        }
+    }
+
+    // Keyframes are only ever appended past the newest one, so playback
+    // after a seek fills in the ones a loaded file does not carry
+    void maybe_keyframe(uint32_t tick) {
+        if (keyframes.empty() || tick <= keyframes.back().tick) return;
+        if (tick >= elapsed.size()) return;
+        double since = elapsed[tick] - elapsed[keyframes.back().tick];
+        if (since >= keyframe_seconds) capture_keyframe(tick);
+    }
+
+    bool restore(const Keyframe& kf) {
+        if (!save::load_game_from_memory(kf.image.data(), kf.image.size()))
+            return false;
+        RandomEngine::restore_state(kf.rng);
+        return true;
+    }
+};
+
+Recorder& rec() {
+    static Recorder r;
+    return r;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Serialized sizes: fields are written one by one, packed
+constexpr size_t ACTION_BYTES = sizeof(uint32_t) + 2 * sizeof(uint8_t) +
+                                4 * sizeof(int16_t);
+constexpr size_t CHECKPOINT_BYTES = sizeof(uint32_t) + sizeof(uint64_t);
+
+void put_action(save::ByteWriter& w, const Action& a) {
+    w.put(a.tick);
+    w.put((uint8_t) a.kind);
+    w.put(a.value);
+    w.put(a.x0);
+    w.put(a.z0);
+    w.put(a.x1);
+    w.put(a.z1);
+}
+
+Action get_action(save::ByteReader& in) {
+    Action a;
+    a.tick = in.get<uint32_t>();
+    a.kind = static_cast<ActionKind>(in.get<uint8_t>());
+    a.value = in.get<uint8_t>();
+    a.x0 = in.get<int16_t>();
+    a.z0 = in.get<int16_t>();
+    a.x1 = in.get<int16_t>();
+    a.z1 = in.get<int16_t>();
+    return a;
+}
+
+}  // namespace
+
+void start_recording(float keyframe_seconds) {
+    auto& r = rec();
+    r.clear();
+    r.keyframe_seconds = std::max(0.5f, keyframe_seconds);
+    r.capture_keyframe(0);
+    r.mode = Mode::Recording;
+    log_info("Replay: recording (keyframe every {}s)", r.keyframe_seconds);
+}
+
+void stop() {
+    auto& r = rec();
+    if (r.mode == Mode::Off) return;
+    log_info("Replay: stopped at tick {} of {}", r.next, length());
+    r.mode = Mode::Off;
+}
+
+Mode mode() { return rec().mode; }
+bool is_recording() { return rec().mode == Mode::Recording; }
+bool is_playing() { return rec().mode == Mode::Playing; }
+bool is_seeking() { return rec().seeking; }
+
+void begin_tick(float dt) {
+    auto& r = rec();
+    if (r.mode == Mode::Off) return;
+
+    r.current = r.next;
+    if (r.mode == Mode::Playing && r.current >= r.dts.size()) {
+        log_info("Replay: end of recording at tick {}", r.current);
+        r.mode = Mode::Off;
+        return;
+    }
+    if (r.mode == Mode::Playing) r.verify(r.current);
+    r.maybe_keyframe(r.current);
+
+    if (r.mode == Mode::Recording) {
+        r.dts.push_back(dt);
+        r.elapsed.push_back(r.elapsed.back() + dt);
+        r.stats.ticks = (uint32_t) r.dts.size();
+    } else {
+        // Speed changes act before the clock advances
+        for_each_due(ActionKind::SetSpeed, [](const Action& a) {
+            auto* clock =
+                afterhours::EntityHelper::get_singleton_cmp<GameClock>();
+            if (clock) clock->speed = static_cast<GameSpeed>(a.value);
+        });
+    }
+    r.next = r.current + 1;
+}
+
+uint32_t current_tick() { return rec().current; }
+uint32_t length() { return (uint32_t) rec().dts.size(); }
+
+void record(Action action) {
+    auto& r = rec();
+    if (r.mode != Mode::Recording) return;
+    action.tick = r.current;
+    r.actions.push_back(action);
+    r.stats.actions = (uint32_t) r.actions.size();
+}
+
+void record_between_ticks(Action action) {
+    auto& r = rec();
+    if (r.mode != Mode::Recording) return;
+    action.tick = r.next;
+    r.actions.push_back(action);
+    r.stats.actions = (uint32_t) r.actions.size();
+}
+
+void for_each_due(ActionKind kind,
+                  const std::function<void(const Action&)>& fn) {
+    auto& r = rec();
+    if (r.mode != Mode::Playing) return;
+    auto it = std::lower_bound(
+        r.actions.begin(), r.actions.end(), r.current,
+        [](const Action& a, uint32_t tick) { return a.tick < tick; });
+    for (; it != r.actions.end() && it->tick == r.current; ++it) {
+        if (it->kind == kind) fn(*it);
+    }
+}
+
+void set_step_fn(std::function<void(float)> step) {
+    rec().step = std::move(step);
+}
+
+void request_seek(uint32_t tick) { rec().pending_seek = tick; }
+
+bool service_seek() {
+    auto& r = rec();
+    if (r.pending_seek < 0) return true;
+    uint32_t target = (uint32_t) std::min<int64_t>(r.pending_seek, length());
+    r.pending_seek = -1;
+    if (r.keyframes.empty() || !r.step) {
+        log_warn("Replay: nothing to seek in");
+        return false;
+    }
+
+    auto start = Clock::now();
+    auto kf = std::upper_bound(
+        r.keyframes.begin(), r.keyframes.end(), target,
+        [](uint32_t tick, const Keyframe& k) { return tick < k.tick; });
+    const Keyframe& from = *std::prev(kf);
+    if (!r.restore(from)) {
+        log_warn("Replay: keyframe at tick {} failed to load", from.tick);
+        return false;
+    }
+
+    r.mode = Mode::Playing;
+    r.next = from.tick;
+    r.seeking = true;
+    while (r.next < target) r.step(r.dts[r.next]);
+    r.seeking = false;
+
+    r.stats.last_seek_ticks = target - from.tick;
+    r.stats.last_seek_ms =
+        std::chrono::duration<float, std::milli>(Clock::now() - start)
+            .count();
+    log_info("Replay: seek to tick {} (keyframe {}, {} ticks in {:.1f}ms)",
+             target, from.tick, r.stats.last_seek_ticks,
+             r.stats.last_seek_ms);
+    return true;
+}
+
+float playback_dt(float live_dt) {
+    auto& r = rec();
+    if (r.mode != Mode::Playing || r.next >= r.dts.size()) return live_dt;
+    return r.dts[r.next];
+}
+
+bool write_file(const std::string& path) {
+    auto& r = rec();
+    if (r.keyframes.empty()) return false;
+    const Keyframe& first = r.keyframes.front();
+
+    save::ByteWriter w;
+    w.put(MAGIC);
+    w.put(VERSION);
+    w.put(r.keyframe_seconds);
+    w.put_string(first.rng.seed);
+    w.put_string(RandomEngine::state_to_text(first.rng));
+    w.put<uint32_t>((uint32_t) first.image.size());
+    w.put_array(first.image.data(), first.image.size());
+
+    // dt runs: a fixed-step session is a single run
+    std::vector<std::pair<uint32_t, float>> runs;
+    for (float dt : r.dts) {
+        if (!runs.empty() && runs.back().second == dt) {
+            runs.back().first++;
+        } else {
+            runs.push_back({1, dt});
+        }
+    }
+    w.put<uint32_t>((uint32_t) runs.size());
+    for (auto [count, dt] : runs) {
+        w.put(count);
+        w.put(dt);
+    }
+    w.put<uint32_t>((uint32_t) r.actions.size());
+    for (const Action& a : r.actions) put_action(w, a);
+    w.put<uint32_t>((uint32_t) r.checkpoints.size());
+    for (const auto& c : r.checkpoints) {
+        w.put(c.tick);
+        w.put(c.hash);
+    }
+    return save::write_file_atomic(path, w.buf);
+}
+
+bool load_file(const std::string& path) {
+    MappedFile file(path);
+    if (!file.is_open()) return false;
+    save::ByteReader in{file.data(), file.size()};
+    if (in.get<uint32_t>() != MAGIC || in.get<uint32_t>() != VERSION)
+        return false;
+
+    auto& r = rec();
+    r.clear();
+    r.mode = Mode::Off;
+    // Every count is checked against the bytes left before anything is
+    // sized from it, so a truncated or corrupt file fails cleanly
+    auto fail = [&]() {
+        r.clear();
+        log_warn("Replay: {} is truncated or corrupt", path);
+        return false;
+    };
+    r.keyframe_seconds = in.get<float>();
+    // 0, negative or NaN would take a keyframe every tick
+    if (!std::isfinite(r.keyframe_seconds) || r.keyframe_seconds <= 0.f)
+        return fail();
+
+    Keyframe first;
+    first.rng.seed = in.get_string();
+    if (!RandomEngine::state_from_text(in.get_string(), first.rng))
+        return fail();
+    uint32_t image_size = in.get<uint32_t>();
+    if (image_size > in.remaining()) return fail();
+    first.image.resize(image_size);
+    in.get_array(first.image.data(), first.image.size());
+
+    uint32_t run_count = in.get<uint32_t>();
+    constexpr size_t RUN_BYTES = sizeof(uint32_t) + sizeof(float);
+    if (run_count > in.remaining() / RUN_BYTES) return fail();
+    for (uint32_t i = 0; i < run_count && in.ok; i++) {
+        uint32_t count = in.get<uint32_t>();
+        float dt = in.get<float>();
+        if (count > MAX_TICKS - r.dts.size()) return fail();
+        for (uint32_t k = 0; k < count; k++) {
+            r.dts.push_back(dt);
+            r.elapsed.push_back(r.elapsed.back() + dt);
+        }
+    }
+    uint32_t action_count = in.get<uint32_t>();
+    if (action_count > in.remaining() / ACTION_BYTES) return fail();
+    r.actions.reserve(action_count);
+    for (uint32_t i = 0; i < action_count; i++)
+        r.actions.push_back(get_action(in));
+    uint32_t checkpoint_count = in.get<uint32_t>();
+    if (checkpoint_count > in.remaining() / CHECKPOINT_BYTES) return fail();
+    r.checkpoints.reserve(checkpoint_count);
+    for (uint32_t i = 0; i < checkpoint_count; i++) {
+        Recorder::Checkpoint c;
+        c.tick = in.get<uint32_t>();
+        c.hash = in.get<uint64_t>();
+        r.checkpoints.push_back(c);
+    }
+    if (!in.ok) return fail();
+
+    r.stats.keyframe_bytes = first.image.size();
+    r.keyframes.push_back(std::move(first));
+    r.stats.keyframes = 1;
+    r.stats.ticks = (uint32_t) r.dts.size();
+    r.stats.actions = (uint32_t) r.actions.size();
+    request_seek(0);
+    return true;
+}
+
+Stats stats() { return rec().stats; }
+
+}  // namespace replay
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Deterministic replay: record what the player did, not what the sim did.
+//
+// A recording holds the starting state (keyframe 0), the dt of every sim
+// tick, and the player's inputs stamped with the tick they took effect
+// on: build actions and speed changes. Everything else is re-derived by
+// re-running the simulation, which is deterministic for a given state,
+// RNG state and dt sequence (see state_hash.h).
+//
+// While recording or playing, a full keyframe (an in-memory save image
+// plus the global RNG state) is taken every `keyframe_seconds` of sim
+// time. Seeking loads the nearest keyframe at or before the target and
+// re-simulates the remaining ticks headlessly (update systems only, no
+// rendering), so any point of a festival is a bounded number of ticks
+// away. While playing, player input is ignored and recorded actions are
+// applied instead. Keyframes taken while recording also store a state
+// hash; any re-simulation that reaches one checks itself against it.
+namespace replay {
+
+constexpr float DEFAULT_KEYFRAME_SECONDS = 10.f;
+
+enum class Mode { Off, Recording, Playing };
+
+enum class ActionKind : uint8_t { Build, SetSpeed };
+
+struct Action {
+    uint32_t tick = 0;
+    ActionKind kind = ActionKind::Build;
+    uint8_t value = 0;  // BuildTool or GameSpeed
+    int16_t x0 = 0, z0 = 0, x1 = 0, z1 = 0;
+};
+
+struct Stats {
+    uint32_t ticks = 0;
+    uint32_t actions = 0;
+    uint32_t keyframes = 0;
+    size_t keyframe_bytes = 0;
+    uint32_t last_seek_ticks = 0;  // ticks re-simulated by the last seek
+    float last_seek_ms = 0.f;
+    uint32_t verified = 0;  // checkpoints re-simulation reached
+    uint32_t desyncs = 0;   // ... whose state hash differed
+};
+
+// Start recording from the current state (captures keyframe 0)
+void start_recording(float keyframe_seconds = DEFAULT_KEYFRAME_SECONDS);
+// Stop recording or playback; the recording stays available for seeks
+void stop();
+[[nodiscard]] Mode mode();
+[[nodiscard]] bool is_recording();
+[[nodiscard]] bool is_playing();
+[[nodiscard]] bool is_seeking();
+
+// Called first thing every sim tick
+void begin_tick(float dt);
+// Tick currently being simulated, and recorded length in ticks
+[[nodiscard]] uint32_t current_tick();
+[[nodiscard]] uint32_t length();
+
+// Log a player input for the current tick. Inputs applied between ticks
+// (UI clicks during render) take effect on the next one.
+void record(Action action);
+void record_between_ticks(Action action);
+
+// Playback: recorded actions of `kind` for the current tick, in order
+void for_each_due(ActionKind kind,
+                  const std::function<void(const Action&)>& fn);
+
+// Runs one headless sim tick (update systems only); set up by main
+void set_step_fn(std::function<void(float)> step);
+
+// Seek to the state before `tick`. Deferred to service_seek() so the
+// re-simulation never runs from inside a system.
+void request_seek(uint32_t tick);
+// Main loop, between frames. False if a pending seek failed.
+bool service_seek();
+
+// Playing: the recorded dt for the coming tick; otherwise `live_dt`
+[[nodiscard]] float playback_dt(float live_dt);
+
+// Compact file: keyframe 0, RNG state, dt runs and actions. Loading
+// rewinds to tick 0 and starts playback.
+bool write_file(const std::string& path);
+bool load_file(const std::string& path);
+
+[[nodiscard]] Stats stats();
+
+}  // namespace replay
@@ -1,21 +1,39 @@
 #pragma once
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <optional>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "afterhours/src/core/entity_helper.h"
 #include "afterhours/src/core/entity_query.h"
 #include "components.h"
+#include "engine/compress.h"
+#include "engine/mapped_file.h"
+#include "engine/random_engine.h"
 #include "game.h"
 
 namespace save {
 
-static constexpr const char* SAVE_DIR = "saves";
-static constexpr const char* SAVE_FILE = "saves/game.sav";
-static constexpr const char* META_FILE = "saves/meta.dat";
+static constexpr const char* DEFAULT_SAVE_DIR = "saves";
+
+// Directory for saves, meta progress and autosaves (--save-dir). Parallel
+// test runs give each process its own so they never share files.
+inline std::string& save_dir_storage() {
+    static std::string dir = DEFAULT_SAVE_DIR;
+    return dir;
+}
+inline const std::string& save_dir() { return save_dir_storage(); }
+inline void set_save_dir(const std::string& dir) { save_dir_storage() = dir; }
+inline std::string save_file() { return save_dir() + "/game.sav"; }
+inline std::string meta_file() { return save_dir() + "/meta.dat"; }
 static constexpr uint32_t SAVE_MAGIC = 0xEDC10001;
-static constexpr uint32_t SAVE_VERSION = 1;  // Increment on schema changes
+// Container version. 1 = legacy flat stream (still loadable), 2 = section
+// table. Schema changes bump the affected section's version instead.
+static constexpr uint32_t SAVE_VERSION = 2;
 
 // Meta-progression: persists across sessions
 struct MetaProgress {
@@ -28,8 +46,9 @@ struct MetaProgress {
 };
 
 inline bool save_meta(const MetaProgress& meta) {
-    std::filesystem::create_directories(SAVE_DIR);
-    std::ofstream f(META_FILE, std::ios::binary);
+    std::error_code ec;
+    std::filesystem::create_directories(save_dir(), ec);
+    std::ofstream f(meta_file(), std::ios::binary);
     if (!f) return false;
     f.write(reinterpret_cast<const char*>(&SAVE_MAGIC), sizeof(SAVE_MAGIC));
     f.write(reinterpret_cast<const char*>(&meta), sizeof(MetaProgress));
@@ -37,7 +56,7 @@ inline bool save_meta(const MetaProgress& meta) {
 }
 
 inline bool load_meta(MetaProgress& meta) {
-    std::ifstream f(META_FILE, std::ios::binary);
+    std::ifstream f(meta_file(), std::ios::binary);
     if (!f) return false;
     uint32_t magic = 0;
     f.read(reinterpret_cast<char*>(&magic), sizeof(magic));
@@ -46,110 +65,883 @@ inline bool load_meta(MetaProgress& meta) {
     return f.good();
 }
 
-// Save game state to binary file
-inline bool save_game() {
-    std::filesystem::create_directories(SAVE_DIR);
-    std::ofstream f(SAVE_FILE, std::ios::binary);
-    if (!f) return false;
+// ── Sectioned format (version 2) ─────────────────────────────────────────
+//
+//   u32 magic, u32 SAVE_VERSION, u32 section_count
+//   section_count x { u32 id, u16 version, u16 flags,
+//                     u32 offset, u32 stored_size, u32 raw_size }
+//   payloads
+//
+// Each section is built in memory and written with one call. Grid planes
+// and agent columns are stored planar (one array per field), which the
+// LZ codec in engine/compress.h shrinks well. Unknown sections are skipped
+// and sections newer than this build understands are ignored with a
+// warning, so old builds can still open newer saves where possible.
 
-    f.write(reinterpret_cast<const char*>(&SAVE_MAGIC), sizeof(SAVE_MAGIC));
-    f.write(reinterpret_cast<const char*>(&SAVE_VERSION), sizeof(SAVE_VERSION));
+constexpr uint32_t fourcc(const char (&s)[5]) {
+    return (uint32_t) s[0] | ((uint32_t) s[1] << 8) | ((uint32_t) s[2] << 16) |
+           ((uint32_t) s[3] << 24);
+}
 
-    // Grid tiles
-    auto* grid = afterhours::EntityHelper::get_singleton_cmp<Grid>();
-    if (!grid) return false;
-    for (int z = 0; z < MAP_SIZE; z++) {
-        for (int x = 0; x < MAP_SIZE; x++) {
-            auto& tile = grid->at(x, z);
-            auto type = static_cast<uint8_t>(tile.type);
-            f.write(reinterpret_cast<const char*>(&type), 1);
-            f.write(reinterpret_cast<const char*>(&tile.agent_count),
-                    sizeof(int));
-            f.write(reinterpret_cast<const char*>(tile.pheromone.data()), 5);
+namespace section {
+constexpr uint32_t GRID = fourcc("GRID");
+constexpr uint32_t GAME = fourcc("GAME");
+constexpr uint32_t SCHEDULE = fourcc("SCHD");
+constexpr uint32_t EVENTS = fourcc("EVNT");
+constexpr uint32_t AGENTS = fourcc("AGNT");
+constexpr uint32_t MACRO = fourcc("MACR");
+constexpr uint32_t RNG = fourcc("RAND");
+
+// Current schema version of each section
+constexpr uint16_t GRID_VERSION = 1;
+constexpr uint16_t GAME_VERSION = 1;
+constexpr uint16_t SCHEDULE_VERSION = 1;
+constexpr uint16_t EVENTS_VERSION = 1;
+constexpr uint16_t AGENTS_VERSION = 1;
+constexpr uint16_t MACRO_VERSION = 1;
+constexpr uint16_t RNG_VERSION = 1;
+
+constexpr uint16_t FLAG_COMPRESSED = 1;
+constexpr size_t ENTRY_SIZE = 20;
+}  // namespace section
+
+struct ByteWriter {
+    std::vector<uint8_t> buf;
+
+    template<typename T>
+    void put(const T& v) {
+        put_array(&v, 1);
+    }
+    template<typename T>
+    void put_array(const T* data, size_t n) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        size_t at = buf.size();
+        buf.resize(at + n * sizeof(T));
+        if (n) std::memcpy(buf.data() + at, data, n * sizeof(T));
+    }
+    void put_string(const std::string& str) {
+        put<uint32_t>((uint32_t) str.size());
+        put_array(str.data(), str.size());
+    }
+};
+
+// Column of Ts inside a byte buffer; elements may be unaligned
+template<typename T>
+struct ColumnView {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const uint8_t* p = nullptr;
+    size_t count = 0;
+
+    T operator[](size_t i) const {
+        T v;
+        std::memcpy(&v, p + i * sizeof(T), sizeof(T));
+        return v;
+    }
+};
+
+struct ByteReader {
+    const uint8_t* p = nullptr;
+    size_t n = 0;
+    size_t at = 0;
+    bool ok = true;
+
+    [[nodiscard]] size_t remaining() const { return ok ? n - at : 0; }
+
+    template<typename T>
+    T get() {
+        T v{};
+        get_array(&v, 1);
+        return v;
+    }
+    template<typename T>
+    void get_array(T* out, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        size_t bytes = count * sizeof(T);
+        if (!ok || bytes > n - at) {
+            ok = false;
+            return;
+        }
+        if (bytes) std::memcpy(out, p + at, bytes);
+        at += bytes;
+    }
+    // Zero-copy view of the next `count` Ts (mapped file or decode buffer)
+    template<typename T>
+    ColumnView<T> view(size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (!ok || bytes > n - at) {
+            ok = false;
+            return {};
+        }
+        ColumnView<T> col{p + at, count};
+        at += bytes;
+        return col;
+    }
+    std::string get_string() {
+        uint32_t len = get<uint32_t>();
+        if (!ok || len > n - at) {
+            ok = false;
+            return {};
         }
+        std::string str(reinterpret_cast<const char*>(p + at), len);
+        at += len;
+        return str;
     }
+};
 
-    // Game state
-    auto* gs = afterhours::EntityHelper::get_singleton_cmp<GameState>();
-    if (gs) {
-        auto status = static_cast<uint8_t>(gs->status);
-        f.write(reinterpret_cast<const char*>(&status), 1);
-        f.write(reinterpret_cast<const char*>(&gs->game_time), sizeof(float));
-        f.write(reinterpret_cast<const char*>(&gs->death_count), sizeof(int));
-        f.write(reinterpret_cast<const char*>(&gs->total_agents_served),
-                sizeof(int));
-        f.write(reinterpret_cast<const char*>(&gs->time_survived),
-                sizeof(float));
-        f.write(reinterpret_cast<const char*>(&gs->max_attendees), sizeof(int));
-        f.write(reinterpret_cast<const char*>(&gs->agents_exited), sizeof(int));
-        f.write(reinterpret_cast<const char*>(&gs->carryover_count),
-                sizeof(int));
-        f.write(reinterpret_cast<const char*>(&gs->speed_multiplier),
-                sizeof(float));
+// Gather one field of every agent into a contiguous column
+template<typename T, typename Fn>
+inline void put_column(ByteWriter& w,
+                       const std::vector<afterhours::Entity*>& agents,
+                       Fn field) {
+    std::vector<T> col(agents.size());
+    for (size_t i = 0; i < agents.size(); i++) col[i] = field(*agents[i]);
+    w.put_array(col.data(), col.size());
+}
+
+namespace agent_flags {
+constexpr uint8_t NEEDS_BATHROOM = 1 << 0;
+constexpr uint8_t NEEDS_FOOD = 1 << 1;
+constexpr uint8_t WATCHING = 1 << 2;
+constexpr uint8_t SERVICED = 1 << 3;
+constexpr uint8_t DEPOSITOR = 1 << 4;
+constexpr uint8_t CARRYOVER = 1 << 5;
+constexpr uint8_t HAS_NEEDS = 1 << 6;
+constexpr uint8_t HAS_HEALTH = 1 << 7;
+}  // namespace agent_flags
+
+inline void write_grid(ByteWriter& w, const Grid& grid) {
+    constexpr size_t N = MAP_SIZE * MAP_SIZE;
+    std::vector<uint8_t> plane(N);
+    for (size_t i = 0; i < N; i++) plane[i] = (uint8_t) grid.tiles[i].type;
+    w.put_array(plane.data(), N);
+
+    std::vector<int32_t> counts(N);
+    for (size_t i = 0; i < N; i++) counts[i] = grid.tiles[i].agent_count;
+    w.put_array(counts.data(), N);
+
+    for (size_t c = 0; c < 5; c++) {
+        for (size_t i = 0; i < N; i++) plane[i] = grid.tiles[i].pheromone[c];
+        w.put_array(plane.data(), N);
     }
+    w.put(grid.pheromone_decay_timer);
+}
 
-    // Game clock
-    auto* clock = afterhours::EntityHelper::get_singleton_cmp<GameClock>();
-    if (clock) {
-        f.write(reinterpret_cast<const char*>(&clock->game_time_minutes),
-                sizeof(float));
-        auto spd = static_cast<uint8_t>(clock->speed);
-        f.write(reinterpret_cast<const char*>(&spd), 1);
+// Decoded GRID section (views into the image), applied by apply_grid
+struct GridData {
+    ColumnView<uint8_t> types;
+    ColumnView<int32_t> counts;
+    std::array<ColumnView<uint8_t>, 5> phero;
+    float decay_timer = 0.f;
+};
+
+inline bool read_grid(ByteReader& r, GridData& out) {
+    constexpr size_t N = MAP_SIZE * MAP_SIZE;
+    out.types = r.view<uint8_t>(N);
+    out.counts = r.view<int32_t>(N);
+    for (auto& plane : out.phero) plane = r.view<uint8_t>(N);
+    out.decay_timer = r.get<float>();
+    return r.ok;
+}
+
+inline void apply_grid(const GridData& in, Grid& grid) {
+    constexpr size_t N = MAP_SIZE * MAP_SIZE;
+    for (size_t i = 0; i < N; i++) {
+        Tile& t = grid.tiles[i];
+        t.type = static_cast<TileType>(in.types[i]);
+        t.agent_count = in.counts[i];
+        for (size_t c = 0; c < 5; c++) t.pheromone[c] = in.phero[c][i];
     }
+    grid.pheromone_decay_timer = in.decay_timer;
+    grid.mark_tiles_dirty();
+    grid.bump_density_version();
+}
 
-    // Difficulty
-    auto* diff = afterhours::EntityHelper::get_singleton_cmp<DifficultyState>();
-    if (diff) {
-        f.write(reinterpret_cast<const char*>(&diff->day_number), sizeof(int));
-        f.write(reinterpret_cast<const char*>(&diff->spawn_rate_mult),
-                sizeof(float));
-        f.write(reinterpret_cast<const char*>(&diff->crowd_size_mult),
-                sizeof(float));
+inline void write_game(ByteWriter& w) {
+    using afterhours::EntityHelper;
+    auto* gs = EntityHelper::get_singleton_cmp<GameState>();
+    GameState g = gs ? *gs : GameState{};
+    w.put((uint8_t) g.status);
+    w.put(g.game_time);
+    w.put(g.death_count);
+    w.put(g.total_agents_served);
+    w.put(g.time_survived);
+    w.put(g.max_attendees);
+    w.put(g.agents_exited);
+    w.put(g.carryover_count);
+    w.put(g.speed_multiplier);
+
+    auto* clock = EntityHelper::get_singleton_cmp<GameClock>();
+    w.put(clock ? clock->game_time_minutes : 600.f);
+    w.put((uint8_t) (clock ? clock->speed : GameSpeed::OneX));
+    w.put(clock ? clock->debug_time_mult : 0.f);
+
+    auto* diff = EntityHelper::get_singleton_cmp<DifficultyState>();
+    DifficultyState d = diff ? *diff : DifficultyState{};
+    w.put(d.day_number);
+    w.put(d.spawn_rate_mult);
+    w.put(d.crowd_size_mult);
+    w.put(d.event_timer);
+    w.put(d.next_event_time);
+
+    auto* ss = EntityHelper::get_singleton_cmp<SpawnState>();
+    SpawnState sp = ss ? *ss : SpawnState{};
+    w.put(sp.interval);
+    w.put(sp.timer);
+    w.put((uint8_t) sp.enabled);
+    w.put((uint8_t) sp.manual_override);
+
+    auto* slots = EntityHelper::get_singleton_cmp<FacilitySlots>();
+    FacilitySlots fs = slots ? *slots : FacilitySlots{};
+    w.put(fs.stages_placed);
+    w.put(fs.bathrooms_placed);
+    w.put(fs.food_placed);
+    w.put(fs.gates_placed);
+
+    w.put<uint64_t>(RandomEngine::stream_count());
+}
+
+// Decoded GAME section, applied by apply_game
+struct GameData {
+    GameState g;
+    float minutes = 0.f;
+    GameSpeed speed = GameSpeed::OneX;
+    float debug_mult = 0.f;
+    DifficultyState d;
+    SpawnState sp;
+    FacilitySlots fs;
+    uint64_t streams = 0;
+};
+
+inline bool read_game(ByteReader& r, GameData& out) {
+    GameState& g = out.g;
+    g.status = static_cast<GameStatus>(r.get<uint8_t>());
+    g.game_time = r.get<float>();
+    g.death_count = r.get<int>();
+    g.total_agents_served = r.get<int>();
+    g.time_survived = r.get<float>();
+    g.max_attendees = r.get<int>();
+    g.agents_exited = r.get<int>();
+    g.carryover_count = r.get<int>();
+    g.speed_multiplier = r.get<float>();
+
+    out.minutes = r.get<float>();
+    out.speed = static_cast<GameSpeed>(r.get<uint8_t>());
+    out.debug_mult = r.get<float>();
+
+    DifficultyState& d = out.d;
+    d.day_number = r.get<int>();
+    d.spawn_rate_mult = r.get<float>();
+    d.crowd_size_mult = r.get<float>();
+    d.event_timer = r.get<float>();
+    d.next_event_time = r.get<float>();
+
+    SpawnState& sp = out.sp;
+    sp.interval = r.get<float>();
+    sp.timer = r.get<float>();
+    sp.enabled = r.get<uint8_t>() != 0;
+    sp.manual_override = r.get<uint8_t>() != 0;
+
+    FacilitySlots& fs = out.fs;
+    fs.stages_placed = r.get<int>();
+    fs.bathrooms_placed = r.get<int>();
+    fs.food_placed = r.get<int>();
+    fs.gates_placed = r.get<int>();
+
+    out.streams = r.get<uint64_t>();
+    return r.ok;
+}
+
+inline void apply_game(const GameData& in) {
+    using afterhours::EntityHelper;
+    const GameState& g = in.g;
+    if (auto* gs = EntityHelper::get_singleton_cmp<GameState>()) {
+        gs->status = g.status;
+        gs->game_time = g.game_time;
+        gs->death_count = g.death_count;
+        gs->total_agents_served = g.total_agents_served;
+        gs->time_survived = g.time_survived;
+        gs->max_attendees = g.max_attendees;
+        gs->agents_exited = g.agents_exited;
+        gs->carryover_count = g.carryover_count;
+        gs->speed_multiplier = g.speed_multiplier;
     }
+    if (auto* clock = EntityHelper::get_singleton_cmp<GameClock>()) {
+        clock->game_time_minutes = in.minutes;
+        clock->speed = in.speed;
+        clock->debug_time_mult = in.debug_mult;
+    }
+    if (auto* diff = EntityHelper::get_singleton_cmp<DifficultyState>()) {
+        diff->day_number = in.d.day_number;
+        diff->spawn_rate_mult = in.d.spawn_rate_mult;
+        diff->crowd_size_mult = in.d.crowd_size_mult;
+        diff->event_timer = in.d.event_timer;
+        diff->next_event_time = in.d.next_event_time;
+    }
+    if (auto* ss = EntityHelper::get_singleton_cmp<SpawnState>()) {
+        ss->interval = in.sp.interval;
+        ss->timer = in.sp.timer;
+        ss->enabled = in.sp.enabled;
+        ss->manual_override = in.sp.manual_override;
+    }
+    if (auto* slots = EntityHelper::get_singleton_cmp<FacilitySlots>()) {
+        slots->stages_placed = in.fs.stages_placed;
+        slots->bathrooms_placed = in.fs.bathrooms_placed;
+        slots->food_placed = in.fs.food_placed;
+        slots->gates_placed = in.fs.gates_placed;
+    }
+    RandomEngine::set_stream_count(in.streams);
+}
+
+inline void write_schedule(ByteWriter& w, const ArtistSchedule& sched) {
+    w.put(sched.look_ahead);
+    w.put((uint8_t) sched.stage_state);
+    w.put(sched.current_artist_idx);
+    w.put<uint32_t>((uint32_t) sched.schedule.size());
+    for (const auto& a : sched.schedule) {
+        w.put_string(a.name);
+        w.put(a.start_time_minutes);
+        w.put(a.duration_minutes);
+        w.put(a.expected_crowd);
+        w.put((uint8_t) ((a.announced ? 1 : 0) | (a.performing ? 2 : 0) |
+                         (a.finished ? 4 : 0)));
+    }
+}
+
+inline bool read_schedule(ByteReader& r, ArtistSchedule& sched) {
+    ArtistSchedule in;
+    in.look_ahead = r.get<int>();
+    in.stage_state = static_cast<StageState>(r.get<uint8_t>());
+    in.current_artist_idx = r.get<int>();
+    uint32_t count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; i++) {
+        ScheduledArtist a;
+        a.name = r.get_string();
+        a.start_time_minutes = r.get<float>();
+        a.duration_minutes = r.get<float>();
+        a.expected_crowd = r.get<int>();
+        uint8_t flags = r.get<uint8_t>();
+        a.announced = flags & 1;
+        a.performing = flags & 2;
+        a.finished = flags & 4;
+        in.schedule.push_back(std::move(a));
+    }
+    if (!r.ok) return false;
+    sched.look_ahead = in.look_ahead;
+    sched.stage_state = in.stage_state;
+    sched.current_artist_idx = in.current_artist_idx;
+    sched.schedule = std::move(in.schedule);
+    return true;
+}
 
-    // Agent count + positions
-    auto agents = afterhours::EntityQuery()
-                      .whereHasComponent<Agent>()
-                      .whereHasComponent<Transform>()
+inline void write_events(ByteWriter& w) {
+    auto events = afterhours::EntityQuery()
+                      .whereHasComponent<ActiveEvent>()
                       .gen();
-    int agent_count = static_cast<int>(agents.size());
-    f.write(reinterpret_cast<const char*>(&agent_count), sizeof(int));
-    for (afterhours::Entity& a_entity : agents) {
-        auto& agent = a_entity.get<Agent>();
-        auto& tf = a_entity.get<Transform>();
-        auto want = static_cast<uint8_t>(agent.want);
-        f.write(reinterpret_cast<const char*>(&want), 1);
-        f.write(reinterpret_cast<const char*>(&tf.position.x), sizeof(float));
-        f.write(reinterpret_cast<const char*>(&tf.position.y), sizeof(float));
-        f.write(reinterpret_cast<const char*>(&agent.target_grid_x),
-                sizeof(int));
-        f.write(reinterpret_cast<const char*>(&agent.target_grid_z),
-                sizeof(int));
-        f.write(reinterpret_cast<const char*>(&agent.color_idx), 1);
-
-        float hp = 1.0f;
-        if (!a_entity.is_missing<AgentHealth>()) {
-            hp = a_entity.get<AgentHealth>().hp;
+    w.put<uint32_t>((uint32_t) events.size());
+    for (afterhours::Entity& e : events) {
+        const auto& ev = e.get<ActiveEvent>();
+        w.put((uint8_t) ev.type);
+        w.put(ev.duration);
+        w.put(ev.elapsed);
+        w.put((uint8_t) ev.notified);
+        w.put_string(ev.description);
+    }
+}
+
+inline bool read_events(ByteReader& r, std::vector<ActiveEvent>& out) {
+    uint32_t count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; i++) {
+        ActiveEvent ev;
+        ev.type = static_cast<EventType>(r.get<uint8_t>());
+        ev.duration = r.get<float>();
+        ev.elapsed = r.get<float>();
+        ev.notified = r.get<uint8_t>() != 0;
+        ev.description = r.get_string();
+        if (r.ok) out.push_back(std::move(ev));
+    }
+    return r.ok;
+}
+
+// Replaces the live events
+inline void apply_events(std::vector<ActiveEvent>& events) {
+    auto old = afterhours::EntityQuery()
+                   .whereHasComponent<ActiveEvent>()
+                   .gen();
+    for (afterhours::Entity& e : old) e.cleanup = true;
+    afterhours::EntityHelper::cleanup();
+
+    for (auto& ev : events) {
+        auto& e = afterhours::EntityHelper::createEntity();
+        telemetry::bump(telemetry::EntitiesCreated);
+        e.addComponent<ActiveEvent>() = std::move(ev);
+    }
+}
+
+inline void write_agents(ByteWriter& w) {
+    using afterhours::Entity;
+    std::vector<Entity*> agents;
+    for (Entity& e : afterhours::EntityQuery()
+                         .whereHasComponent<Agent>()
+                         .whereHasComponent<Transform>()
+                         .gen()) {
+        agents.push_back(&e);
+    }
+    w.put<uint32_t>((uint32_t) agents.size());
+
+    auto agent = [](Entity& e) -> Agent& { return e.get<Agent>(); };
+    put_column<float>(w, agents,
+                      [](Entity& e) { return e.get<Transform>().position.x; });
+    put_column<float>(w, agents,
+                      [](Entity& e) { return e.get<Transform>().position.y; });
+    put_column<uint8_t>(w, agents,
+                        [&](Entity& e) { return (uint8_t) agent(e).want; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).target_grid_x; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).target_grid_z; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).move_target_x; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).move_target_z; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).flee_target_x; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).flee_target_z; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).last_grid_x; });
+    put_column<int32_t>(w, agents,
+                        [&](Entity& e) { return agent(e).last_grid_z; });
+    put_column<float>(w, agents, [&](Entity& e) { return agent(e).speed; });
+    put_column<float>(w, agents,
+                      [&](Entity& e) { return agent(e).stuck_timer; });
+    put_column<uint8_t>(w, agents,
+                        [&](Entity& e) { return agent(e).color_idx; });
+    put_column<uint64_t>(w, agents, [&](Entity& e) { return agent(e).rng_id; });
+    put_column<RandomStream>(w, agents,
+                             [&](Entity& e) { return agent(e).rng; });
+
+    put_column<uint8_t>(w, agents, [](Entity& e) {
+        namespace af = agent_flags;
+        uint8_t f = 0;
+        if (!e.is_missing<AgentNeeds>()) {
+            f |= af::HAS_NEEDS;
+            if (e.get<AgentNeeds>().needs_bathroom) f |= af::NEEDS_BATHROOM;
+            if (e.get<AgentNeeds>().needs_food) f |= af::NEEDS_FOOD;
+        }
+        if (!e.is_missing<AgentHealth>()) f |= af::HAS_HEALTH;
+        if (!e.is_missing<WatchingStage>()) f |= af::WATCHING;
+        if (!e.is_missing<BeingServiced>()) f |= af::SERVICED;
+        if (!e.is_missing<PheromoneDepositor>()) f |= af::DEPOSITOR;
+        if (!e.is_missing<CarryoverAgent>()) f |= af::CARRYOVER;
+        return f;
+    });
+
+    // Optional components: dense columns, defaults where absent
+    auto opt = []<typename C, typename Fn>(Entity& e, Fn fn) {
+        return e.is_missing<C>() ? fn(C{}) : fn(e.get<C>());
+    };
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<AgentHealth>(
+            e, [](const AgentHealth& c) { return c.hp; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<AgentNeeds>(
+            e, [](const AgentNeeds& c) { return c.bathroom_timer; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<AgentNeeds>(
+            e, [](const AgentNeeds& c) { return c.bathroom_threshold; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<AgentNeeds>(
+            e, [](const AgentNeeds& c) { return c.food_timer; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<AgentNeeds>(
+            e, [](const AgentNeeds& c) { return c.food_threshold; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<WatchingStage>(
+            e, [](const WatchingStage& c) { return c.watch_timer; });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<WatchingStage>(
+            e, [](const WatchingStage& c) { return c.watch_duration; });
+    });
+    put_column<int32_t>(w, agents, [&](Entity& e) {
+        return opt.operator()<BeingServiced>(
+            e, [](const BeingServiced& c) { return c.facility_grid_x; });
+    });
+    put_column<int32_t>(w, agents, [&](Entity& e) {
+        return opt.operator()<BeingServiced>(
+            e, [](const BeingServiced& c) { return c.facility_grid_z; });
+    });
+    put_column<uint8_t>(w, agents, [&](Entity& e) {
+        return opt.operator()<BeingServiced>(e, [](const BeingServiced& c) {
+            return (uint8_t) c.facility_type;
+        });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<BeingServiced>(
+            e, [](const BeingServiced& c) { return c.time_remaining; });
+    });
+    put_column<uint8_t>(w, agents, [&](Entity& e) {
+        return opt.operator()<PheromoneDepositor>(
+            e, [](const PheromoneDepositor& c) {
+                return (uint8_t) ((uint8_t) c.leaving_type |
+                                  (c.is_depositing ? 0x80 : 0));
+            });
+    });
+    put_column<float>(w, agents, [&](Entity& e) {
+        return opt.operator()<PheromoneDepositor>(
+            e, [](const PheromoneDepositor& c) { return c.deposit_distance; });
+    });
+}
+
+// Reset C on a reused entity, or add it to a fresh one
+template<typename C>
+inline C& fresh_component(afterhours::Entity& e) {
+    if (e.is_missing<C>()) return e.addComponent<C>();
+    return e.get<C>() = C{};
+}
+
+template<typename C>
+inline void drop_component(afterhours::Entity& e) {
+    if (!e.is_missing<C>()) e.removeComponent<C>();
+}
+
+// Decoded AGENTS section (columns viewed in place), applied by apply_agents
+struct AgentData {
+    size_t n = 0;
+    ColumnView<float> pos_x;
+    ColumnView<float> pos_z;
+    ColumnView<uint8_t> want;
+    ColumnView<int32_t> target_x;
+    ColumnView<int32_t> target_z;
+    ColumnView<int32_t> move_x;
+    ColumnView<int32_t> move_z;
+    ColumnView<int32_t> flee_x;
+    ColumnView<int32_t> flee_z;
+    ColumnView<int32_t> last_x;
+    ColumnView<int32_t> last_z;
+    ColumnView<float> speed;
+    ColumnView<float> stuck;
+    ColumnView<uint8_t> color;
+    ColumnView<uint64_t> rng_id;
+    ColumnView<RandomStream> rng;
+    ColumnView<uint8_t> flags;
+    ColumnView<float> hp;
+    ColumnView<float> bath_timer;
+    ColumnView<float> bath_threshold;
+    ColumnView<float> food_timer;
+    ColumnView<float> food_threshold;
+    ColumnView<float> watch_timer;
+    ColumnView<float> watch_duration;
+    ColumnView<int32_t> svc_x;
+    ColumnView<int32_t> svc_z;
+    ColumnView<uint8_t> svc_type;
+    ColumnView<float> svc_left;
+    ColumnView<uint8_t> dep_type;
+    ColumnView<float> dep_dist;
+};
+
+inline bool read_agents(ByteReader& r, AgentData& out) {
+    size_t n = r.get<uint32_t>();
+    if (!r.ok) return false;
+    out.n = n;
+    out.pos_x = r.view<float>(n);
+    out.pos_z = r.view<float>(n);
+    out.want = r.view<uint8_t>(n);
+    out.target_x = r.view<int32_t>(n);
+    out.target_z = r.view<int32_t>(n);
+    out.move_x = r.view<int32_t>(n);
+    out.move_z = r.view<int32_t>(n);
+    out.flee_x = r.view<int32_t>(n);
+    out.flee_z = r.view<int32_t>(n);
+    out.last_x = r.view<int32_t>(n);
+    out.last_z = r.view<int32_t>(n);
+    out.speed = r.view<float>(n);
+    out.stuck = r.view<float>(n);
+    out.color = r.view<uint8_t>(n);
+    out.rng_id = r.view<uint64_t>(n);
+    out.rng = r.view<RandomStream>(n);
+    out.flags = r.view<uint8_t>(n);
+    out.hp = r.view<float>(n);
+    out.bath_timer = r.view<float>(n);
+    out.bath_threshold = r.view<float>(n);
+    out.food_timer = r.view<float>(n);
+    out.food_threshold = r.view<float>(n);
+    out.watch_timer = r.view<float>(n);
+    out.watch_duration = r.view<float>(n);
+    out.svc_x = r.view<int32_t>(n);
+    out.svc_z = r.view<int32_t>(n);
+    out.svc_type = r.view<uint8_t>(n);
+    out.svc_left = r.view<float>(n);
+    out.dep_type = r.view<uint8_t>(n);
+    out.dep_dist = r.view<float>(n);
+    return r.ok;
+}
+
+inline void apply_agents(const AgentData& in) {
+    namespace af = agent_flags;
+    size_t n = in.n;
+
+    // Reuse live agent entities in place and only create the shortfall
+    // (one createEntity + addComponent set each, after a single reserve of
+    // the entity array), so loading over a running festival costs no
+    // entity churn
+    std::vector<afterhours::Entity*> pool;
+    for (afterhours::Entity& e : afterhours::EntityQuery()
+                                     .whereHasComponent<Agent>()
+                                     .gen()) {
+        pool.push_back(&e);
+    }
+    for (size_t i = n; i < pool.size(); i++) pool[i]->cleanup = true;
+    if (n > pool.size()) {
+        auto& entities = afterhours::EntityHelper::get_entities_for_mod();
+        entities.reserve(entities.size() + (n - pool.size()));
+        while (pool.size() < n) {
+            pool.push_back(&afterhours::EntityHelper::createEntity());
+            telemetry::bump(telemetry::EntitiesCreated);
         }
-        f.write(reinterpret_cast<const char*>(&hp), sizeof(float));
     }
 
-    return f.good();
+    for (size_t i = 0; i < n; i++) {
+        afterhours::Entity& e = *pool[i];
+        fresh_component<Transform>(e).position = {in.pos_x[i], in.pos_z[i]};
+        auto& a = fresh_component<Agent>(e);
+        a.want = static_cast<FacilityType>(in.want[i]);
+        a.target_grid_x = in.target_x[i];
+        a.target_grid_z = in.target_z[i];
+        a.move_target_x = in.move_x[i];
+        a.move_target_z = in.move_z[i];
+        a.flee_target_x = in.flee_x[i];
+        a.flee_target_z = in.flee_z[i];
+        a.last_grid_x = in.last_x[i];
+        a.last_grid_z = in.last_z[i];
+        a.speed = in.speed[i];
+        a.stuck_timer = in.stuck[i];
+        a.color_idx = in.color[i];
+        a.rng_id = in.rng_id[i];
+        a.rng = in.rng[i];
+
+        uint8_t f = in.flags[i];
+        if (f & af::HAS_HEALTH) {
+            fresh_component<AgentHealth>(e).hp = in.hp[i];
+        } else {
+            drop_component<AgentHealth>(e);
+        }
+        if (f & af::HAS_NEEDS) {
+            auto& needs = fresh_component<AgentNeeds>(e);
+            needs.bathroom_timer = in.bath_timer[i];
+            needs.bathroom_threshold = in.bath_threshold[i];
+            needs.food_timer = in.food_timer[i];
+            needs.food_threshold = in.food_threshold[i];
+            needs.needs_bathroom = f & af::NEEDS_BATHROOM;
+            needs.needs_food = f & af::NEEDS_FOOD;
+        } else {
+            drop_component<AgentNeeds>(e);
+        }
+        if (f & af::WATCHING) {
+            auto& ws = fresh_component<WatchingStage>(e);
+            ws.watch_timer = in.watch_timer[i];
+            ws.watch_duration = in.watch_duration[i];
+        } else {
+            drop_component<WatchingStage>(e);
+        }
+        if (f & af::SERVICED) {
+            auto& bs = fresh_component<BeingServiced>(e);
+            bs.facility_grid_x = in.svc_x[i];
+            bs.facility_grid_z = in.svc_z[i];
+            bs.facility_type = static_cast<FacilityType>(in.svc_type[i]);
+            bs.time_remaining = in.svc_left[i];
+        } else {
+            drop_component<BeingServiced>(e);
+        }
+        if (f & af::DEPOSITOR) {
+            auto& pd = fresh_component<PheromoneDepositor>(e);
+            pd.leaving_type = static_cast<FacilityType>(in.dep_type[i] & 0x7F);
+            pd.is_depositing = in.dep_type[i] & 0x80;
+            pd.deposit_distance = in.dep_dist[i];
+        } else {
+            drop_component<PheromoneDepositor>(e);
+        }
+        if (f & af::CARRYOVER) {
+            fresh_component<CarryoverAgent>(e);
+        } else {
+            drop_component<CarryoverAgent>(e);
+        }
+    }
 }
 
-// Load game state from binary file
-inline bool load_game() {
-    std::ifstream f(SAVE_FILE, std::ios::binary);
-    if (!f) return false;
+inline void write_macro(ByteWriter& w, const MacroCrowd& mc) {
+    w.put((uint8_t) mc.enabled);
+    for (int d = 0; d < Tile::NUM_DESIRES; d++) {
+        std::vector<float> plane(MacroCrowd::NUM_TILES);
+        for (int i = 0; i < MacroCrowd::NUM_TILES; i++) plane[i] = mc.pop[i][d];
+        w.put_array(plane.data(), plane.size());
+    }
+    std::vector<uint8_t> active(mc.active.begin(), mc.active.end());
+    w.put_array(active.data(), active.size());
+    w.put(mc.served_carry);
+    w.put(mc.step_timer);
+}
 
-    uint32_t magic = 0;
-    f.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-    if (magic != SAVE_MAGIC) return false;
+inline bool read_macro(ByteReader& r, MacroCrowd& mc) {
+    bool enabled = r.get<uint8_t>() != 0;
+    std::array<ColumnView<float>, Tile::NUM_DESIRES> planes;
+    for (auto& plane : planes)
+        plane = r.view<float>(MacroCrowd::NUM_TILES);
+    auto active = r.view<uint8_t>(MacroCrowd::NUM_TILES);
+    float carry = r.get<float>();
+    float timer = r.get<float>();
+    if (!r.ok) return false;
+
+    mc.enabled = enabled;
+    for (int i = 0; i < MacroCrowd::NUM_TILES; i++) {
+        for (int d = 0; d < Tile::NUM_DESIRES; d++) mc.pop[i][d] = planes[d][i];
+        mc.active[i] = active[i] != 0;
+    }
+    mc.served_carry = carry;
+    mc.step_timer = timer;
+    return true;
+}
 
-    uint32_t version = 0;
-    f.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if (version != SAVE_VERSION) return false;  // Reject incompatible saves
+// Shared engine (spawn rolls, events, anything not on an agent stream), so
+// a resumed game draws the same values the uninterrupted run would have
+inline void write_rng(ByteWriter& w) {
+    auto state = RandomEngine::save_state();
+    w.put_string(state.seed);
+    w.put_string(RandomEngine::state_to_text(state));
+}
+
+inline bool read_rng(ByteReader& r, RandomEngine::State& state) {
+    state.seed = r.get_string();
+    std::string text = r.get_string();
+    return r.ok && RandomEngine::state_from_text(text, state);
+}
+
+// Raw (uncompressed) sections captured from live state at a tick
+// boundary. Capturing is a handful of column copies; encoding and writing
+// touch no game state, so they can run on another thread (see autosave.h).
+struct Snapshot {
+    struct Section {
+        uint32_t id;
+        uint16_t version;
+        bool compress;
+        ByteWriter data;
+    };
+    std::vector<Section> sections;
+
+    [[nodiscard]] bool empty() const { return sections.empty(); }
+};
+
+inline Snapshot capture_snapshot() {
+    using afterhours::EntityHelper;
+    Snapshot snap;
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    if (!grid) return snap;
+
+    auto add = [&](uint32_t id, uint16_t version, bool compress) -> auto& {
+        snap.sections.push_back({id, version, compress, {}});
+        return snap.sections.back().data;
+    };
+
+    write_grid(add(section::GRID, section::GRID_VERSION, true), *grid);
+    write_game(add(section::GAME, section::GAME_VERSION, false));
+    if (auto* sched = EntityHelper::get_singleton_cmp<ArtistSchedule>()) {
+        write_schedule(add(section::SCHEDULE, section::SCHEDULE_VERSION, false),
+                       *sched);
+    }
+    write_events(add(section::EVENTS, section::EVENTS_VERSION, false));
+    write_agents(add(section::AGENTS, section::AGENTS_VERSION, true));
+    if (auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>()) {
+        write_macro(add(section::MACRO, section::MACRO_VERSION, true), *mc);
+    }
+    write_rng(add(section::RNG, section::RNG_VERSION, false));
+    return snap;
+}
 
+// Compress sections and lay out the container (thread-safe)
+inline std::vector<uint8_t> encode_snapshot(const Snapshot& snap) {
+    ByteWriter out;
+    out.put(SAVE_MAGIC);
+    out.put(SAVE_VERSION);
+    out.put<uint32_t>((uint32_t) snap.sections.size());
+    size_t table_at = out.buf.size();
+    out.buf.resize(table_at + snap.sections.size() * section::ENTRY_SIZE);
+
+    ByteWriter table;
+    std::vector<uint8_t> packed;
+    for (const auto& sec : snap.sections) {
+        const auto& raw = sec.data.buf;
+        uint32_t offset = (uint32_t) out.buf.size();
+        uint16_t flags = 0;
+        if (sec.compress) {
+            packed.clear();
+            compress::lz_compress(raw.data(), raw.size(), packed);
+            if (packed.size() < raw.size()) {
+                flags |= section::FLAG_COMPRESSED;
+                out.put_array(packed.data(), packed.size());
+            }
+        }
+        if (!(flags & section::FLAG_COMPRESSED)) {
+            out.put_array(raw.data(), raw.size());
+        }
+        table.put(sec.id);
+        table.put(sec.version);
+        table.put(flags);
+        table.put(offset);
+        table.put<uint32_t>((uint32_t) out.buf.size() - offset);
+        table.put<uint32_t>((uint32_t) raw.size());
+    }
+    std::memcpy(out.buf.data() + table_at, table.buf.data(), table.buf.size());
+    return std::move(out.buf);
+}
+
+// Write to PATH.tmp, then rename over PATH: readers (and a crash mid-write)
+// only ever see the old file or the complete new one
+inline bool write_file_atomic(const std::string& path,
+                              const std::vector<uint8_t>& bytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), ec);
+    if (ec) {
+        log_warn("save: cannot create directory for {}: {}", path,
+                 ec.message());
+        return false;
+    }
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            log_warn("save: cannot open {} for writing", tmp);
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(bytes.data()),
+                (std::streamsize) bytes.size());
+        f.flush();
+        if (!f.good()) return false;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        log_warn("save: rename {} -> {} failed: {}", tmp, path, ec.message());
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// Save game state to binary file
+inline bool save_game() {
+    Snapshot snap = capture_snapshot();
+    if (snap.empty()) return false;
+    return write_file_atomic(save_file(), encode_snapshot(snap));
+}
+
+// Version 1: flat tile-by-tile stream, positions-only agents. `f` is
+// positioned just past the magic and version.
+inline bool load_game_v1(std::ifstream& f) {
     // Grid tiles
     auto* grid = afterhours::EntityHelper::get_singleton_cmp<Grid>();
     if (!grid) return false;
@@ -222,6 +1014,7 @@ inline bool load_game() {
         f.read(reinterpret_cast<char*>(&hp), sizeof(float));
 
         auto& e = afterhours::EntityHelper::createEntity();
+        telemetry::bump(telemetry::EntitiesCreated);
         e.addComponent<Transform>(::vec2{px, pz});
         e.addComponent<Agent>(static_cast<FacilityType>(want), tx, tz);
         e.get<Agent>().color_idx = color_idx;
@@ -235,6 +1028,166 @@ inline bool load_game() {
     return f.good();
 }
 
+// Load a complete version 2 image (a mapped file, or a replay keyframe
+// produced by encode_snapshot). Uncompressed sections are parsed in place
+// and agent columns are applied straight from the image or the decode
+// buffer, with no intermediate copies.
+inline bool load_game_from_memory(const uint8_t* data, size_t size) {
+    using afterhours::EntityHelper;
+    ByteReader hdr{data, size};
+    if (hdr.get<uint32_t>() != SAVE_MAGIC) return false;
+    if (hdr.get<uint32_t>() != SAVE_VERSION) return false;
+
+    uint32_t count = hdr.get<uint32_t>();
+    struct Entry {
+        uint32_t id;
+        uint16_t version, flags;
+        uint32_t offset, stored, raw;
+    };
+    std::vector<Entry> entries;
+    for (uint32_t i = 0; i < count && hdr.ok; i++) {
+        Entry e;
+        e.id = hdr.get<uint32_t>();
+        e.version = hdr.get<uint16_t>();
+        e.flags = hdr.get<uint16_t>();
+        e.offset = hdr.get<uint32_t>();
+        e.stored = hdr.get<uint32_t>();
+        e.raw = hdr.get<uint32_t>();
+        entries.push_back(e);
+    }
+    if (!hdr.ok) return false;
+
+    // Decompress and decode every section before touching live state, so
+    // a corrupt file leaves the running game alone
+    struct Loaded {
+        Entry entry;
+        const uint8_t* data;
+        size_t size;
+        std::vector<uint8_t> decoded;
+    };
+    std::vector<Loaded> loaded;
+    loaded.reserve(entries.size());
+    for (const auto& e : entries) {
+        if (e.offset > size || e.stored > size - e.offset) {
+            log_warn("save: section {:08x} out of range", e.id);
+            return false;
+        }
+        const uint8_t* src = data + e.offset;
+        Loaded& l = loaded.emplace_back(Loaded{e, src, e.stored, {}});
+        if (e.flags & section::FLAG_COMPRESSED) {
+            if (!compress::lz_decompress(src, e.stored, e.raw, l.decoded)) {
+                log_warn("save: section {:08x} is corrupt", e.id);
+                return false;
+            }
+            l.data = l.decoded.data();
+            l.size = l.decoded.size();
+        }
+    }
+
+    auto find = [&](uint32_t id,
+                    uint16_t supported) -> std::optional<ByteReader> {
+        for (auto& l : loaded) {
+            if (l.entry.id != id) continue;
+            if (l.entry.version > supported) {
+                log_warn("save: section {:08x} v{} is newer than v{}, skipped",
+                         id, l.entry.version, supported);
+                return std::nullopt;
+            }
+            return ByteReader{l.data, l.size};
+        }
+        return std::nullopt;
+    };
+
+    // Required sections: all of them decode, or nothing is applied
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    GridData grid_in;
+    GameData game_in;
+    AgentData agents_in;
+    auto r = find(section::GRID, section::GRID_VERSION);
+    if (!grid || !r || !read_grid(*r, grid_in)) {
+        log_warn("save: grid section missing or truncated");
+        return false;
+    }
+    if (!(r = find(section::GAME, section::GAME_VERSION)) ||
+        !read_game(*r, game_in)) {
+        log_warn("save: game section missing or truncated");
+        return false;
+    }
+    if (!(r = find(section::AGENTS, section::AGENTS_VERSION)) ||
+        !read_agents(*r, agents_in)) {
+        log_warn("save: agent section missing or truncated");
+        return false;
+    }
+
+    // Optional sections: a bad one is skipped and the rest still load
+    auto* sched = EntityHelper::get_singleton_cmp<ArtistSchedule>();
+    std::optional<ArtistSchedule> sched_in;
+    if (sched && (r = find(section::SCHEDULE, section::SCHEDULE_VERSION))) {
+        sched_in.emplace(*sched);
+        if (!read_schedule(*r, *sched_in)) {
+            log_warn("save: schedule section truncated");
+            sched_in.reset();
+        }
+    }
+    std::optional<std::vector<ActiveEvent>> events_in;
+    if ((r = find(section::EVENTS, section::EVENTS_VERSION))) {
+        events_in.emplace();
+        if (!read_events(*r, *events_in)) {
+            log_warn("save: event section truncated");
+            events_in.reset();
+        }
+    }
+    auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+    std::optional<MacroCrowd> macro_in;
+    if (mc && (r = find(section::MACRO, section::MACRO_VERSION))) {
+        macro_in.emplace(*mc);
+        if (!read_macro(*r, *macro_in)) {
+            log_warn("save: macro section truncated");
+            macro_in.reset();
+        }
+    }
+    std::optional<RandomEngine::State> rng_in;
+    if ((r = find(section::RNG, section::RNG_VERSION))) {
+        rng_in.emplace();
+        if (!read_rng(*r, *rng_in)) {
+            log_warn("save: rng section truncated");
+            rng_in.reset();
+        }
+    }
+
+    // Everything decoded: swap it into the world
+    apply_grid(grid_in, *grid);
+    apply_game(game_in);
+    if (sched_in) *sched = std::move(*sched_in);
+    if (events_in) apply_events(*events_in);
+    apply_agents(agents_in);
+    EntityHelper::cleanup();
+    if (macro_in) *mc = std::move(*macro_in);
+    // After GAME: the engine state carries its own stream counter
+    if (rng_in) RandomEngine::restore_state(*rng_in);
+
+    EntityHelper::merge_entity_arrays();
+    return true;
+}
+
+// Load game state from a save file (version 2, or legacy version 1).
+// Version 2 files are memory-mapped, so resuming is bounded by page-in.
+inline bool load_game(const std::string& path = save_file()) {
+    MappedFile file(path);
+    if (!file.is_open()) return false;
+
+    ByteReader hdr{file.data(), file.size()};
+    if (hdr.get<uint32_t>() != SAVE_MAGIC) return false;
+    uint32_t version = hdr.get<uint32_t>();
+    if (!hdr.ok) return false;
+    if (version == 1) {
+        std::ifstream f(path, std::ios::binary);
+        f.seekg(2 * sizeof(uint32_t));
+        return f && load_game_v1(f);
+    }
+    return load_game_from_memory(file.data(), file.size());
+}
+
 // Update meta-progression with current run stats
 inline void update_meta_on_game_over() {
     MetaProgress meta;
@@ -264,12 +1217,14 @@ inline void update_meta_on_game_over() {
 }
 
 // Check if a save file exists
-inline bool has_save_file() { return std::filesystem::exists(SAVE_FILE); }
+inline bool has_save_file() {
+    return std::filesystem::exists(save_file());
+}
 
 // Delete save file
 inline void delete_save() {
-    if (std::filesystem::exists(SAVE_FILE)) {
-        std::filesystem::remove(SAVE_FILE);
+    if (std::filesystem::exists(save_file())) {
+        std::filesystem::remove(save_file());
     }
 }
 
@@ -185,13 +185,13 @@ struct DifficultyScalingSystem : System<> {
 };
 
 void register_schedule_update_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<UpdateArtistScheduleSystem>());
+    sm.register_update_system(timed<UpdateArtistScheduleSystem>());
 }
 
 void register_schedule_spawn_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<SpawnAgentSystem>());
+    sm.register_update_system(timed<SpawnAgentSystem>());
 }
 
 void register_schedule_difficulty_systems(SystemManager& sm) {
-    sm.register_update_system(std::make_unique<DifficultyScalingSystem>());
+    sm.register_update_system(timed<DifficultyScalingSystem>());
 }
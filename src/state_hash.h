@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "afterhours/src/core/entity_helper.h"
+#include "afterhours/src/core/entity_query.h"
+#include "components.h"
+#include "game.h"
+
+// Simulation state fingerprint used by determinism and golden-run tests.
+//
+// Each tile and each agent is packed into a few 64-bit words, mixed with
+// its identity (tile index / agent rng_id), and the results are summed.
+// The sum is order-independent, so agents need no sorting and entity ids
+// or storage layout never matter; only the simulation itself does. One
+// pass, no allocation: cheap enough to sample every few ticks.
+namespace state_hash {
+
+using afterhours::Entity;
+using afterhours::EntityHelper;
+using afterhours::EntityQuery;
+
+// splitmix64 finalizer
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Bit pattern, so -0.f / NaN payloads count as differences
+inline uint64_t f32_bits(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+inline uint64_t pack2(int a, int b) {
+    return (uint64_t) (uint32_t) a | ((uint64_t) (uint32_t) b << 32);
+}
+
+constexpr uint64_t GOLDEN = 0x9e3779b97f4a7c15ull;
+
+// Grid plane: type (8) | agent_count (16) | 5 pheromone channels (40)
+inline uint64_t hash_grid(const Grid& grid) {
+    uint64_t h = 0;
+    for (int i = 0; i < (int) grid.tiles.size(); i++) {
+        const Tile& t = grid.tiles[i];
+        uint64_t w = (uint64_t) t.type;
+        w |= (uint64_t) (uint16_t) t.agent_count << 8;
+        for (int c = 0; c < (int) t.pheromone.size(); c++) {
+            w |= (uint64_t) t.pheromone[c] << (24 + 8 * c);
+        }
+        h += mix64(w ^ mix64((uint64_t) i * GOLDEN));
+    }
+    return h;
+}
+
+inline uint64_t hash_agent(Entity& e) {
+    const auto& a = e.get<Agent>();
+    const auto& tf = e.get<Transform>();
+    uint64_t h = mix64(a.rng_id + GOLDEN);
+    h = mix64(h ^ (f32_bits(tf.position.x) | f32_bits(tf.position.y) << 32));
+    h = mix64(h ^ pack2(a.target_grid_x, a.target_grid_z));
+    h = mix64(h ^ pack2(a.move_target_x, a.move_target_z));
+    float hp = e.is_missing<AgentHealth>() ? -1.f : e.get<AgentHealth>().hp;
+    uint64_t flags = (uint64_t) a.want |
+                     ((uint64_t) !e.is_missing<WatchingStage>() << 8) |
+                     ((uint64_t) !e.is_missing<BeingServiced>() << 9);
+    h = mix64(h ^ (f32_bits(hp) | flags << 32));
+    return h;
+}
+
+struct Planes {
+    uint64_t grid = 0;
+    uint64_t agents = 0;
+    int agent_count = 0;
+
+    [[nodiscard]] uint64_t combined() const {
+        return mix64(grid ^ mix64(agents + (uint64_t) agent_count * GOLDEN));
+    }
+};
+
+inline Planes compute_planes() {
+    Planes p;
+    if (auto* grid = EntityHelper::get_singleton_cmp<Grid>()) {
+        p.grid = hash_grid(*grid);
+    }
+    auto agents = EntityQuery()
+                      .whereHasComponent<Agent>()
+                      .whereHasComponent<Transform>()
+                      .gen();
+    for (Entity& e : agents) {
+        p.agents += hash_agent(e);
+        p.agent_count++;
+    }
+    return p;
+}
+
+inline uint64_t compute() { return compute_planes().combined(); }
+
+}  // namespace state_hash
@@ -0,0 +1,462 @@
+// State stream domain: binary encoder, non-blocking writer and reference
+// decoder for the MCP state stream (see state_stream.h for the format).
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "state_stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+#include "afterhours/src/core/entity_helper.h"
+#include "afterhours/src/core/entity_query.h"
+#include "components.h"
+
+using namespace afterhours;
+
+namespace state_stream {
+
+namespace {
+
+struct Writer {
+    bool active = false;
+    bool memory = false;
+    int fd = -1;
+    std::string path;
+    int reopen_timer = 0;
+
+    // Simulated reader buffer for the memory sink
+    size_t memory_capacity = 0;
+    std::vector<uint8_t> memory_buf;
+
+    std::deque<std::vector<uint8_t>> queue;
+    size_t front_offset = 0;
+
+    Subscription sub;
+    Stats stats;
+    uint32_t tick_count = 0;
+    int frames_since_key = 0;
+    bool force_keyframe = true;
+
+    std::vector<uint8_t> prev_density;
+    std::vector<uint8_t> prev_pheromone;
+    std::vector<uint8_t> cur;
+};
+
+Writer& writer() {
+    static Writer w;
+    return w;
+}
+
+// ── Byte helpers ──
+
+template<typename T>
+void put(std::vector<uint8_t>& out, T v) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &v, sizeof(T));
+}
+
+void put_varint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+struct Reader {
+    const uint8_t* p;
+    size_t n;
+    size_t at = 0;
+    bool ok = true;
+
+    template<typename T>
+    T get() {
+        T v{};
+        if (at + sizeof(T) > n) {
+            ok = false;
+            return v;
+        }
+        std::memcpy(&v, p + at, sizeof(T));
+        at += sizeof(T);
+        return v;
+    }
+
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (at >= n) break;
+            uint8_t b = p[at++];
+            v |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+// Byte-wise delta against `prev` (raw on keyframes) as zero/literal runs.
+// Updates prev to cur.
+void encode_delta(const std::vector<uint8_t>& cur, std::vector<uint8_t>& prev,
+                  bool keyframe, std::vector<uint8_t>& out) {
+    size_t n = cur.size();
+    prev.resize(n, 0);
+    auto delta = [&](size_t k) -> uint8_t {
+        return keyframe ? cur[k] : static_cast<uint8_t>(cur[k] - prev[k]);
+    };
+    size_t i = 0;
+    while (i < n) {
+        size_t zeros = 0;
+        while (i + zeros < n && delta(i + zeros) == 0) zeros++;
+        size_t lit = 0;
+        while (i + zeros + lit < n && delta(i + zeros + lit) != 0) lit++;
+        put_varint(out, static_cast<uint32_t>(zeros));
+        put_varint(out, static_cast<uint32_t>(lit));
+        for (size_t k = i + zeros; k < i + zeros + lit; k++) {
+            out.push_back(delta(k));
+        }
+        i += zeros + lit;
+    }
+    prev = cur;
+}
+
+bool decode_delta(Reader& r, std::vector<uint8_t>& plane, bool keyframe) {
+    if (keyframe) std::fill(plane.begin(), plane.end(), 0);
+    size_t i = 0;
+    while (i < plane.size() && r.ok) {
+        uint32_t zeros = r.varint();
+        uint32_t lit = r.varint();
+        if (i + zeros + lit > plane.size() || r.at + lit > r.n) return false;
+        i += zeros;
+        for (uint32_t k = 0; k < lit; k++) plane[i++] += r.p[r.at++];
+    }
+    return r.ok;
+}
+
+uint16_t quantize(float world) {
+    constexpr float origin = -0.5f * TILESIZE;
+    constexpr float extent = MAP_SIZE * TILESIZE;
+    float t = std::clamp((world - origin) / extent, 0.f, 1.f);
+    return static_cast<uint16_t>(t * 65535.f + 0.5f);
+}
+
+bool in_region(const Subscription& s, int x, int z) {
+    return x >= s.x0 && x <= s.x1 && z >= s.z0 && z <= s.z1;
+}
+
+void encode_frame(Writer& w, std::vector<uint8_t>& out) {
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    auto* gs = EntityHelper::get_singleton_cmp<GameState>();
+    const Subscription& s = w.sub;
+    bool key = w.force_keyframe || w.frames_since_key >= KEYFRAME_INTERVAL;
+    w.force_keyframe = false;
+    w.frames_since_key = key ? 0 : w.frames_since_key + 1;
+
+    out.clear();
+    put<uint32_t>(out, 0);  // size, patched below
+    put<uint32_t>(out, MAGIC);
+    put<uint16_t>(out, VERSION);
+    put<uint16_t>(out, key ? FLAG_KEYFRAME : 0);
+    put<uint32_t>(out, w.tick_count);
+    put<float>(out, gs ? gs->game_time : 0.f);
+    put<uint8_t>(out, s.planes);
+    for (int v : {s.x0, s.z0, s.x1, s.z1}) {
+        put<uint8_t>(out, static_cast<uint8_t>(v));
+    }
+
+    auto agents = EntityQuery()
+                      .whereHasComponent<Agent>()
+                      .whereHasComponent<Transform>()
+                      .gen();
+
+    if (s.planes & COUNTERS) {
+        put<uint32_t>(out, static_cast<uint32_t>(agents.size()));
+        put<uint32_t>(out, gs ? gs->death_count : 0);
+        put<uint32_t>(out, gs ? gs->total_agents_served : 0);
+        put<uint32_t>(out, gs ? gs->agents_exited : 0);
+        put<uint32_t>(out, gs ? gs->max_attendees : 0);
+    }
+
+    if ((s.planes & DENSITY) && grid) {
+        w.cur.clear();
+        for (int z = s.z0; z <= s.z1; z++)
+            for (int x = s.x0; x <= s.x1; x++)
+                w.cur.push_back(static_cast<uint8_t>(
+                    std::min(grid->at(x, z).agent_count, 255)));
+        encode_delta(w.cur, w.prev_density, key, out);
+    }
+
+    if ((s.planes & PHEROMONE) && grid) {
+        w.cur.clear();
+        for (int z = s.z0; z <= s.z1; z++)
+            for (int x = s.x0; x <= s.x1; x++)
+                for (uint8_t p : grid->at(x, z).pheromone) w.cur.push_back(p);
+        encode_delta(w.cur, w.prev_pheromone, key, out);
+    }
+
+    if ((s.planes & AGENTS) && grid) {
+        size_t count_at = out.size();
+        put<uint32_t>(out, 0);
+        uint32_t n = 0;
+        for (Entity& e : agents) {
+            auto& tf = e.get<Transform>();
+            auto [gx, gz] = grid->world_to_grid(tf.position.x, tf.position.y);
+            if (!in_region(s, gx, gz)) continue;
+            put<uint32_t>(out, static_cast<uint32_t>(e.get<Agent>().rng_id));
+            put<uint16_t>(out, quantize(tf.position.x));
+            put<uint16_t>(out, quantize(tf.position.y));
+            put<uint8_t>(out, static_cast<uint8_t>(e.get<Agent>().want));
+            n++;
+        }
+        std::memcpy(out.data() + count_at, &n, sizeof(n));
+    }
+
+    uint32_t size = static_cast<uint32_t>(out.size() - sizeof(uint32_t));
+    std::memcpy(out.data(), &size, sizeof(size));
+}
+
+#ifndef _WIN32
+bool try_open_fd(Writer& w) {
+    // O_NONBLOCK on a FIFO fails with ENXIO until a reader connects
+    w.fd = ::open(w.path.c_str(), O_WRONLY | O_NONBLOCK | O_CREAT, 0644);
+    if (w.fd < 0) return false;
+    w.force_keyframe = true;
+    log_info("[stream] writing state stream to {}", w.path);
+    return true;
+}
+#endif
+
+// Push queued bytes to the sink without blocking
+void flush(Writer& w) {
+    while (!w.queue.empty()) {
+        auto& front = w.queue.front();
+        size_t left = front.size() - w.front_offset;
+        size_t wrote = 0;
+        if (w.memory) {
+            size_t room = w.memory_capacity - std::min(w.memory_capacity,
+                                                       w.memory_buf.size());
+            wrote = std::min(room, left);
+            w.memory_buf.insert(w.memory_buf.end(),
+                                front.begin() + w.front_offset,
+                                front.begin() + w.front_offset + wrote);
+        } else {
+#ifndef _WIN32
+            ssize_t r = ::write(w.fd, front.data() + w.front_offset, left);
+            if (r < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                // Reader went away: drop the connection and wait for the
+                // next one; the stream restarts from a keyframe
+                log_warn("[stream] write failed ({}), reopening",
+                         std::strerror(errno));
+                ::close(w.fd);
+                w.fd = -1;
+                w.queue.clear();
+                w.front_offset = 0;
+                w.stats.queued_bytes = 0;
+                return;
+            }
+            wrote = static_cast<size_t>(r);
+#endif
+        }
+        w.front_offset += wrote;
+        w.stats.bytes_written += wrote;
+        w.stats.queued_bytes -= wrote;
+        if (w.front_offset < front.size()) return;
+        w.queue.pop_front();
+        w.front_offset = 0;
+    }
+}
+
+}  // namespace
+
+uint8_t parse_planes(const std::string& spec) {
+    uint8_t mask = 0;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find_first_of("+,", start);
+        if (end == std::string::npos) end = spec.size();
+        std::string name = spec.substr(start, end - start);
+        if (name == "all") mask |= ALL_PLANES;
+        else if (name == "counters") mask |= COUNTERS;
+        else if (name == "density") mask |= DENSITY;
+        else if (name == "pheromone") mask |= PHEROMONE;
+        else if (name == "agents") mask |= AGENTS;
+        else return 0;
+        start = end + 1;
+    }
+    return mask;
+}
+
+bool open(const std::string& target, size_t memory_capacity) {
+    close();
+    Writer& w = writer();
+    w.path = target;
+    w.memory = (target == "memory");
+    w.memory_capacity = memory_capacity;
+    w.active = true;
+    w.stats = {};
+    w.tick_count = 0;
+    w.force_keyframe = true;
+    if (w.memory) return true;
+#ifndef _WIN32
+    // A reader closing its end must not kill the game
+    std::signal(SIGPIPE, SIG_IGN);
+    if (!try_open_fd(w) && errno != ENXIO) {
+        log_warn("[stream] cannot open {}: {}", target, std::strerror(errno));
+        w.active = false;
+        return false;
+    }
+    return true;
+#else
+    log_warn("[stream] state streaming is not supported on this platform");
+    w.active = false;
+    return false;
+#endif
+}
+
+void close() {
+    Writer& w = writer();
+#ifndef _WIN32
+    if (w.fd >= 0) ::close(w.fd);
+#endif
+    w.fd = -1;
+    w.active = false;
+    w.queue.clear();
+    w.front_offset = 0;
+    w.memory_buf.clear();
+    w.stats.queued_bytes = 0;
+}
+
+bool is_open() { return writer().active; }
+
+void subscribe(const Subscription& sub) {
+    Writer& w = writer();
+    w.sub = sub;
+    w.sub.every = std::max(1, sub.every);
+    w.sub.x0 = std::clamp(sub.x0, 0, MAP_SIZE - 1);
+    w.sub.z0 = std::clamp(sub.z0, 0, MAP_SIZE - 1);
+    w.sub.x1 = std::clamp(sub.x1, w.sub.x0, MAP_SIZE - 1);
+    w.sub.z1 = std::clamp(sub.z1, w.sub.z0, MAP_SIZE - 1);
+    w.force_keyframe = true;
+}
+
+const Subscription& subscription() { return writer().sub; }
+
+const Stats& stats() { return writer().stats; }
+
+void tick() {
+    Writer& w = writer();
+    if (!w.active) return;
+
+#ifndef _WIN32
+    if (!w.memory && w.fd < 0) {
+        if (++w.reopen_timer < KEYFRAME_INTERVAL) return;
+        w.reopen_timer = 0;
+        if (!try_open_fd(w)) return;
+    }
+#endif
+
+    flush(w);
+    if (w.tick_count++ % w.sub.every != 0) return;
+    // The memory sink's reader buffer is tiny by design, so anything still
+    // queued there already means the reader has fallen behind
+    if (w.stats.queued_bytes > MAX_QUEUED_BYTES ||
+        (w.memory && w.stats.queued_bytes > 0)) {
+        w.stats.ticks_skipped++;
+        return;
+    }
+
+    std::vector<uint8_t> frame;
+    encode_frame(w, frame);
+    w.stats.queued_bytes += frame.size();
+    w.stats.frames_queued++;
+    w.queue.push_back(std::move(frame));
+    flush(w);
+}
+
+void drain_memory(std::vector<uint8_t>& out) {
+    Writer& w = writer();
+    out.insert(out.end(), w.memory_buf.begin(), w.memory_buf.end());
+    w.memory_buf.clear();
+    flush(w);
+}
+
+const std::vector<uint8_t>& last_density() { return writer().prev_density; }
+
+const std::vector<uint8_t>& last_pheromone() {
+    return writer().prev_pheromone;
+}
+
+// ── Decoder ──
+
+bool Decoder::feed(const std::vector<uint8_t>& bytes) {
+    pending.insert(pending.end(), bytes.begin(), bytes.end());
+    size_t at = 0;
+    while (pending.size() - at >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, pending.data() + at, sizeof(size));
+        if (pending.size() - at - sizeof(size) < size) break;
+        if (!decode_frame(pending.data() + at + sizeof(size), size))
+            return false;
+        at += sizeof(size) + size;
+    }
+    pending.erase(pending.begin(), pending.begin() + at);
+    return true;
+}
+
+bool Decoder::decode_frame(const uint8_t* p, size_t n) {
+    Reader r{p, n};
+    if (r.get<uint32_t>() != MAGIC || r.get<uint16_t>() != VERSION)
+        return false;
+    bool key = r.get<uint16_t>() & FLAG_KEYFRAME;
+    if (!key && !has_keyframe) return true;  // joined mid-stream: wait
+    tick = r.get<uint32_t>();
+    (void) r.get<float>();
+    sub.planes = r.get<uint8_t>();
+    sub.x0 = r.get<uint8_t>();
+    sub.z0 = r.get<uint8_t>();
+    sub.x1 = r.get<uint8_t>();
+    sub.z1 = r.get<uint8_t>();
+    if (!r.ok || sub.x1 < sub.x0 || sub.z1 < sub.z0) return false;
+    size_t tiles = (size_t) (sub.x1 - sub.x0 + 1) * (sub.z1 - sub.z0 + 1);
+
+    if (sub.planes & COUNTERS) {
+        for (auto& c : counters) c = r.get<uint32_t>();
+    }
+    if (sub.planes & DENSITY) {
+        density.resize(tiles);
+        if (!decode_delta(r, density, key)) return false;
+    }
+    if (sub.planes & PHEROMONE) {
+        pheromone.resize(tiles * 5);
+        if (!decode_delta(r, pheromone, key)) return false;
+    }
+    if (sub.planes & AGENTS) {
+        uint32_t count = r.get<uint32_t>();
+        agents.clear();
+        for (uint32_t i = 0; i < count && r.ok; i++) {
+            Agent a;
+            a.id = r.get<uint32_t>();
+            a.x = r.get<uint16_t>();
+            a.z = r.get<uint16_t>();
+            a.want = r.get<uint8_t>();
+            agents.push_back(a);
+        }
+    }
+    if (!r.ok) return false;
+    has_keyframe = true;
+    frames++;
+    return true;
+}
+
+}  // namespace state_stream
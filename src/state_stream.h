@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+// Compact binary simulation state stream for external analysis tools.
+//
+// Opened next to the MCP server (--state-stream PATH, usually a FIFO) so
+// tooling can follow the crowd at sim rate instead of polling screenshots.
+// Every `every` ticks one frame is encoded with the subscribed planes:
+//
+//   u32 size (bytes after this field)
+//   u32 MAGIC, u16 VERSION, u16 flags (FLAG_KEYFRAME), u32 tick,
+//   f32 game_time, u8 planes, u8 x0, z0, x1, z1 (inclusive tile region)
+//   [COUNTERS]  u32 agents, deaths, served, exited, max_attendees
+//   [DENSITY]   delta plane, 1 byte per region tile (agent_count, clamped)
+//   [PHEROMONE] delta plane, 5 bytes per region tile
+//   [AGENTS]    u32 n, then n x (u32 id, u16 x, u16 z, u8 want)
+//
+// Delta planes store the byte-wise difference from the previous frame's
+// plane (raw values on keyframes) as runs: varint zero_run, varint
+// literal_len, literal bytes. Agent positions are quantized to uint16
+// over the whole map.
+//
+// Backpressure: frames are queued and written non-blocking. While more
+// than MAX_QUEUED_BYTES are waiting, ticks are skipped without encoding,
+// so a slow reader costs nothing and deltas stay valid (they are always
+// relative to the last frame actually queued).
+namespace state_stream {
+
+constexpr uint32_t MAGIC = 0x53434445;  // "EDCS"
+constexpr uint16_t VERSION = 1;
+constexpr uint16_t FLAG_KEYFRAME = 1;
+constexpr size_t MAX_QUEUED_BYTES = 4u << 20;
+constexpr int KEYFRAME_INTERVAL = 60;  // frames between keyframes
+
+enum Plane : uint8_t {
+    COUNTERS = 1 << 0,
+    DENSITY = 1 << 1,
+    PHEROMONE = 1 << 2,
+    AGENTS = 1 << 3,
+    ALL_PLANES = COUNTERS | DENSITY | PHEROMONE | AGENTS,
+};
+
+// What a reader wants: planes, sample rate and a tile region
+struct Subscription {
+    uint8_t planes = ALL_PLANES;
+    int every = 1;
+    int x0 = 0, z0 = 0;
+    int x1 = MAP_SIZE - 1, z1 = MAP_SIZE - 1;
+};
+
+struct Stats {
+    uint64_t frames_queued = 0;
+    uint64_t ticks_skipped = 0;  // dropped by backpressure
+    uint64_t bytes_written = 0;
+    size_t queued_bytes = 0;
+};
+
+// "density+agents" / "all" -> plane mask (0 on unknown names)
+uint8_t parse_planes(const std::string& spec);
+
+// Open a FIFO or file for writing. "memory" keeps frames in-process with
+// a simulated reader buffer of `memory_capacity` bytes (tests).
+bool open(const std::string& target, size_t memory_capacity = 1u << 20);
+void close();
+[[nodiscard]] bool is_open();
+
+// Replaces the subscription; the next frame is a keyframe
+void subscribe(const Subscription& sub);
+[[nodiscard]] const Subscription& subscription();
+[[nodiscard]] const Stats& stats();
+
+// Called once per simulation tick
+void tick();
+
+// ── Reference decoder (tests, and a spec for tool authors) ──
+
+struct Decoder {
+    Subscription sub;
+    bool has_keyframe = false;
+    uint32_t tick = 0;
+    std::array<uint32_t, 5> counters{};
+    std::vector<uint8_t> density;
+    std::vector<uint8_t> pheromone;
+    struct Agent {
+        uint32_t id;
+        uint16_t x, z;
+        uint8_t want;
+    };
+    std::vector<Agent> agents;
+    int frames = 0;
+
+    // Consume bytes; returns false on a malformed stream
+    bool feed(const std::vector<uint8_t>& bytes);
+
+   private:
+    std::vector<uint8_t> pending;
+    bool decode_frame(const uint8_t* p, size_t n);
+};
+
+// Memory sink: hand the bytes the simulated reader has received so far
+// to `out` and free its buffer (lets queued frames drain).
+void drain_memory(std::vector<uint8_t>& out);
+
+// Planes as last encoded, for round-trip checks against a Decoder
+[[nodiscard]] const std::vector<uint8_t>& last_density();
+[[nodiscard]] const std::vector<uint8_t>& last_pheromone();
+
+}  // namespace state_stream
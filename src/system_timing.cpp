@@ -0,0 +1,144 @@
+// System timing domain: per-name sample windows, percentile summaries and
+// type-name cleanup for the timed<S>() wrapper.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "system_timing.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+
+#include <cstdlib>
+#endif
+
+namespace system_timing {
+
+namespace {
+
+struct Series {
+    std::string name;
+    std::array<float, WINDOW> ms{};
+    int head = 0;
+    int filled = 0;
+};
+
+struct Registry {
+    std::vector<Series> series;
+    std::unordered_map<std::string, int> ids;
+};
+
+Registry& reg() {
+    static Registry r;
+    return r;
+}
+
+float at_percentile(const std::vector<float>& sorted, float p) {
+    int idx = (int) (p * (float) (sorted.size() - 1) + 0.5f);
+    return sorted[std::clamp(idx, 0, (int) sorted.size() - 1)];
+}
+
+Summary summarize_series(const Series& s) {
+    Summary out;
+    out.samples = s.filled;
+    if (s.filled == 0) return out;
+    std::vector<float> sorted(s.ms.begin(), s.ms.begin() + s.filled);
+    std::sort(sorted.begin(), sorted.end());
+    float sum = 0.f;
+    for (float v : sorted) sum += v;
+    out.mean = sum / (float) sorted.size();
+    out.p50 = at_percentile(sorted, 0.50f);
+    out.p90 = at_percentile(sorted, 0.90f);
+    out.p95 = at_percentile(sorted, 0.95f);
+    out.p99 = at_percentile(sorted, 0.99f);
+    out.max = sorted.back();
+    return out;
+}
+
+}  // namespace
+
+int id_for(const std::string& name) {
+    auto& r = reg();
+    auto it = r.ids.find(name);
+    if (it != r.ids.end()) return it->second;
+    int id = (int) r.series.size();
+    r.series.push_back(Series{name});
+    r.ids[name] = id;
+    return id;
+}
+
+void record(int id, Clock::time_point start) {
+    float ms = std::chrono::duration<float, std::milli>(Clock::now() - start)
+                   .count();
+    auto& s = reg().series[id];
+    s.ms[s.head] = ms;
+    s.head = (s.head + 1) % WINDOW;
+    s.filled = std::min(s.filled + 1, WINDOW);
+}
+
+void reset() {
+    for (auto& s : reg().series) {
+        s.head = 0;
+        s.filled = 0;
+    }
+}
+
+bool Summary::get(const std::string& stat, float& out) const {
+    if (stat == "mean") {
+        out = mean;
+    } else if (stat == "p50") {
+        out = p50;
+    } else if (stat == "p90") {
+        out = p90;
+    } else if (stat == "p95") {
+        out = p95;
+    } else if (stat == "p99") {
+        out = p99;
+    } else if (stat == "max") {
+        out = max;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool summarize(const std::string& name, Summary& out) {
+    auto& r = reg();
+    auto it = r.ids.find(name);
+    if (it == r.ids.end()) return false;
+    out = summarize_series(r.series[it->second]);
+    return true;
+}
+
+std::vector<std::pair<std::string, Summary>> slowest(int max_count) {
+    std::vector<std::pair<std::string, Summary>> out;
+    for (const auto& s : reg().series) {
+        if (s.name == LOGIC || s.name == RENDER) continue;
+        out.push_back({s.name, summarize_series(s)});
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+        return a.second.p99 > b.second.p99;
+    });
+    if ((int) out.size() > max_count) out.resize(max_count);
+    return out;
+}
+
+std::string type_name(const std::type_info& type) {
+    std::string name = type.name();
+#if defined(__GNUG__)
+    int status = 0;
+    char* demangled =
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled) name = demangled;
+    std::free(demangled);
+#endif
+    // Drop namespaces ("(anonymous namespace)::Foo" -> "Foo")
+    size_t colon = name.rfind("::");
+    if (colon != std::string::npos) name = name.substr(colon + 2);
+    return name;
+}
+
+}  // namespace system_timing
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "afterhours/src/core/system.h"
+
+// Per-system tick times for perf assertions (assert_system_time etc).
+//
+// Systems are registered through timed<S>(), which wraps S so the span
+// from its once() to its after() (the whole entity pass) is recorded each
+// tick under S's type name. Section marks bracket all game update systems
+// ("logic") and the render passes up to the final present ("render"), so
+// neither includes vsync waits. The last WINDOW ticks are kept per name.
+namespace system_timing {
+
+constexpr int WINDOW = 600;
+constexpr const char* LOGIC = "logic";
+constexpr const char* RENDER = "render";
+
+using Clock = std::chrono::steady_clock;
+
+// Stable id for a name (registration time only)
+int id_for(const std::string& name);
+void record(int id, Clock::time_point start);
+
+// Drop all samples (perf_start)
+void reset();
+
+struct Summary {
+    int samples = 0;
+    float mean = 0.f, p50 = 0.f, p90 = 0.f, p95 = 0.f, p99 = 0.f;
+    float max = 0.f;  // all in ms
+
+    // "p99" / "mean" / "max"...; false when the stat name is unknown
+    bool get(const std::string& stat, float& out) const;
+};
+
+// False when nothing by that name was registered
+bool summarize(const std::string& name, Summary& out);
+
+// Registered names, slowest p99 first
+std::vector<std::pair<std::string, Summary>> slowest(int max_count);
+
+// "AgentMovementSystem" from a type (namespaces stripped)
+std::string type_name(const std::type_info& type);
+
+// S with its once()..after() span recorded. Update systems run the
+// non-const pair, render systems the const one; both are wrapped. When S
+// declares only the non-const overload it hides the base's const one,
+// which is a no-op, so the const wrapper has nothing to forward to.
+template<typename S>
+struct Timed : S {
+    int timing_id;
+    mutable Clock::time_point timing_start;
+
+    template<typename... Args>
+    explicit Timed(Args&&... args)
+        : S(std::forward<Args>(args)...),
+          timing_id(id_for(type_name(typeid(S)))) {}
+
+    void once(float dt) override {
+        timing_start = Clock::now();
+        S::once(dt);
+    }
+    void once(float dt) const override {
+        timing_start = Clock::now();
+        if constexpr (requires(const S& s) { s.S::once(dt); }) S::once(dt);
+    }
+    void after(float dt) override {
+        S::after(dt);
+        record(timing_id, timing_start);
+    }
+    void after(float dt) const override {
+        if constexpr (requires(const S& s) { s.S::after(dt); }) S::after(dt);
+        record(timing_id, timing_start);
+    }
+};
+
+// Opens (begin) or closes a named section spanning the systems between
+struct SectionMark : afterhours::System<> {
+    int id;
+    bool begin;
+    static inline Clock::time_point starts[2];
+    int slot;
+
+    SectionMark(const char* name, bool is_begin)
+        : id(id_for(name)),
+          begin(is_begin),
+          slot(std::string(name) == RENDER ? 1 : 0) {}
+
+    void mark() const {
+        if (begin) {
+            starts[slot] = Clock::now();
+        } else {
+            record(id, starts[slot]);
+        }
+    }
+    void once(float) override { mark(); }
+    void once(float) const override { mark(); }
+};
+
+}  // namespace system_timing
+
+template<typename S, typename... Args>
+std::unique_ptr<system_timing::Timed<S>> timed(Args&&... args) {
+    return std::make_unique<system_timing::Timed<S>>(
+        std::forward<Args>(args)...);
+}
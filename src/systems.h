@@ -6,20 +6,47 @@
 
 #include "afterhours/src/core/system.h"
 #include "afterhours/src/plugins/input_system.h"
+#include "engine/random_engine.h"
+#include "system_timing.h"
 
 using namespace afterhours;
 
 // Test mode flag - set by main.cpp when --test-mode is passed
 extern bool g_test_mode;
 
+// Fixed simulation step in seconds (0 = use real frame time). Set by
+// --fixed-dt or the set_fixed_dt e2e command for reproducible runs.
+extern float g_fixed_dt;
+
+// Frame time to simulate when g_fixed_dt is 0 (--fast): test waits run in
+// simulated time as fast as the CPU allows. 0 = real frame time.
+extern float g_fast_step;
+
+// Golden-run tests overwrite their recorded hash files (--update-golden)
+extern bool g_update_golden;
+
 void register_update_systems(SystemManager& sm);
 void register_render_systems(SystemManager& sm);
+void register_agent_index_systems(SystemManager& sm);
 
 // Pick the closest non-crowded StageFloor tile to (from_x, from_z)
 std::pair<int, int> best_stage_spot(int from_x, int from_z);
+// Same, drawing from the agent's own stream (safe off the main thread)
+std::pair<int, int> best_stage_spot(int from_x, int from_z,
+                                    RandomStream& rng);
+
+// Apply a build as if the player had clicked it: rect (x0,z0)-(x1,z1) for
+// path/fence, (x0,z0) for facilities and demolish. Queued for
+// PathBuildSystem so it lands at the same point of the tick as real
+// input (and replays record it the same way).
+enum class BuildTool;
+void queue_build(BuildTool tool, int x0, int z0, int x1, int z1);
+
 void register_mcp_update_systems(SystemManager& sm);
 void register_mcp_render_systems(SystemManager& sm);
 void register_e2e_systems(SystemManager& sm);
+// True while a queued e2e command other than a wait is unhandled
+bool e2e_command_pending();
 
 inline void register_all_systems(SystemManager& sm) {
     // Input system runs first to collect inputs
@@ -33,6 +60,9 @@ inline void register_all_systems(SystemManager& sm) {
         register_e2e_systems(sm);
     }
 
+    // Last update system: e2e commands also add and remove agents
+    register_agent_index_systems(sm);
+
     register_render_systems(sm);
     register_mcp_render_systems(sm);
 }
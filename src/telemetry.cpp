@@ -0,0 +1,264 @@
+// Telemetry domain: per-thread counter registry, per-tick aggregation,
+// frame-time history and the counting operator new.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include "afterhours/src/core/entity_helper.h"
+
+namespace telemetry {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Allocations made by this thread, counted by operator new as a plain
+// integer. Registering a block allocates, so operator new never registers;
+// it only publishes into the block once bump() has created one.
+thread_local uint64_t t_allocations = 0;
+thread_local ThreadCounters* t_block = nullptr;
+
+void publish_allocations() {
+    if (t_block) {
+        t_block->v[Allocations].store(t_allocations,
+                                      std::memory_order_relaxed);
+    }
+}
+
+constexpr const char* NAMES[NUM_COUNTERS] = {
+    "pathfinds",       "flee_retargets",     "forced_moves",
+    "lethal_no_flee",  "facility_admissions", "cache_rebuilds",
+    "entities_created", "entities_destroyed", "allocations",
+};
+
+struct Registry {
+    std::mutex mtx;
+    std::vector<std::unique_ptr<ThreadCounters>> threads;
+
+    // Per-tick aggregation state (main thread only)
+    std::array<uint64_t, NUM_COUNTERS> prev_sum{};
+    std::array<uint64_t, NUM_COUNTERS> totals{};
+    std::array<std::array<uint32_t, HISTORY>, NUM_COUNTERS> hist{};
+    std::array<float, HISTORY> frame_ms{};
+    std::array<uint64_t, NUM_FRAME_BUCKETS> frame_buckets{};
+    int head = 0;  // next history slot
+    int filled = 0;
+    int ticks = 0;
+    bool primed = false;  // prev_sum and prev_entities are valid
+    Clock::time_point last_tick;
+
+    size_t prev_entities = 0;
+    uint64_t destroyed_total = 0;
+
+    void sum(std::array<uint64_t, NUM_COUNTERS>& out) {
+        out.fill(0);
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& t : threads) {
+            for (int c = 0; c < NUM_COUNTERS; c++) {
+                out[c] += t->v[c].load(std::memory_order_relaxed);
+            }
+        }
+        out[EntitiesDestroyed] += destroyed_total;
+    }
+
+    // Creations are bumped at createEntity, so whatever the list is short
+    // of (last size + created this tick) was cleaned up, including
+    // entities that came and went within the tick
+    void count_destroyed(std::array<uint64_t, NUM_COUNTERS>& cur) {
+        size_t size = afterhours::EntityHelper::get_entities().size();
+        if (primed) {
+            uint64_t created = cur[EntitiesCreated] - prev_sum[EntitiesCreated];
+            auto expected = (int64_t) prev_entities + (int64_t) created;
+            auto destroyed = std::max<int64_t>(0, expected - (int64_t) size);
+            destroyed_total += (uint64_t) destroyed;
+            cur[EntitiesDestroyed] += (uint64_t) destroyed;
+        }
+        prev_entities = size;
+    }
+
+    template<typename T>
+    void ordered(const std::array<T, HISTORY>& ring,
+                 std::vector<float>& out) const {
+        out.clear();
+        int start = (head - filled + HISTORY) % HISTORY;
+        for (int i = 0; i < filled; i++) {
+            out.push_back((float) ring[(start + i) % HISTORY]);
+        }
+    }
+};
+
+Registry& reg() {
+    static Registry r;
+    return r;
+}
+
+int frame_bucket(float ms) {
+    for (int i = 0; i < (int) FRAME_BUCKET_MS.size(); i++) {
+        if (ms < FRAME_BUCKET_MS[i]) return i;
+    }
+    return NUM_FRAME_BUCKETS - 1;
+}
+
+}  // namespace
+
+const char* counter_name(Counter c) {
+    return c < NUM_COUNTERS ? NAMES[c] : "unknown";
+}
+
+Counter parse_counter(const std::string& name) {
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        if (name == NAMES[c]) return (Counter) c;
+    }
+    return NUM_COUNTERS;
+}
+
+ThreadCounters& register_thread() {
+    auto& r = reg();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    r.threads.push_back(std::make_unique<ThreadCounters>());
+    t_block = r.threads.back().get();
+    publish_allocations();
+    return *t_block;
+}
+
+void end_tick() {
+    auto& r = reg();
+    auto now = Clock::now();
+    // Registers the main thread's block if nothing on it has bumped yet,
+    // then folds its allocation count in
+    bump(Allocations, 0);
+    publish_allocations();
+
+    std::array<uint64_t, NUM_COUNTERS> cur;
+    r.sum(cur);
+    r.count_destroyed(cur);
+    if (!r.primed) {
+        // First tick after reset: only establish the baselines
+        r.prev_sum = cur;
+        r.last_tick = now;
+        r.primed = true;
+        return;
+    }
+
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        uint64_t delta = cur[c] - r.prev_sum[c];
+        r.totals[c] += delta;
+        r.hist[c][r.head] = (uint32_t) std::min<uint64_t>(delta, UINT32_MAX);
+    }
+    r.prev_sum = cur;
+
+    float ms =
+        std::chrono::duration<float, std::milli>(now - r.last_tick).count();
+    r.last_tick = now;
+    r.frame_ms[r.head] = ms;
+    r.frame_buckets[frame_bucket(ms)]++;
+
+    r.head = (r.head + 1) % HISTORY;
+    r.filled = std::min(r.filled + 1, HISTORY);
+    r.ticks++;
+}
+
+void reset() {
+    auto& r = reg();
+    r.totals.fill(0);
+    for (auto& h : r.hist) h.fill(0);
+    r.frame_ms.fill(0.f);
+    r.frame_buckets.fill(0);
+    r.head = 0;
+    r.filled = 0;
+    r.ticks = 0;
+    r.primed = false;
+}
+
+CounterStats stats(Counter c) {
+    auto& r = reg();
+    CounterStats st;
+    if (c >= NUM_COUNTERS) return st;
+    st.total = r.totals[c];
+    if (r.filled == 0) return st;
+    st.last = r.hist[c][(r.head - 1 + HISTORY) % HISTORY];
+    uint64_t sum = 0;
+    for (int i = 0; i < r.filled; i++) {
+        uint32_t v = r.hist[c][(r.head - 1 - i + 2 * HISTORY) % HISTORY];
+        sum += v;
+        st.peak = std::max<uint64_t>(st.peak, v);
+    }
+    st.mean = (float) sum / r.filled;
+    return st;
+}
+
+int ticks() { return reg().ticks; }
+
+void history(Counter c, std::vector<float>& out) {
+    if (c >= NUM_COUNTERS) {
+        out.clear();
+        return;
+    }
+    reg().ordered(reg().hist[c], out);
+}
+
+void frame_history(std::vector<float>& out) {
+    reg().ordered(reg().frame_ms, out);
+}
+
+const std::array<uint64_t, NUM_FRAME_BUCKETS>& frame_histogram() {
+    return reg().frame_buckets;
+}
+
+float frame_percentile(float p) {
+    std::vector<float> ms;
+    frame_history(ms);
+    if (ms.empty()) return 0.f;
+    std::sort(ms.begin(), ms.end());
+    int idx = (int) (std::clamp(p, 0.f, 1.f) * (ms.size() - 1) + 0.5f);
+    return ms[idx];
+}
+
+std::string to_json() {
+    std::string out = fmt::format(
+        "{{\"ticks\": {}, \"frame_ms\": {{\"p50\": {:.3f}, \"p95\": {:.3f}, "
+        "\"p99\": {:.3f}, \"histogram\": [",
+        ticks(), frame_percentile(0.5f), frame_percentile(0.95f),
+        frame_percentile(0.99f));
+    const auto& buckets = frame_histogram();
+    for (int i = 0; i < NUM_FRAME_BUCKETS; i++) {
+        std::string edge = i < (int) FRAME_BUCKET_MS.size()
+                               ? fmt::format("{}", FRAME_BUCKET_MS[i])
+                               : "null";
+        out += fmt::format("{}{{\"lt_ms\": {}, \"count\": {}}}",
+                           i ? ", " : "", edge, buckets[i]);
+    }
+    out += "]}, \"counters\": {";
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        auto st = stats((Counter) c);
+        out += fmt::format(
+            "{}\"{}\": {{\"total\": {}, \"mean\": {:.3f}, \"peak\": {}}}",
+            c ? ", " : "", NAMES[c], st.total, st.mean, st.peak);
+    }
+    out += "}}";
+    return out;
+}
+
+}  // namespace telemetry
+
+// Counting allocator: every other form of new/delete forwards here. The
+// count is a thread-local increment plus a relaxed store into the thread's
+// own block (no read-modify-write, no shared cache line)
+void* operator new(std::size_t size) {
+    ++telemetry::t_allocations;
+    telemetry::publish_allocations();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hot-path event counters for the debug panel, e2e asserts and benchmarks.
+//
+// bump() increments a block owned by the calling thread with a relaxed
+// load + store (one writer per block, so no read-modify-write), which keeps
+// worker-thread kernels free of shared cache lines. end_tick() runs once per
+// tick on the main thread: it sums every thread's block, turns the running
+// totals into per-tick values and keeps the last HISTORY ticks for the
+// sparklines, together with the wall-clock frame time.
+//
+// Entity creates are bumped next to every createEntity(); destroys are what
+// the entity list is short of at end_tick; allocations are counted per
+// thread by the replacement operator new in telemetry.cpp and show up once
+// that thread has a block (its first bump(); end_tick for the main thread).
+namespace telemetry {
+
+enum Counter : uint8_t {
+    Pathfinds,
+    FleeRetargets,
+    ForcedMoves,
+    LethalNoFlee,
+    FacilityAdmissions,
+    CacheRebuilds,
+    EntitiesCreated,
+    EntitiesDestroyed,
+    Allocations,
+    NUM_COUNTERS,
+};
+
+constexpr int HISTORY = 240;  // ticks kept for sparklines and percentiles
+
+// Frame-time histogram: upper bucket edges in ms, last bucket open-ended
+constexpr int NUM_FRAME_BUCKETS = 10;
+constexpr std::array<float, NUM_FRAME_BUCKETS - 1> FRAME_BUCKET_MS = {
+    4.f, 8.f, 12.f, 16.7f, 20.f, 25.f, 33.3f, 50.f, 100.f};
+
+[[nodiscard]] const char* counter_name(Counter c);
+// "pathfinds" -> Pathfinds; NUM_COUNTERS when unknown
+[[nodiscard]] Counter parse_counter(const std::string& name);
+
+struct ThreadCounters {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> v{};
+};
+
+// Allocates and registers the calling thread's block (first bump only)
+ThreadCounters& register_thread();
+
+inline void bump(Counter c, uint64_t n = 1) {
+    thread_local ThreadCounters& local = register_thread();
+    auto& slot = local.v[c];
+    slot.store(slot.load(std::memory_order_relaxed) + n,
+               std::memory_order_relaxed);
+}
+
+// Aggregate the tick that just ran (main thread, once per tick)
+void end_tick();
+
+// Forget history and totals (the running thread blocks keep counting)
+void reset();
+
+struct CounterStats {
+    uint64_t last = 0;   // most recent tick
+    uint64_t total = 0;  // since reset
+    uint64_t peak = 0;   // over the history window
+    float mean = 0.f;    // per tick over the history window
+};
+
+[[nodiscard]] CounterStats stats(Counter c);
+[[nodiscard]] int ticks();  // since reset
+
+// Oldest -> newest, at most HISTORY values
+void history(Counter c, std::vector<float>& out);
+void frame_history(std::vector<float>& out);  // ms
+
+[[nodiscard]] const std::array<uint64_t, NUM_FRAME_BUCKETS>&
+frame_histogram();
+// Frame time (ms) at percentile p in [0, 1] over the history window
+[[nodiscard]] float frame_percentile(float p);
+
+// Counters and frame times as a JSON object (benchmark output)
+[[nodiscard]] std::string to_json();
+
+}  // namespace telemetry
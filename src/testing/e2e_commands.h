@@ -7,12 +7,25 @@
 #define AFTER_HOURS_REPLACE_LOGGING
 #include "log.h"
 
+#include "audio.h"
+#include "autosave.h"
 #include "components.h"
+#include "crowd_heatmap.h"
+#include "density_history.h"
 #include "entity_makers.h"
+#include "frame_pacing.h"
 #include "game.h"
 #include "render_helpers.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "engine/parallel.h"
+#include "engine/random_engine.h"
 #include "save_system.h"
+#include "state_hash.h"
+#include "state_stream.h"
 #include "systems.h"
+#include "telemetry.h"
+#include "text_cache.h"
 #include "update_helpers.h"
 
 #include "afterhours/src/core/entity_helper.h"
@@ -72,6 +85,21 @@ inline FacilityType parse_facility_type(const std::string& s) {
     return FacilityType::Bathroom;
 }
 
+inline std::optional<BuildTool> parse_build_tool(const std::string& s) {
+    std::string lower = s;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "path") return BuildTool::Path;
+    if (lower == "fence") return BuildTool::Fence;
+    if (lower == "gate") return BuildTool::Gate;
+    if (lower == "stage") return BuildTool::Stage;
+    if (lower == "bathroom") return BuildTool::Bathroom;
+    if (lower == "food") return BuildTool::Food;
+    if (lower == "medtent" || lower == "med_tent" || lower == "med")
+        return BuildTool::MedTent;
+    if (lower == "demolish") return BuildTool::Demolish;
+    return std::nullopt;
+}
+
 inline std::optional<vec2> grid_to_screen(int gx, int gz) {
     auto* cam = EntityHelper::get_singleton_cmp<ProvidesCamera>();
     if (!cam) return std::nullopt;
@@ -116,6 +144,32 @@ static PerfSample& get_perf_sample() {
     return s;
 }
 
+// ── State hash recording (golden runs) ───────────────────────────────────
+
+// Samples state_hash::compute() every `every` ticks while active.
+struct HashRecorder {
+    int every = 0;
+    int ticks = 0;
+    std::vector<uint64_t> samples;
+
+    void start(int n) {
+        every = std::max(1, n);
+        ticks = 0;
+        samples.clear();
+    }
+    void stop() { every = 0; }
+
+    void tick() {
+        if (every <= 0) return;
+        if (++ticks % every == 0) samples.push_back(state_hash::compute());
+    }
+};
+
+static HashRecorder& get_hash_recorder() {
+    static HashRecorder r;
+    return r;
+}
+
 // ── Command handler type + dispatch registry ─────────────────────────────
 
 using E2ECmdFn = void (*)(testing::PendingE2ECommand&);
@@ -132,7 +186,13 @@ static E2ERegistry& get_registry() {
 
 // Single dispatch system replaces ~40 individual handler structs
 struct E2EDispatchSystem : System<testing::PendingE2ECommand> {
-    void once(float) override { get_perf_sample().tick(); }
+    // Replay seeks re-run update systems headlessly; commands wait
+    bool should_run(float) override { return !replay::is_seeking(); }
+
+    void once(float) override {
+        get_perf_sample().tick();
+        get_hash_recorder().tick();
+    }
 
     void for_each_with(Entity&, testing::PendingE2ECommand& cmd,
                        float) override {
@@ -203,6 +263,7 @@ static void cmd_clear_map(testing::PendingE2ECommand& cmd) {
             tile.agent_count = 0;
         }
         grid->mark_tiles_dirty();
+        grid->bump_density_version();
     }
     cmd.consume();
 }
@@ -300,6 +361,56 @@ static void cmd_assert_density(testing::PendingE2ECommand& cmd) {
         cmd.consume();
 }
 
+// RMS distance of the agents on a tile from their centroid. Stacked agents
+// give 0; agents spread by separation give roughly the separation radius.
+static void cmd_assert_agent_spread(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(4)) {
+        cmd.fail("assert_agent_spread requires X Z OP VALUE");
+        return;
+    }
+    int x = cmd.arg_as<int>(0), z = cmd.arg_as<int>(1);
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    if (!grid || !grid->in_bounds(x, z)) {
+        cmd.fail("assert_agent_spread: out of bounds");
+        return;
+    }
+    std::vector<vec2> positions;
+    auto agents = EntityQuery()
+                      .whereHasComponent<Agent>()
+                      .whereHasComponent<Transform>()
+                      .gen();
+    for (Entity& a : agents) {
+        auto& tf = a.get<Transform>();
+        auto [gx, gz] = grid->world_to_grid(tf.position.x, tf.position.y);
+        if (gx == x && gz == z) positions.push_back(tf.position);
+    }
+    float spread = 0.f;
+    if (positions.size() > 1) {
+        float mx = 0.f, mz = 0.f;
+        for (auto& p : positions) {
+            mx += p.x;
+            mz += p.y;
+        }
+        mx /= positions.size();
+        mz /= positions.size();
+        float sum = 0.f;
+        for (auto& p : positions) {
+            sum += (p.x - mx) * (p.x - mx) + (p.y - mz) * (p.y - mz);
+        }
+        spread = std::sqrt(sum / positions.size());
+    }
+    if (!compare_op_f(spread, cmd.arg(2), cmd.arg_as<float>(3)))
+        cmd.fail(fmt::format(
+            "assert_agent_spread at ({},{}) failed: {:.3f} {} {:.3f} "
+            "({} agents)",
+            x, z, spread, cmd.arg(2), cmd.arg_as<float>(3), positions.size()));
+    else {
+        log_info("assert_agent_spread PASSED: {:.3f} ({} agents)", spread,
+                 positions.size());
+        cmd.consume();
+    }
+}
+
 static void cmd_assert_tile_type(testing::PendingE2ECommand& cmd) {
     if (!cmd.has_args(3)) {
         cmd.fail("assert_tile_type requires X Z TYPE");
@@ -354,6 +465,8 @@ static void cmd_move_to_grid(testing::PendingE2ECommand& cmd) {
         return;
     }
     testing::test_input::set_mouse_position(screen->x, screen->y);
+    // Hover tracking runs in the render pass
+    frame_pacing::request_redraw();
     cmd.consume();
 }
 
@@ -382,6 +495,8 @@ static void cmd_click_grid(testing::PendingE2ECommand& cmd) {
     pds->hover_z = gz;
     pds->hover_valid = true;
     pds->hover_lock_frames = 2;
+    // Hover tracking runs in the render pass; draw the locked frames
+    frame_pacing::request_redraw(pds->hover_lock_frames + 1);
     log_info("[E2E] click_grid ({}, {}) injected mouse press", gx, gz);
     cmd.consume();
 }
@@ -1202,10 +1317,13 @@ static void cmd_perf_start(testing::PendingE2ECommand& cmd) {
     auto& s = get_perf_sample();
     s.reset();
     s.is_sampling = true;
-    log_info("[E2E] perf_start: sampling FPS every frame");
+    system_timing::reset();
+    log_info("[E2E] perf_start: sampling FPS and system times every frame");
     cmd.consume();
 }
 
+// perf_report [JSON_PATH]: log the FPS sample; with a path, also write it
+// and the telemetry counters as benchmark JSON
 static void cmd_perf_report(testing::PendingE2ECommand& cmd) {
     auto& s = get_perf_sample();
     s.is_sampling = false;
@@ -1214,6 +1332,43 @@ static void cmd_perf_report(testing::PendingE2ECommand& cmd) {
     log_info(
         "[PERF] agents={} fps: avg={:.1f} min={:.1f} max={:.1f} samples={}",
         agent_count, s.avg(), s.fps_min, s.fps_max, s.sample_count);
+    system_timing::Summary logic, render;
+    system_timing::summarize(system_timing::LOGIC, logic);
+    system_timing::summarize(system_timing::RENDER, render);
+    log_info("[PERF] logic ms: p50={:.2f} p99={:.2f}  render ms: p50={:.2f} "
+             "p99={:.2f}",
+             logic.p50, logic.p99, render.p50, render.p99);
+    for (auto& [name, st] : system_timing::slowest(5)) {
+        log_info("[PERF]   {} p50={:.3f}ms p99={:.3f}ms max={:.3f}ms", name,
+                 st.p50, st.p99, st.max);
+    }
+    if (cmd.has_args(1)) {
+        auto timing = [](const system_timing::Summary& st) {
+            return fmt::format(
+                "{{\"p50\": {:.3f}, \"p99\": {:.3f}, \"max\": {:.3f}}}",
+                st.p50, st.p99, st.max);
+        };
+        std::string systems;
+        for (auto& [name, st] : system_timing::slowest(1000)) {
+            systems += fmt::format("{}\"{}\": {}", systems.empty() ? "" : ", ",
+                                   name, timing(st));
+        }
+        std::string json = fmt::format(
+            "{{\"agents\": {}, \"fps\": {{\"avg\": {:.2f}, \"min\": "
+            "{:.2f}, \"max\": {:.2f}, \"samples\": {}}}, \"logic_ms\": "
+            "{}, \"render_ms\": {}, \"systems_ms\": {{{}}}, "
+            "\"telemetry\": {}}}\n",
+            agent_count, s.avg(), s.fps_min, s.fps_max, s.sample_count,
+            timing(logic), timing(render), systems, telemetry::to_json());
+        auto parent = std::filesystem::path(cmd.arg(0)).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        std::ofstream out(cmd.arg(0));
+        if (!(out << json)) {
+            cmd.fail("perf_report: cannot write " + cmd.arg(0));
+            return;
+        }
+        log_info("[PERF] benchmark written to {}", cmd.arg(0));
+    }
     cmd.consume();
 }
 
@@ -1256,6 +1411,94 @@ static void cmd_assert_min_fps(testing::PendingE2ECommand& cmd) {
     }
 }
 
+// "2.0ms" / "500us" / "2.0" (ms) -> ms; false when not a number
+static bool parse_ms(const std::string& text, float& out) {
+    std::string num = text;
+    float scale = 1.f;
+    if (num.ends_with("ms")) {
+        num.resize(num.size() - 2);
+    } else if (num.ends_with("us")) {
+        num.resize(num.size() - 2);
+        scale = 0.001f;
+    }
+    try {
+        size_t used = 0;
+        out = std::stof(num, &used) * scale;
+        return used == num.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Shared by the tick-time assertions: NAME STAT OP VALUE against the
+// samples since perf_start (or the last WINDOW ticks)
+static void assert_timing(testing::PendingE2ECommand& cmd,
+                          const char* label, const std::string& name,
+                          size_t first) {
+    const std::string& stat = cmd.arg(first);
+    const std::string& op = cmd.arg(first + 1);
+    float expected = 0.f;
+    if (!parse_ms(cmd.arg(first + 2), expected)) {
+        cmd.fail(fmt::format("{}: bad time '{}'", label, cmd.arg(first + 2)));
+        return;
+    }
+    system_timing::Summary st;
+    if (!system_timing::summarize(name, st)) {
+        cmd.fail(fmt::format("{}: no timed system named '{}'", label, name));
+        return;
+    }
+    if (st.samples == 0) {
+        cmd.fail(fmt::format("{}: {} has not run since perf_start", label,
+                             name));
+        return;
+    }
+    float actual = 0.f;
+    if (!st.get(stat, actual)) {
+        cmd.fail(fmt::format("{}: unknown stat '{}' (mean|p50|p90|p95|p99|"
+                             "max)",
+                             label, stat));
+        return;
+    }
+    if (!compare_op_f(actual, op, expected))
+        cmd.fail(fmt::format(
+            "[PERF] {} FAILED: {} {} = {:.3f}ms, expected {} {:.3f}ms ({} "
+            "ticks, p50 {:.3f}ms, max {:.3f}ms)",
+            label, name, stat, actual, op, expected, st.samples, st.p50,
+            st.max));
+    else {
+        log_info("[PERF] {} PASSED: {} {} = {:.3f}ms {} {:.3f}ms", label,
+                 name, stat, actual, op, expected);
+        cmd.consume();
+    }
+}
+
+// assert_system_time AgentMovementSystem p99 lt 2.0ms
+static void cmd_assert_system_time(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(4)) {
+        cmd.fail("assert_system_time requires SYSTEM STAT OP TIME");
+        return;
+    }
+    assert_timing(cmd, "assert_system_time", cmd.arg(0), 1);
+}
+
+// All game update systems (excludes input, e2e and MCP plumbing)
+static void cmd_assert_logic_time(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_logic_time requires STAT OP TIME");
+        return;
+    }
+    assert_timing(cmd, "assert_logic_time", system_timing::LOGIC, 0);
+}
+
+// Render passes up to (not including) the present/vsync wait
+static void cmd_assert_render_time(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_render_time requires STAT OP TIME");
+        return;
+    }
+    assert_timing(cmd, "assert_render_time", system_timing::RENDER, 0);
+}
+
 // ── NUX hint commands ─────────────────────────────────────────────────────
 
 // assert_nux_active <substring> — assert a NUX containing the substring is
@@ -1515,6 +1758,7 @@ static void cmd_trigger_event(testing::PendingE2ECommand& cmd) {
     EventType type = parse_event_type(cmd.arg(0));
     float duration = cmd.arg_as<float>(1);
     Entity& ev_entity = EntityHelper::createEntity();
+    telemetry::bump(telemetry::EntitiesCreated);
     ev_entity.addComponent<ActiveEvent>();
     auto& ev = ev_entity.get<ActiveEvent>();
     ev.type = type;
@@ -1678,6 +1922,61 @@ static void cmd_load_game(testing::PendingE2ECommand& cmd) {
     cmd.consume();
 }
 
+// assert_save_rejects_section ID - cut section ID (e.g. AGNT) of the save
+// file down to two raw bytes, load that image and require the load to fail
+// without changing the world
+static void cmd_assert_save_rejects_section(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1) || cmd.arg(0).size() != 4) {
+        cmd.fail("assert_save_rejects_section requires a 4-letter ID");
+        return;
+    }
+    std::ifstream in(save::save_file(), std::ios::binary);
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+    const std::string& name = cmd.arg(0);
+    uint32_t id = (uint32_t) (uint8_t) name[0] |
+                  ((uint32_t) (uint8_t) name[1] << 8) |
+                  ((uint32_t) (uint8_t) name[2] << 16) |
+                  ((uint32_t) (uint8_t) name[3] << 24);
+    save::ByteReader hdr{image.data(), image.size()};
+    hdr.get<uint32_t>();
+    hdr.get<uint32_t>();
+    uint32_t count = hdr.get<uint32_t>();
+    bool cut = false;
+    for (uint32_t i = 0; i < count && hdr.ok && !cut; i++) {
+        size_t at = hdr.at;
+        hdr.at += save::section::ENTRY_SIZE;
+        if (!hdr.ok || hdr.at > image.size()) break;
+        uint32_t entry_id;
+        std::memcpy(&entry_id, image.data() + at, sizeof(entry_id));
+        if (entry_id != id) continue;
+        // flags = 0 (stored raw), stored = raw = 2
+        const uint16_t flags = 0;
+        const uint32_t len = 2;
+        std::memcpy(image.data() + at + 6, &flags, sizeof(flags));
+        std::memcpy(image.data() + at + 12, &len, sizeof(len));
+        std::memcpy(image.data() + at + 16, &len, sizeof(len));
+        cut = true;
+    }
+    if (!cut) {
+        cmd.fail("assert_save_rejects_section: no section " + cmd.arg(0) +
+                 " in " + save::save_file());
+        return;
+    }
+    uint64_t before = state_hash::compute();
+    bool loaded = save::load_game_from_memory(image.data(), image.size());
+    uint64_t after = state_hash::compute();
+    if (loaded || before != after)
+        cmd.fail(fmt::format("assert_save_rejects_section failed: {} cut, "
+                             "loaded={} state {}",
+                             cmd.arg(0), loaded,
+                             before == after ? "kept" : "changed"));
+    else {
+        log_info("assert_save_rejects_section PASSED: {}", cmd.arg(0));
+        cmd.consume();
+    }
+}
+
 static void cmd_assert_save_exists(testing::PendingE2ECommand& cmd) {
     if (save::has_save_file()) {
         log_info("assert_save_exists PASSED");
@@ -1693,95 +1992,1299 @@ static void cmd_delete_save(testing::PendingE2ECommand& cmd) {
     cmd.consume();
 }
 
-// ── Registration ─────────────────────────────────────────────────────────
+static void cmd_set_autosave(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_autosave requires SECONDS [KEEP] (0 = off)");
+        return;
+    }
+    int keep = cmd.has_args(2) ? cmd.arg_as<int>(1) : autosave::keep();
+    autosave::configure(cmd.arg_as<float>(0), keep);
+    log_info("[E2E] set_autosave: every {}s, keep {}", autosave::interval(),
+             autosave::keep());
+    cmd.consume();
+}
 
-static void init_e2e_registry() {
-    auto& r = get_registry();
-    if (!r.handlers.empty()) return;
-    r.add("spawn_agent", cmd_spawn_agent);
-    r.add("spawn_agents", cmd_spawn_agents);
-    r.add("clear_agents", cmd_clear_agents);
-    r.add("clear_map", cmd_clear_map);
-    r.add("reset_game", cmd_reset_game);
-    r.add("place_facility", cmd_place_facility);
-    r.add("set_tile", cmd_set_tile);
-    r.add("get_agent_count", cmd_get_agent_count);
-    r.add("get_density", cmd_get_density);
-    r.add("assert_agent_count", cmd_assert_agent_count);
-    r.add("assert_density", cmd_assert_density);
-    r.add("assert_tile_type", cmd_assert_tile_type);
-    r.add("draw_path_rect", cmd_draw_path_rect);
-    r.add("move_to_grid", cmd_move_to_grid);
-    r.add("click_grid", cmd_click_grid);
-    r.add("assert_agent_near", cmd_assert_agent_near);
-    r.add("set_spawn_rate", cmd_set_spawn_rate);
-    r.add("set_spawn_enabled", cmd_set_spawn_enabled);
-    r.add("force_need", cmd_force_need);
-    r.add("assert_agents_at_facility", cmd_assert_agents_at_facility);
-    r.add("assert_agent_watching", cmd_assert_agent_watching);
-    r.add("assert_agents_on_tiletype", cmd_assert_agents_on_tiletype);
-    r.add("place_gate", cmd_place_gate);
-    r.add("assert_gate_count", cmd_assert_gate_count);
-    r.add("assert_blocked", cmd_assert_blocked);
-    r.add("toggle_debug", cmd_toggle_debug);
-    r.add("trigger_game_over", cmd_trigger_game_over);
-    r.add("assert_game_status", cmd_assert_game_status);
-    r.add("toggle_overlay", cmd_toggle_overlay);
-    r.add("assert_overlay", cmd_assert_overlay);
-    r.add("set_agent_speed", cmd_set_agent_speed);
-    r.add("set_move_speed", cmd_set_move_speed);
-    r.add("get_death_count", cmd_get_death_count);
-    r.add("set_death_count", cmd_set_death_count);
-    r.add("assert_death_count", cmd_assert_death_count);
-    r.add("assert_agent_hp", cmd_assert_agent_hp);
-    r.add("set_time", cmd_set_time);
-    r.add("set_speed", cmd_set_speed);
-    r.add("assert_phase", cmd_assert_phase);
-    r.add("assert_time_between", cmd_assert_time_between);
-    r.add("assert_stage_state", cmd_assert_stage_state);
-    r.add("force_artist", cmd_force_artist);
-    r.add("assert_agents_exited", cmd_assert_agents_exited);
-    r.add("assert_carryover_count", cmd_assert_carryover_count);
-    r.add("set_pheromone", cmd_set_pheromone);
-    r.add("assert_pheromone", cmd_assert_pheromone);
-    r.add("clear_pheromones", cmd_clear_pheromones);
-    r.add("set_max_attendees", cmd_set_max_attendees);
-    r.add("assert_max_attendees", cmd_assert_max_attendees);
-    r.add("assert_slots", cmd_assert_slots);
-    r.add("select_tool", cmd_select_tool);
-    r.add("assert_tool", cmd_assert_tool);
-    r.add("place_building", cmd_place_building);
-    r.add("demolish_at", cmd_demolish_at);
-    r.add("set_all_agent_hp", cmd_set_all_agent_hp);
-    r.add("perf_start", cmd_perf_start);
-    r.add("perf_report", cmd_perf_report);
-    r.add("assert_fps", cmd_assert_fps);
-    r.add("assert_min_fps", cmd_assert_min_fps);
-    r.add("assert_nux_active", cmd_assert_nux_active);
-    r.add("assert_nux_inactive", cmd_assert_nux_inactive);
-    r.add("assert_nux_count", cmd_assert_nux_count);
-    r.add("dismiss_nux", cmd_dismiss_nux);
-    r.add("assert_pixel", cmd_assert_pixel);
-    r.add("assert_region_not_blank", cmd_assert_region_not_blank);
-    r.add("set_zoom", cmd_set_zoom);
-    r.add("trigger_event", cmd_trigger_event);
-    r.add("assert_event_active", cmd_assert_event_active);
-    r.add("assert_event_inactive", cmd_assert_event_inactive);
-    r.add("assert_day_number", cmd_assert_day_number);
-    r.add("set_day_number", cmd_set_day_number);
-    r.add("assert_spawn_rate", cmd_assert_spawn_rate);
-    r.add("assert_toast_contains", cmd_assert_toast_contains);
-    r.add("assert_no_toast", cmd_assert_no_toast);
-    r.add("save_game", cmd_save_game);
-    r.add("load_game", cmd_load_game);
-    r.add("assert_save_exists", cmd_assert_save_exists);
-    r.add("delete_save", cmd_delete_save);
+static void cmd_autosave_now(testing::PendingE2ECommand& cmd) {
+    if (!autosave::request_now()) {
+        cmd.fail("autosave_now: writer busy or nothing to save");
+        return;
+    }
+    cmd.consume();
+}
+
+// Wait for the background writer so later asserts see the files
+static void cmd_autosave_flush(testing::PendingE2ECommand& cmd) {
+    autosave::flush();
+    cmd.consume();
+}
+
+static void cmd_assert_autosave(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_autosave requires files|written|failed OP VALUE");
+        return;
+    }
+    const std::string& what = cmd.arg(0);
+    auto st = autosave::stats();
+    int actual = 0;
+    if (what == "files") {
+        actual = autosave::files_on_disk();
+    } else if (what == "written") {
+        actual = (int) st.written;
+    } else if (what == "failed") {
+        actual = (int) st.failed;
+    } else {
+        cmd.fail("assert_autosave: unknown field " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_autosave failed: {} {} {} (actual: {})",
+                             what, cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_autosave PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+static void cmd_load_autosave(testing::PendingE2ECommand& cmd) {
+    int slot = cmd.has_args(1) ? cmd.arg_as<int>(0) : 1;
+    autosave::flush();
+    if (!save::load_game(autosave::path_for(slot))) {
+        cmd.fail(fmt::format("load_autosave: slot {} failed to load", slot));
+        return;
+    }
+    log_info("[E2E] load_autosave: loaded slot {}", slot);
+    cmd.consume();
+}
+
+static void cmd_discard_autosaves(testing::PendingE2ECommand& cmd) {
+    autosave::discard();
+    cmd.consume();
+}
+
+// ── Replay ───────────────────────────────────────────────────────────────
+
+// Build through the player's path (queued for PathBuildSystem, recorded)
+static void cmd_player_build(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("player_build requires TOOL X0 Z0 [X1 Z1]");
+        return;
+    }
+    auto tool = parse_build_tool(cmd.arg(0));
+    if (!tool) {
+        cmd.fail("player_build: unknown tool " + cmd.arg(0));
+        return;
+    }
+    int x0 = cmd.arg_as<int>(1), z0 = cmd.arg_as<int>(2);
+    int x1 = cmd.has_args(5) ? cmd.arg_as<int>(3) : x0;
+    int z1 = cmd.has_args(5) ? cmd.arg_as<int>(4) : z0;
+    queue_build(*tool, x0, z0, x1, z1);
+    cmd.consume();
+}
+
+static void cmd_replay_record(testing::PendingE2ECommand& cmd) {
+    float every = cmd.has_args(1) ? cmd.arg_as<float>(0)
+                                  : replay::DEFAULT_KEYFRAME_SECONDS;
+    replay::start_recording(every);
+    cmd.consume();
+}
+
+static void cmd_replay_stop(testing::PendingE2ECommand& cmd) {
+    replay::stop();
+    cmd.consume();
+}
+
+// TICK or "end"; runs before the next frame's tick
+static void cmd_replay_seek(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("replay_seek requires TICK|end");
+        return;
+    }
+    uint32_t tick = cmd.arg(0) == "end" ? replay::length()
+                                        : (uint32_t) cmd.arg_as<int>(0);
+    replay::request_seek(tick);
+    cmd.consume();
+}
+
+// replay_save NAME / replay_load NAME - NAME is relative to the save dir
+static void cmd_replay_save(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1) ||
+        !replay::write_file(save::save_dir() + "/" + cmd.arg(0))) {
+        cmd.fail("replay_save requires NAME and a recording");
+        return;
+    }
+    cmd.consume();
+}
+
+static void cmd_replay_load(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1) ||
+        !replay::load_file(save::save_dir() + "/" + cmd.arg(0))) {
+        cmd.fail("replay_load: could not load " +
+                 (cmd.has_args(1) ? cmd.arg(0) : std::string("(no name)")));
+        return;
+    }
+    cmd.consume();
+}
+
+// assert_replay_rejects NAME BYTES - a copy of NAME cut to BYTES (or, for
+// -BYTES, that many short of the end) must fail to load and leave no
+// recording behind
+static void cmd_assert_replay_rejects(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("assert_replay_rejects requires NAME BYTES");
+        return;
+    }
+    std::string src = save::save_dir() + "/" + cmd.arg(0);
+    std::string cut = src + ".cut";
+    std::error_code ec;
+    std::filesystem::copy_file(
+        src, cut, std::filesystem::copy_options::overwrite_existing, ec);
+    long long bytes = cmd.arg_as<long long>(1);
+    if (!ec && bytes < 0)
+        bytes += (long long) std::filesystem::file_size(src, ec);
+    if (!ec && bytes >= 0)
+        std::filesystem::resize_file(cut, (uintmax_t) bytes, ec);
+    if (ec) {
+        cmd.fail("assert_replay_rejects: cannot copy " + src);
+        return;
+    }
+    bool loaded = replay::load_file(cut);
+    std::filesystem::remove(cut, ec);
+    if (loaded || replay::stats().ticks != 0)
+        cmd.fail(fmt::format("assert_replay_rejects failed: {} cut to {} "
+                             "bytes loaded",
+                             cmd.arg(0), cmd.arg(1)));
+    else {
+        log_info("assert_replay_rejects PASSED: {} cut to {} bytes",
+                 cmd.arg(0), cmd.arg(1));
+        cmd.consume();
+    }
+}
+
+static void cmd_assert_replay(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail(
+            "assert_replay requires ticks|actions|keyframes|verified|desyncs|"
+            "playing OP VALUE");
+        return;
+    }
+    const std::string& what = cmd.arg(0);
+    auto st = replay::stats();
+    int actual = 0;
+    if (what == "ticks") {
+        actual = (int) replay::length();
+    } else if (what == "actions") {
+        actual = (int) st.actions;
+    } else if (what == "keyframes") {
+        actual = (int) st.keyframes;
+    } else if (what == "verified") {
+        actual = (int) st.verified;
+    } else if (what == "desyncs") {
+        actual = (int) st.desyncs;
+    } else if (what == "playing") {
+        actual = replay::is_playing() ? 1 : 0;
+    } else {
+        cmd.fail("assert_replay: unknown field " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_replay failed: {} {} {} (actual: {})",
+                             what, cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_replay PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Density history ──────────────────────────────────────────────────────
+
+// set_density_history INTERVAL [BUDGET_KB]
+static void cmd_set_density_history(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_density_history requires INTERVAL [BUDGET_KB]");
+        return;
+    }
+    size_t budget = cmd.has_args(2)
+                        ? (size_t) cmd.arg_as<int>(1) * 1024
+                        : density_history::DEFAULT_BUDGET;
+    density_history::configure(cmd.arg_as<float>(0), budget);
+    log_info("[E2E] density history: every {:.2f}s, budget {} bytes",
+             density_history::interval(), budget);
+    cmd.consume();
+}
+
+static void cmd_density_history_sample(testing::PendingE2ECommand& cmd) {
+    density_history::sample_now();
+    cmd.consume();
+}
+
+static void cmd_assert_density_history(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail(
+            "assert_density_history requires samples|frames|blocks|merges|"
+            "bytes|span OP VALUE");
+        return;
+    }
+    const std::string& what = cmd.arg(0);
+    auto st = density_history::stats();
+    int actual = 0;
+    if (what == "samples") {
+        actual = (int) st.samples;
+    } else if (what == "frames") {
+        actual = st.frames;
+    } else if (what == "blocks") {
+        actual = st.blocks;
+    } else if (what == "merges") {
+        actual = (int) st.merges;
+    } else if (what == "bytes") {
+        actual = (int) st.bytes;
+    } else if (what == "span") {
+        actual = st.coarsest_span;
+    } else {
+        cmd.fail("assert_density_history: unknown field " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format(
+            "assert_density_history failed: {} {} {} (actual: {})", what,
+            cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_density_history PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// assert_density_window X Z max|mean OP VALUE [T0 T1]
+// Without T0/T1 the whole recorded run is queried.
+static void cmd_assert_density_window(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(5)) {
+        cmd.fail(
+            "assert_density_window requires X Z max|mean OP VALUE [T0 T1]");
+        return;
+    }
+    int x = cmd.arg_as<int>(0), z = cmd.arg_as<int>(1);
+    if (x < 0 || x >= MAP_SIZE || z < 0 || z >= MAP_SIZE) {
+        cmd.fail("assert_density_window: out of bounds");
+        return;
+    }
+    density_history::Window w;
+    bool found = cmd.has_args(7)
+                     ? density_history::query(cmd.arg_as<float>(5),
+                                              cmd.arg_as<float>(6), w)
+                     : density_history::query_all(w);
+    if (!found) {
+        cmd.fail("assert_density_window: no history in window");
+        return;
+    }
+    const std::string& what = cmd.arg(2);
+    int idx = z * MAP_SIZE + x;
+    float actual = 0.f;
+    if (what == "max") {
+        actual = (float) w.max[idx];
+    } else if (what == "mean") {
+        actual = w.mean[idx];
+    } else {
+        cmd.fail("assert_density_window: unknown stat " + what);
+        return;
+    }
+    float expected = cmd.arg_as<float>(4);
+    if (!compare_op_f(actual, cmd.arg(3), expected))
+        cmd.fail(fmt::format(
+            "assert_density_window failed: ({},{}) {} {:.2f} {} {:.2f}", x, z,
+            what, actual, cmd.arg(3), expected));
+    else {
+        log_info("assert_density_window PASSED: ({},{}) {} = {:.2f} over "
+                 "[{:.1f}, {:.1f}]",
+                 x, z, what, actual, w.t0, w.t1);
+        cmd.consume();
+    }
+}
+
+// ── Far LOD heatmap ──────────────────────────────────────────────────────
+
+// assert_far_heatmap X Z r|g|b|a OP VALUE
+// Reads the Far LOD texel for tile (X,Z), rebuilding the field first if the
+// densities were recounted since the last draw.
+static void cmd_assert_far_heatmap(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(5)) {
+        cmd.fail("assert_far_heatmap requires X Z r|g|b|a OP VALUE");
+        return;
+    }
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    if (!grid) {
+        cmd.fail("assert_far_heatmap: no grid");
+        return;
+    }
+    crowd_heatmap::refresh(*grid);
+    int x = cmd.arg_as<int>(0), z = cmd.arg_as<int>(1);
+    Color c = crowd_heatmap::texel(x, z);
+    const std::string& ch = cmd.arg(2);
+    int actual = 0;
+    if (ch == "r") {
+        actual = c.r;
+    } else if (ch == "g") {
+        actual = c.g;
+    } else if (ch == "b") {
+        actual = c.b;
+    } else if (ch == "a") {
+        actual = c.a;
+    } else {
+        cmd.fail("assert_far_heatmap: unknown channel " + ch);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(3), cmd.arg_as<int>(4)))
+        cmd.fail(fmt::format("assert_far_heatmap failed: ({},{}) {} {} {} "
+                             "(actual: {})",
+                             x, z, ch, cmd.arg(3), cmd.arg_as<int>(4), actual));
+    else {
+        log_info("assert_far_heatmap PASSED: ({},{}) {} = {}", x, z, ch,
+                 actual);
+        cmd.consume();
+    }
+}
+
+// assert_density_version same|changed
+// Compares Grid::density_version with what the previous call saw. It only
+// changes when a recount moved some tile's counts, so the density layers
+// rebuild only then.
+static void cmd_assert_density_version(testing::PendingE2ECommand& cmd) {
+    static uint64_t last_seen = 0;
+    if (!cmd.has_args(1)) {
+        cmd.fail("assert_density_version requires same|changed");
+        return;
+    }
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    if (!grid) {
+        cmd.fail("assert_density_version: no grid");
+        return;
+    }
+    const std::string& want = cmd.arg(0);
+    if (want != "same" && want != "changed") {
+        cmd.fail("assert_density_version: expected same|changed, got " +
+                 want);
+        return;
+    }
+    bool changed = grid->density_version != last_seen;
+    last_seen = grid->density_version;
+    if (changed != (want == "changed"))
+        cmd.fail(fmt::format("assert_density_version failed: expected {}",
+                             want));
+    else {
+        log_info("assert_density_version PASSED: {}", want);
+        cmd.consume();
+    }
+}
+
+// ── Agent tile index ─────────────────────────────────────────────────────
+
+// assert_agent_index agents|tile_agents OP VALUE [X Z]
+// Checks the per-tile agent index the Close LOD renderer walks: every
+// indexed agent, or those bucketed on tile (X,Z).
+static void cmd_assert_agent_index(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_agent_index requires agents|tile_agents OP VALUE "
+                 "[X Z]");
+        return;
+    }
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    if (!grid) {
+        cmd.fail("assert_agent_index: no grid");
+        return;
+    }
+    const auto& index = grid->agent_index;
+    const std::string& what = cmd.arg(0);
+    int actual = 0;
+    if (what == "agents") {
+        actual = index.hash.size();
+    } else if (what == "tile_agents" && cmd.has_args(5)) {
+        int x = cmd.arg_as<int>(3), z = cmd.arg_as<int>(4);
+        if (!grid->in_bounds(x, z)) {
+            cmd.fail("assert_agent_index: out of bounds");
+            return;
+        }
+        auto [first, last] = index.row(z, x, x);
+        actual = last - first;
+    } else {
+        cmd.fail("assert_agent_index: unknown stat " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_agent_index failed: {} {} {} "
+                             "(actual: {})",
+                             what, cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_agent_index PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Text cache ───────────────────────────────────────────────────────────
+
+static void cmd_reset_text_cache_stats(testing::PendingE2ECommand& cmd) {
+    text_cache::reset_stats();
+    cmd.consume();
+}
+
+// assert_text_cache hits|misses|entries OP VALUE
+static void cmd_assert_text_cache(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_text_cache requires hits|misses|entries OP VALUE");
+        return;
+    }
+    auto st = text_cache::stats();
+    const std::string& what = cmd.arg(0);
+    int actual = 0;
+    if (what == "hits") {
+        actual = (int) st.hits;
+    } else if (what == "misses") {
+        actual = (int) st.misses;
+    } else if (what == "entries") {
+        actual = (int) st.entries;
+    } else {
+        cmd.fail("assert_text_cache: unknown stat " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_text_cache failed: {} {} {} (actual: {})",
+                             what, cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_text_cache PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Render queue ─────────────────────────────────────────────────────────
+
+// assert_render_queue commands|runs OP VALUE
+// Checks the last world-pass flush (primitives drawn, same-state runs)
+static void cmd_assert_render_queue(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_render_queue requires commands|runs OP VALUE");
+        return;
+    }
+    auto st = render_queue::last_stats();
+    const std::string& what = cmd.arg(0);
+    int actual = 0;
+    if (what == "commands") {
+        actual = (int) st.commands;
+    } else if (what == "runs") {
+        actual = (int) st.runs;
+    } else {
+        cmd.fail("assert_render_queue: unknown stat " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format(
+            "assert_render_queue failed: {} {} {} (actual: {})", what,
+            cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_render_queue PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Frame pacing ─────────────────────────────────────────────────────────
+
+// set_frame_pacing adaptive|fixed|on-demand (also resets the frame counts)
+static void cmd_set_frame_pacing(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_frame_pacing requires adaptive|fixed|on-demand");
+        return;
+    }
+    auto mode = frame_pacing::parse_mode(cmd.arg(0));
+    if (!mode) {
+        cmd.fail("set_frame_pacing: unknown mode " + cmd.arg(0));
+        return;
+    }
+    frame_pacing::set_mode(*mode);
+    frame_pacing::reset_stats();
+    log_info("[E2E] set_frame_pacing {}", cmd.arg(0));
+    cmd.consume();
+}
+
+// render_frames N: draw the next N frames whatever the pacing mode
+static void cmd_render_frames(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("render_frames requires N");
+        return;
+    }
+    frame_pacing::request_redraw(cmd.arg_as<int>(0));
+    cmd.consume();
+}
+
+// assert_frame_pacing rendered|skipped OP VALUE (since set_frame_pacing)
+static void cmd_assert_frame_pacing(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_frame_pacing requires rendered|skipped OP VALUE");
+        return;
+    }
+    auto st = frame_pacing::stats();
+    const std::string& what = cmd.arg(0);
+    int actual = 0;
+    if (what == "rendered") {
+        actual = (int) st.rendered;
+    } else if (what == "skipped") {
+        actual = (int) st.skipped;
+    } else {
+        cmd.fail("assert_frame_pacing: unknown stat " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format(
+            "assert_frame_pacing failed: {} {} {} (actual: {})", what,
+            cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_frame_pacing PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Audio synthesis ──────────────────────────────────────────────────────
+
+// bench_audio_startup [PATH]
+// Times the audio startup work (SFX + beat loop) against an empty cache
+// (synthesis) and again against the cache it just wrote (mapped loads);
+// fails unless the warm run is all cache hits with identical samples.
+// PATH gets the timings as JSON for tests/e2e/bench.
+static void cmd_bench_audio_startup(testing::PendingE2ECommand& cmd) {
+    std::string saved = audio_synth::cache_dir();
+    std::string dir = save::save_dir() + "/audio_bench";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    audio_synth::set_cache_dir(dir);
+
+    auto recipes = AudioManager::sfx_recipes();
+    struct Run {
+        std::vector<audio_synth::Pcm> sfx;
+        int cached = 0;
+        float sfx_ms = 0.f, music_ms = 0.f;
+    };
+    auto run = [&]() {
+        Run r;
+        r.sfx = audio_synth::prepare(recipes);
+        r.cached += audio_synth::last_stats().cached;
+        r.sfx_ms = audio_synth::last_stats().ms;
+        (void) audio_synth::wav_file(AudioManager::beat_recipe());
+        r.cached += audio_synth::last_stats().cached;
+        r.music_ms = audio_synth::last_stats().ms;
+        return r;
+    };
+    Run cold = run();
+    Run warm = run();
+
+    bool same = true;
+    for (size_t i = 0; i < recipes.size(); i++) {
+        const auto& a = cold.sfx[i];
+        const auto& b = warm.sfx[i];
+        same = same && a.size() == b.size() &&
+               std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    }
+    audio_synth::set_cache_dir(saved);
+    std::filesystem::remove_all(dir, ec);
+
+    log_info("[PERF] audio startup: cold sfx={:.2f}ms music={:.2f}ms  warm "
+             "sfx={:.2f}ms music={:.2f}ms  (threads={})",
+             cold.sfx_ms, cold.music_ms, warm.sfx_ms, warm.music_ms,
+             parallel::worker_count());
+    int expected = (int) recipes.size() + 1;
+    if (cold.cached != 0 || warm.cached != expected) {
+        cmd.fail(fmt::format(
+            "bench_audio_startup: cache hits cold={} warm={} (expected 0, {})",
+            cold.cached, warm.cached, expected));
+        return;
+    }
+    if (!same) {
+        cmd.fail("bench_audio_startup: cached SFX differ from synthesized");
+        return;
+    }
+    if (cmd.has_args(1)) {
+        auto timing = [](const Run& r) {
+            return fmt::format(
+                "{{\"sfx_ms\": {:.3f}, \"music_ms\": {:.3f}, \"total_ms\": "
+                "{:.3f}}}",
+                r.sfx_ms, r.music_ms, r.sfx_ms + r.music_ms);
+        };
+        std::string json = fmt::format(
+            "{{\"threads\": {}, \"waveforms\": {}, \"cold\": {}, \"warm\": "
+            "{}}}\n",
+            parallel::worker_count(), expected, timing(cold), timing(warm));
+        auto parent = std::filesystem::path(cmd.arg(0)).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        std::ofstream out(cmd.arg(0));
+        if (!(out << json)) {
+            cmd.fail("bench_audio_startup: cannot write " + cmd.arg(0));
+            return;
+        }
+        log_info("[PERF] benchmark written to {}", cmd.arg(0));
+    }
+    cmd.consume();
+}
+
+// ── Logging ──────────────────────────────────────────────────────────────
+
+// log_flood COUNT [limited]: push COUNT messages from one call site as fast
+// as possible; "limited" routes them through a 10-per-minute rate limit
+static void cmd_log_flood(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("log_flood requires COUNT [limited]");
+        return;
+    }
+    int count = cmd.arg_as<int>(0);
+    bool limited = cmd.has_args(2) && cmd.arg(1) == "limited";
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        if (limited) {
+            log_info_limited(10, std::chrono::seconds(60),
+                             "[E2E] log flood {} of {} ({:.1f})", i, count,
+                             i * 0.5f);
+        } else {
+            log_info("[E2E] log flood {} of {} ({:.1f})", i, count, i * 0.5f);
+        }
+    }
+    double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count();
+    log_info("[E2E] log flood: {} messages in {:.0f}us on the caller", count,
+             us);
+    cmd.consume();
+}
+
+static void cmd_log_flush(testing::PendingE2ECommand& cmd) {
+    log_flush();
+    cmd.consume();
+}
+
+// assert_log enqueued|written|pending|dropped|suppressed OP VALUE
+static void cmd_assert_log(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail(
+            "assert_log requires enqueued|written|pending|dropped|suppressed "
+            "OP VALUE");
+        return;
+    }
+    const std::string& what = cmd.arg(0);
+    auto st = log_stats();
+    int actual = 0;
+    if (what == "enqueued") {
+        actual = (int) st.enqueued;
+    } else if (what == "written") {
+        actual = (int) st.written;
+    } else if (what == "pending") {
+        actual = (int) (st.enqueued - st.written);
+    } else if (what == "dropped") {
+        actual = (int) st.dropped;
+    } else if (what == "suppressed") {
+        actual = (int) st.suppressed;
+    } else {
+        cmd.fail("assert_log: unknown field " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_log failed: {} {} {} (actual: {})", what,
+                             cmd.arg(1), cmd.arg_as<int>(2), actual));
+    else {
+        log_info("assert_log PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// ── Telemetry counters ───────────────────────────────────────────────────
+
+static void cmd_reset_counters(testing::PendingE2ECommand& cmd) {
+    telemetry::reset();
+    cmd.consume();
+}
+
+// assert_counter NAME last|total|mean|peak OP VALUE (per-tick counters)
+static void cmd_assert_counter(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(4)) {
+        cmd.fail("assert_counter requires NAME last|total|mean|peak OP VALUE");
+        return;
+    }
+    auto counter = telemetry::parse_counter(cmd.arg(0));
+    if (counter == telemetry::NUM_COUNTERS) {
+        cmd.fail("assert_counter: unknown counter " + cmd.arg(0));
+        return;
+    }
+    auto st = telemetry::stats(counter);
+    const std::string& what = cmd.arg(1);
+    float actual = 0.f;
+    if (what == "last") {
+        actual = (float) st.last;
+    } else if (what == "total") {
+        actual = (float) st.total;
+    } else if (what == "mean") {
+        actual = st.mean;
+    } else if (what == "peak") {
+        actual = (float) st.peak;
+    } else {
+        cmd.fail("assert_counter: unknown stat " + what);
+        return;
+    }
+    float expected = cmd.arg_as<float>(3);
+    if (!compare_op_f(actual, cmd.arg(2), expected))
+        cmd.fail(fmt::format("assert_counter failed: {} {} {:.2f} {} {:.2f}",
+                             cmd.arg(0), what, actual, cmd.arg(2), expected));
+    else {
+        log_info("assert_counter PASSED: {} {} = {:.2f} ({} ticks)",
+                 cmd.arg(0), what, actual, telemetry::ticks());
+        cmd.consume();
+    }
+}
+
+// ── Hybrid simulation ────────────────────────────────────────────────────
+
+static void cmd_set_hybrid_sim(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_hybrid_sim requires 0|1");
+        return;
+    }
+    auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+    if (!mc) {
+        cmd.fail("set_hybrid_sim: no MacroCrowd");
+        return;
+    }
+    mc->enabled = cmd.arg_as<int>(0) != 0;
+    log_info("[E2E] set_hybrid_sim: {}", mc->enabled);
+    cmd.consume();
+}
+
+static void cmd_assert_macro_population(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("assert_macro_population requires OP VALUE");
+        return;
+    }
+    auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+    int actual = mc ? mc->total_agents() : 0;
+    if (!compare_op(actual, cmd.arg(0), cmd.arg_as<int>(1)))
+        cmd.fail(fmt::format(
+            "assert_macro_population failed: {} {} {} (actual: {})", actual,
+            cmd.arg(0), cmd.arg_as<int>(1), actual));
+    else {
+        log_info("assert_macro_population PASSED: {}", actual);
+        cmd.consume();
+    }
+}
+
+// assert_crowd_total OP VALUE - individual agents plus the aggregate
+// population (conserved across macro <-> micro hand-offs)
+static void cmd_assert_crowd_total(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("assert_crowd_total requires OP VALUE");
+        return;
+    }
+    auto* mc = EntityHelper::get_singleton_cmp<MacroCrowd>();
+    int actual = (int) EntityQuery().whereHasComponent<Agent>().gen_count() +
+                 (mc ? mc->total_agents() : 0);
+    if (!compare_op(actual, cmd.arg(0), cmd.arg_as<int>(1)))
+        cmd.fail(fmt::format("assert_crowd_total failed: {} {} {} (actual: {})",
+                             actual, cmd.arg(0), cmd.arg_as<int>(1), actual));
+    else {
+        log_info("assert_crowd_total PASSED: {}", actual);
+        cmd.consume();
+    }
+}
+
+// ── Crush forecast ───────────────────────────────────────────────────────
+
+// Seconds until (x,z) goes critical; -1 when it isn't trending there
+static void cmd_assert_crush_forecast(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(4)) {
+        cmd.fail("assert_crush_forecast requires X Z OP SECONDS");
+        return;
+    }
+    auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    int x = cmd.arg_as<int>(0), z = cmd.arg_as<int>(1);
+    if (!cf || !grid || !grid->in_bounds(x, z)) {
+        cmd.fail("assert_crush_forecast: no forecast / out of bounds");
+        return;
+    }
+    float actual = cf->time_to_critical(grid->index(x, z));
+    float expected = cmd.arg_as<float>(3);
+    if (!compare_op_f(actual, cmd.arg(2), expected))
+        cmd.fail(fmt::format(
+            "assert_crush_forecast failed: ({},{}) {:.2f} {} {:.2f}", x, z,
+            actual, cmd.arg(2), expected));
+    else {
+        log_info("assert_crush_forecast PASSED: ({},{}) {:.2f}", x, z,
+                 actual);
+        cmd.consume();
+    }
+}
+
+// refresh_crush_forecast X Z - re-forecast one tile next tick, as if an
+// agent had crossed it (a crowd spawned in place never does)
+static void cmd_refresh_crush_forecast(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("refresh_crush_forecast requires X Z");
+        return;
+    }
+    auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+    auto* grid = EntityHelper::get_singleton_cmp<Grid>();
+    int x = cmd.arg_as<int>(0), z = cmd.arg_as<int>(1);
+    if (!cf || !grid || !grid->in_bounds(x, z)) {
+        cmd.fail("refresh_crush_forecast: no forecast / out of bounds");
+        return;
+    }
+    cf->mark(grid->index(x, z));
+    cmd.consume();
+}
+
+// Soonest forecast anywhere on the map; -1 when nothing is trending
+static void cmd_assert_crush_forecast_min(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("assert_crush_forecast_min requires OP SECONDS");
+        return;
+    }
+    auto* cf = EntityHelper::get_singleton_cmp<CrushForecast>();
+    float actual = CrushForecast::NONE;
+    if (cf) {
+        for (int idx : cf->tracked) {
+            float ttc = cf->time_to_critical(idx);
+            if (ttc >= 0.f && (actual < 0.f || ttc < actual)) actual = ttc;
+        }
+    }
+    float expected = cmd.arg_as<float>(1);
+    if (!compare_op_f(actual, cmd.arg(0), expected))
+        cmd.fail(fmt::format("assert_crush_forecast_min failed: {:.2f} {} "
+                             "{:.2f}",
+                             actual, cmd.arg(0), expected));
+    else {
+        log_info("assert_crush_forecast_min PASSED: {:.2f}", actual);
+        cmd.consume();
+    }
+}
+
+// ── State stream ─────────────────────────────────────────────────────────
+
+// Test-side reader: decodes whatever the memory sink has delivered
+static state_stream::Decoder& get_stream_decoder() {
+    static state_stream::Decoder d;
+    return d;
+}
+
+// stream_open [CAPACITY_BYTES] - in-process memory sink + fresh decoder
+static void cmd_stream_open(testing::PendingE2ECommand& cmd) {
+    size_t cap = cmd.has_args(1) ? cmd.arg_as<size_t>(0) : (1u << 20);
+    get_stream_decoder() = {};
+    state_stream::open("memory", cap);
+    cmd.consume();
+}
+
+// stream_subscribe PLANES EVERY [X0 Z0 X1 Z1]  (PLANES: all, density+agents)
+static void cmd_stream_subscribe(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(2)) {
+        cmd.fail("stream_subscribe requires PLANES EVERY [X0 Z0 X1 Z1]");
+        return;
+    }
+    state_stream::Subscription sub;
+    sub.planes = state_stream::parse_planes(cmd.arg(0));
+    if (sub.planes == 0) {
+        cmd.fail("stream_subscribe: unknown planes " + cmd.arg(0));
+        return;
+    }
+    sub.every = cmd.arg_as<int>(1);
+    if (cmd.has_args(6)) {
+        sub.x0 = cmd.arg_as<int>(2);
+        sub.z0 = cmd.arg_as<int>(3);
+        sub.x1 = cmd.arg_as<int>(4);
+        sub.z1 = cmd.arg_as<int>(5);
+    }
+    state_stream::subscribe(sub);
+    cmd.consume();
+}
+
+// Read everything delivered so far; fails on a malformed stream
+static void cmd_stream_drain(testing::PendingE2ECommand& cmd) {
+    std::vector<uint8_t> bytes;
+    state_stream::drain_memory(bytes);
+    if (!get_stream_decoder().feed(bytes)) {
+        cmd.fail("stream_drain: malformed stream");
+        return;
+    }
+    log_info("[E2E] stream_drain: {} bytes, {} frames total", bytes.size(),
+             get_stream_decoder().frames);
+    cmd.consume();
+}
+
+// assert_stream frames|skipped OP N
+static void cmd_assert_stream(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(3)) {
+        cmd.fail("assert_stream requires frames|skipped OP VALUE");
+        return;
+    }
+    const std::string& what = cmd.arg(0);
+    int actual = 0;
+    if (what == "frames") {
+        actual = get_stream_decoder().frames;
+    } else if (what == "skipped") {
+        actual = (int) state_stream::stats().ticks_skipped;
+    } else {
+        cmd.fail("assert_stream: unknown field " + what);
+        return;
+    }
+    if (!compare_op(actual, cmd.arg(1), cmd.arg_as<int>(2)))
+        cmd.fail(fmt::format("assert_stream failed: {} {} {} {} (actual: {})",
+                             what, actual, cmd.arg(1), cmd.arg_as<int>(2),
+                             actual));
+    else {
+        log_info("assert_stream PASSED: {} = {}", what, actual);
+        cmd.consume();
+    }
+}
+
+// Decoded planes must equal what the encoder last sent, byte for byte
+static void cmd_assert_stream_roundtrip(testing::PendingE2ECommand& cmd) {
+    const auto& d = get_stream_decoder();
+    const auto& sub = state_stream::subscription();
+    if ((sub.planes & state_stream::DENSITY) &&
+        d.density != state_stream::last_density()) {
+        cmd.fail("assert_stream_roundtrip: density plane mismatch");
+        return;
+    }
+    if ((sub.planes & state_stream::PHEROMONE) &&
+        d.pheromone != state_stream::last_pheromone()) {
+        cmd.fail("assert_stream_roundtrip: pheromone plane mismatch");
+        return;
+    }
+    log_info("assert_stream_roundtrip PASSED: {} frames", d.frames);
+    cmd.consume();
+}
+
+static void cmd_stream_close(testing::PendingE2ECommand& cmd) {
+    state_stream::close();
+    cmd.consume();
+}
+
+// ── Determinism ──────────────────────────────────────────────────────────
+
+static std::unordered_map<std::string, uint64_t>& get_remembered_hashes() {
+    static std::unordered_map<std::string, uint64_t> hashes;
+    return hashes;
+}
+
+static void cmd_set_seed(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_seed requires SEED");
+        return;
+    }
+    RandomEngine::set_seed(cmd.arg(0));
+    log_info("[E2E] set_seed: {}", cmd.arg(0));
+    cmd.consume();
+}
+
+// set_sim_threads N [MIN_CHUNK] - MIN_CHUNK forces small crowds to split
+static void cmd_set_sim_threads(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_sim_threads requires N [MIN_CHUNK]");
+        return;
+    }
+    parallel::set_worker_count(cmd.arg_as<int>(0));
+    parallel::set_min_chunk_override(cmd.has_args(2) ? cmd.arg_as<int>(1)
+                                                     : 0);
+    log_info("[E2E] set_sim_threads: {}", parallel::worker_count());
+    cmd.consume();
+}
+
+static void cmd_set_fixed_dt(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("set_fixed_dt requires SECONDS (0 = real time)");
+        return;
+    }
+    g_fixed_dt = std::max(0.f, cmd.arg_as<float>(0));
+    log_info("[E2E] set_fixed_dt: {}", g_fixed_dt);
+    cmd.consume();
+}
+
+static void cmd_remember_state_hash(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("remember_state_hash requires LABEL");
+        return;
+    }
+    uint64_t h = state_hash::compute();
+    get_remembered_hashes()[cmd.arg(0)] = h;
+    log_info("[E2E] remember_state_hash {}: {:016x}", cmd.arg(0), h);
+    cmd.consume();
+}
+
+static void cmd_assert_state_hash_matches(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("assert_state_hash_matches requires LABEL");
+        return;
+    }
+    auto& hashes = get_remembered_hashes();
+    auto it = hashes.find(cmd.arg(0));
+    if (it == hashes.end()) {
+        cmd.fail(fmt::format("assert_state_hash_matches: no hash '{}'",
+                             cmd.arg(0)));
+        return;
+    }
+    uint64_t h = state_hash::compute();
+    if (h != it->second)
+        cmd.fail(fmt::format(
+            "assert_state_hash_matches failed: {:016x} != {} ({:016x})", h,
+            cmd.arg(0), it->second));
+    else {
+        log_info("assert_state_hash_matches PASSED: {:016x}", h);
+        cmd.consume();
+    }
+}
+
+// assert_state_hash HEX - current state must hash to exactly HEX
+static void cmd_assert_state_hash(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("assert_state_hash requires HEX");
+        return;
+    }
+    uint64_t expected = std::strtoull(cmd.arg(0).c_str(), nullptr, 16);
+    auto planes = state_hash::compute_planes();
+    uint64_t h = planes.combined();
+    if (h != expected)
+        cmd.fail(fmt::format("assert_state_hash failed: {:016x} != {:016x} "
+                             "(grid {:016x}, agents {:016x} x{})",
+                             h, expected, planes.grid, planes.agents,
+                             planes.agent_count));
+    else {
+        log_info("assert_state_hash PASSED: {:016x}", h);
+        cmd.consume();
+    }
+}
+
+static void cmd_record_state_hashes(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("record_state_hashes requires EVERY_N_TICKS");
+        return;
+    }
+    get_hash_recorder().start(cmd.arg_as<int>(0));
+    log_info("[E2E] record_state_hashes every {} ticks",
+             get_hash_recorder().every);
+    cmd.consume();
+}
+
+// assert_golden_hashes NAME - stop recording and compare the sequence with
+// tests/e2e/golden/NAME.hashes. A missing file fails; --update-golden
+// (make update-golden) records it instead, once per NAME per run, so later
+// asserts of the same NAME in that run still compare.
+static void cmd_assert_golden_hashes(testing::PendingE2ECommand& cmd) {
+    if (!cmd.has_args(1)) {
+        cmd.fail("assert_golden_hashes requires NAME");
+        return;
+    }
+    auto& rec = get_hash_recorder();
+    int every = rec.every;
+    rec.stop();
+    if (rec.samples.empty()) {
+        cmd.fail("assert_golden_hashes: nothing recorded");
+        return;
+    }
+
+    std::string path = "tests/e2e/golden/" + cmd.arg(0) + ".hashes";
+    static std::set<std::string> written;
+    if (g_update_golden && written.insert(cmd.arg(0)).second) {
+        std::filesystem::create_directories("tests/e2e/golden");
+        std::ofstream out(path);
+        out << "# state hash every " << every << " ticks\n";
+        for (uint64_t h : rec.samples) out << fmt::format("{:016x}\n", h);
+        if (!out.good()) {
+            cmd.fail("assert_golden_hashes: cannot write " + path);
+            return;
+        }
+        log_info("[E2E] assert_golden_hashes: wrote {} samples to {}",
+                 rec.samples.size(), path);
+        cmd.consume();
+        return;
+    }
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        cmd.fail(fmt::format("assert_golden_hashes: {} missing (record it "
+                             "with --update-golden)",
+                             path));
+        return;
+    }
+    std::vector<uint64_t> golden;
+    for (std::string line; std::getline(in, line);) {
+        if (line.empty() || line[0] == '#') continue;
+        golden.push_back(std::strtoull(line.c_str(), nullptr, 16));
+    }
+
+    size_t n = std::min(golden.size(), rec.samples.size());
+    for (size_t i = 0; i < n; i++) {
+        if (golden[i] == rec.samples[i]) continue;
+        cmd.fail(fmt::format("assert_golden_hashes failed: {} diverges at "
+                             "sample {} (tick {}): {:016x} != {:016x}",
+                             cmd.arg(0), i, (i + 1) * every, rec.samples[i],
+                             golden[i]));
+        return;
+    }
+    if (golden.size() != rec.samples.size()) {
+        cmd.fail(fmt::format(
+            "assert_golden_hashes failed: {} has {} samples, recorded {}",
+            cmd.arg(0), golden.size(), rec.samples.size()));
+        return;
+    }
+    log_info("assert_golden_hashes PASSED: {} ({} samples)", cmd.arg(0), n);
+    cmd.consume();
+}
+
+// ── Registration ─────────────────────────────────────────────────────────
+
+static void init_e2e_registry() {
+    auto& r = get_registry();
+    if (!r.handlers.empty()) return;
+    r.add("spawn_agent", cmd_spawn_agent);
+    r.add("spawn_agents", cmd_spawn_agents);
+    r.add("clear_agents", cmd_clear_agents);
+    r.add("clear_map", cmd_clear_map);
+    r.add("reset_game", cmd_reset_game);
+    r.add("place_facility", cmd_place_facility);
+    r.add("set_tile", cmd_set_tile);
+    r.add("get_agent_count", cmd_get_agent_count);
+    r.add("get_density", cmd_get_density);
+    r.add("assert_agent_count", cmd_assert_agent_count);
+    r.add("assert_density", cmd_assert_density);
+    r.add("assert_agent_spread", cmd_assert_agent_spread);
+    r.add("assert_tile_type", cmd_assert_tile_type);
+    r.add("draw_path_rect", cmd_draw_path_rect);
+    r.add("move_to_grid", cmd_move_to_grid);
+    r.add("click_grid", cmd_click_grid);
+    r.add("assert_agent_near", cmd_assert_agent_near);
+    r.add("set_spawn_rate", cmd_set_spawn_rate);
+    r.add("set_spawn_enabled", cmd_set_spawn_enabled);
+    r.add("force_need", cmd_force_need);
+    r.add("assert_agents_at_facility", cmd_assert_agents_at_facility);
+    r.add("assert_agent_watching", cmd_assert_agent_watching);
+    r.add("assert_agents_on_tiletype", cmd_assert_agents_on_tiletype);
+    r.add("place_gate", cmd_place_gate);
+    r.add("assert_gate_count", cmd_assert_gate_count);
+    r.add("assert_blocked", cmd_assert_blocked);
+    r.add("toggle_debug", cmd_toggle_debug);
+    r.add("trigger_game_over", cmd_trigger_game_over);
+    r.add("assert_game_status", cmd_assert_game_status);
+    r.add("toggle_overlay", cmd_toggle_overlay);
+    r.add("assert_overlay", cmd_assert_overlay);
+    r.add("set_agent_speed", cmd_set_agent_speed);
+    r.add("set_move_speed", cmd_set_move_speed);
+    r.add("get_death_count", cmd_get_death_count);
+    r.add("set_death_count", cmd_set_death_count);
+    r.add("assert_death_count", cmd_assert_death_count);
+    r.add("assert_agent_hp", cmd_assert_agent_hp);
+    r.add("set_time", cmd_set_time);
+    r.add("set_speed", cmd_set_speed);
+    r.add("assert_phase", cmd_assert_phase);
+    r.add("assert_time_between", cmd_assert_time_between);
+    r.add("assert_stage_state", cmd_assert_stage_state);
+    r.add("force_artist", cmd_force_artist);
+    r.add("assert_agents_exited", cmd_assert_agents_exited);
+    r.add("assert_carryover_count", cmd_assert_carryover_count);
+    r.add("set_pheromone", cmd_set_pheromone);
+    r.add("assert_pheromone", cmd_assert_pheromone);
+    r.add("clear_pheromones", cmd_clear_pheromones);
+    r.add("set_max_attendees", cmd_set_max_attendees);
+    r.add("assert_max_attendees", cmd_assert_max_attendees);
+    r.add("assert_slots", cmd_assert_slots);
+    r.add("select_tool", cmd_select_tool);
+    r.add("assert_tool", cmd_assert_tool);
+    r.add("place_building", cmd_place_building);
+    r.add("demolish_at", cmd_demolish_at);
+    r.add("set_all_agent_hp", cmd_set_all_agent_hp);
+    r.add("perf_start", cmd_perf_start);
+    r.add("perf_report", cmd_perf_report);
+    r.add("assert_fps", cmd_assert_fps);
+    r.add("assert_min_fps", cmd_assert_min_fps);
+    r.add("assert_system_time", cmd_assert_system_time);
+    r.add("assert_logic_time", cmd_assert_logic_time);
+    r.add("assert_render_time", cmd_assert_render_time);
+    r.add("assert_nux_active", cmd_assert_nux_active);
+    r.add("assert_nux_inactive", cmd_assert_nux_inactive);
+    r.add("assert_nux_count", cmd_assert_nux_count);
+    r.add("dismiss_nux", cmd_dismiss_nux);
+    r.add("assert_pixel", cmd_assert_pixel);
+    r.add("assert_region_not_blank", cmd_assert_region_not_blank);
+    r.add("set_zoom", cmd_set_zoom);
+    r.add("trigger_event", cmd_trigger_event);
+    r.add("assert_event_active", cmd_assert_event_active);
+    r.add("assert_event_inactive", cmd_assert_event_inactive);
+    r.add("assert_day_number", cmd_assert_day_number);
+    r.add("set_day_number", cmd_set_day_number);
+    r.add("assert_spawn_rate", cmd_assert_spawn_rate);
+    r.add("assert_toast_contains", cmd_assert_toast_contains);
+    r.add("assert_no_toast", cmd_assert_no_toast);
+    r.add("save_game", cmd_save_game);
+    r.add("load_game", cmd_load_game);
+    r.add("assert_save_exists", cmd_assert_save_exists);
+    r.add("assert_save_rejects_section", cmd_assert_save_rejects_section);
+    r.add("delete_save", cmd_delete_save);
+    r.add("set_autosave", cmd_set_autosave);
+    r.add("autosave_now", cmd_autosave_now);
+    r.add("autosave_flush", cmd_autosave_flush);
+    r.add("assert_autosave", cmd_assert_autosave);
+    r.add("load_autosave", cmd_load_autosave);
+    r.add("discard_autosaves", cmd_discard_autosaves);
+    r.add("player_build", cmd_player_build);
+    r.add("replay_record", cmd_replay_record);
+    r.add("replay_stop", cmd_replay_stop);
+    r.add("replay_seek", cmd_replay_seek);
+    r.add("replay_save", cmd_replay_save);
+    r.add("replay_load", cmd_replay_load);
+    r.add("assert_replay_rejects", cmd_assert_replay_rejects);
+    r.add("assert_replay", cmd_assert_replay);
+    r.add("set_density_history", cmd_set_density_history);
+    r.add("density_history_sample", cmd_density_history_sample);
+    r.add("assert_density_history", cmd_assert_density_history);
+    r.add("assert_density_window", cmd_assert_density_window);
+    r.add("assert_far_heatmap", cmd_assert_far_heatmap);
+    r.add("assert_density_version", cmd_assert_density_version);
+    r.add("assert_agent_index", cmd_assert_agent_index);
+    r.add("reset_text_cache_stats", cmd_reset_text_cache_stats);
+    r.add("assert_text_cache", cmd_assert_text_cache);
+    r.add("assert_render_queue", cmd_assert_render_queue);
+    r.add("set_frame_pacing", cmd_set_frame_pacing);
+    r.add("render_frames", cmd_render_frames);
+    r.add("assert_frame_pacing", cmd_assert_frame_pacing);
+    r.add("bench_audio_startup", cmd_bench_audio_startup);
+    r.add("log_flood", cmd_log_flood);
+    r.add("log_flush", cmd_log_flush);
+    r.add("assert_log", cmd_assert_log);
+    r.add("reset_counters", cmd_reset_counters);
+    r.add("assert_counter", cmd_assert_counter);
+    r.add("set_hybrid_sim", cmd_set_hybrid_sim);
+    r.add("assert_macro_population", cmd_assert_macro_population);
+    r.add("assert_crowd_total", cmd_assert_crowd_total);
+    r.add("assert_crush_forecast", cmd_assert_crush_forecast);
+    r.add("assert_crush_forecast_min", cmd_assert_crush_forecast_min);
+    r.add("refresh_crush_forecast", cmd_refresh_crush_forecast);
+    r.add("stream_open", cmd_stream_open);
+    r.add("stream_subscribe", cmd_stream_subscribe);
+    r.add("stream_drain", cmd_stream_drain);
+    r.add("assert_stream", cmd_assert_stream);
+    r.add("assert_stream_roundtrip", cmd_assert_stream_roundtrip);
+    r.add("stream_close", cmd_stream_close);
+    r.add("set_seed", cmd_set_seed);
+    r.add("set_sim_threads", cmd_set_sim_threads);
+    r.add("set_fixed_dt", cmd_set_fixed_dt);
+    r.add("remember_state_hash", cmd_remember_state_hash);
+    r.add("assert_state_hash_matches", cmd_assert_state_hash_matches);
+    r.add("assert_state_hash", cmd_assert_state_hash);
+    r.add("record_state_hashes", cmd_record_state_hashes);
+    r.add("assert_golden_hashes", cmd_assert_golden_hashes);
+}
+
+bool e2e_command_pending() {
+    auto cmds = EntityQuery()
+                    .whereHasComponent<testing::PendingE2ECommand>()
+                    .gen();
+    for (Entity& e : cmds) {
+        const auto& cmd = e.get<testing::PendingE2ECommand>();
+        if (!cmd.is_consumed() && !cmd.name.starts_with("wait")) return true;
+    }
+    return false;
 }
 
 void register_e2e_systems(SystemManager& sm) {
     testing::register_builtin_handlers(sm);
     init_e2e_registry();
-    sm.register_update_system(std::make_unique<E2EDispatchSystem>());
+    sm.register_update_system(timed<E2EDispatchSystem>());
     testing::register_unknown_handler(sm);
     testing::register_cleanup(sm);
 }
@@ -0,0 +1,293 @@
+// Parallel e2e runner: spawns one headless child per script, enforces
+// per-script timeouts and aggregates results into a JUnit XML report.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "parallel_runner.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+extern char** environ;
+
+namespace e2e_parallel {
+
+namespace {
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+enum class Outcome { Pass, Fail, Error };
+
+struct Job {
+    std::string name;
+    fs::path script;
+    fs::path dir;  // work_dir/<name>
+    pid_t pid = -1;
+    Clock::time_point started;
+    float seconds = 0.f;
+    bool timed_out = false;
+    int status = 0;
+    Outcome outcome = Outcome::Error;
+    std::string message;  // first failure line, or why it errored
+};
+
+fs::path log_path(const Job& job) { return job.dir / "output.log"; }
+// Written by the child only once its script has run to the end
+fs::path result_path(const Job& job) { return job.dir / "result"; }
+
+bool spawn(Job& job, const Options& opt) {
+    fs::remove_all(job.dir);
+    fs::create_directories(job.dir / "saves");
+
+    std::vector<std::string> args = {
+        opt.exe,        "--test-mode",
+        "--test-script", job.script.string(),
+        "--headless",   "--fast",
+        "--save-dir",   (job.dir / "saves").string(),
+        "--result-file", result_path(job).string(),
+    };
+    args.insert(args.end(), opt.child_args.begin(), opt.child_args.end());
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(a.data());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    std::string log = log_path(job).string();
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(),
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+    int err = posix_spawn(&job.pid, opt.exe.c_str(), &actions, nullptr,
+                          argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0) {
+        job.message = fmt::format("spawn failed: {}", std::strerror(err));
+        return false;
+    }
+    job.started = Clock::now();
+    return true;
+}
+
+// Classify from the child's exit status and result file (a pass needs
+// both); the log only supplies the message
+void finish(Job& job) {
+    job.seconds =
+        std::chrono::duration<float>(Clock::now() - job.started).count();
+    if (job.timed_out) {
+        job.outcome = Outcome::Error;
+        job.message = "timed out";
+        return;
+    }
+    if (WIFSIGNALED(job.status)) {
+        job.outcome = Outcome::Error;
+        job.message = fmt::format("crashed (signal {})", WTERMSIG(job.status));
+        return;
+    }
+    int code = WIFEXITED(job.status) ? WEXITSTATUS(job.status) : -1;
+    std::string result;
+    std::ifstream(result_path(job)) >> result;
+    if (code == 0 && result == "PASS") {
+        job.outcome = Outcome::Pass;
+        return;
+    }
+    if (code == 0) {
+        // Quit before the end of the script (window closed, escape)
+        job.outcome = Outcome::Error;
+        job.message = "exited before the end of the script";
+        return;
+    }
+    job.outcome = Outcome::Fail;
+    job.message = fmt::format("exit code {}", code);
+    std::ifstream in(log_path(job));
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("[FAIL]") != std::string::npos) {
+            job.message = line;
+            break;
+        }
+    }
+}
+
+std::string xml_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '&':
+                out += "&amp;";
+                break;
+            case '<':
+                out += "&lt;";
+                break;
+            case '>':
+                out += "&gt;";
+                break;
+            case '"':
+                out += "&quot;";
+                break;
+            default:
+                // Control bytes (color codes) are not valid XML 1.0
+                if ((unsigned char) c >= 0x20 || c == '\n' || c == '\t')
+                    out += c;
+        }
+    }
+    return out;
+}
+
+// Last `n` lines of the child's log, for the report body
+std::string log_tail(const Job& job, int n) {
+    std::ifstream in(log_path(job));
+    std::deque<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+        if ((int) lines.size() > n) lines.pop_front();
+    }
+    std::string out;
+    for (auto& l : lines) out += l + "\n";
+    return out;
+}
+
+bool write_junit(const std::string& path, const std::vector<Job>& jobs,
+                 float wall_seconds) {
+    int failures = 0, errors = 0;
+    for (auto& j : jobs) {
+        if (j.outcome == Outcome::Fail) failures++;
+        if (j.outcome == Outcome::Error) errors++;
+    }
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml << fmt::format(
+        "<testsuites tests=\"{}\" failures=\"{}\" errors=\"{}\" "
+        "time=\"{:.3f}\">\n",
+        jobs.size(), failures, errors, wall_seconds);
+    xml << fmt::format(
+        "  <testsuite name=\"e2e\" tests=\"{}\" failures=\"{}\" "
+        "errors=\"{}\" time=\"{:.3f}\">\n",
+        jobs.size(), failures, errors, wall_seconds);
+    for (auto& j : jobs) {
+        xml << fmt::format(
+            "    <testcase classname=\"e2e\" name=\"{}\" time=\"{:.3f}\"",
+            xml_escape(j.name), j.seconds);
+        if (j.outcome == Outcome::Pass) {
+            xml << "/>\n";
+            continue;
+        }
+        const char* tag = j.outcome == Outcome::Fail ? "failure" : "error";
+        xml << fmt::format(">\n      <{} message=\"{}\">{}</{}>\n", tag,
+                           xml_escape(j.message), xml_escape(log_tail(j, 40)),
+                           tag);
+        xml << "    </testcase>\n";
+    }
+    xml << "  </testsuite>\n</testsuites>\n";
+
+    fs::path p(path);
+    if (p.has_parent_path()) fs::create_directories(p.parent_path());
+    std::ofstream out(path);
+    return (bool) (out << xml.str());
+}
+
+}  // namespace
+
+int run(const Options& opt) {
+    std::vector<Job> jobs;
+    for (auto& entry : fs::directory_iterator(opt.test_dir)) {
+        if (entry.path().extension() != ".e2e") continue;
+        Job job;
+        job.name = entry.path().stem().string();
+        job.script = entry.path();
+        job.dir = fs::path(opt.work_dir) / job.name;
+        jobs.push_back(job);
+    }
+    std::sort(jobs.begin(), jobs.end(),
+              [](const Job& a, const Job& b) { return a.name < b.name; });
+    if (jobs.empty()) {
+        log_warn("[E2E] no .e2e scripts in {}", opt.test_dir);
+        return 1;
+    }
+
+    int jobs_n = std::max(1, opt.jobs);
+    log_info("[E2E] running {} scripts, {} at a time", jobs.size(), jobs_n);
+    auto wall_start = Clock::now();
+    size_t next = 0;
+    int running = 0;
+    while (next < jobs.size() || running > 0) {
+        while (running < jobs_n && next < jobs.size()) {
+            Job& job = jobs[next++];
+            if (spawn(job, opt)) {
+                running++;
+            } else {
+                job.outcome = Outcome::Error;
+            }
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            for (auto& job : jobs) {
+                if (job.pid != pid) continue;
+                job.status = status;
+                job.pid = -1;
+                finish(job);
+                running--;
+                log_info("[E2E] {} {} ({:.1f}s){}",
+                         job.outcome == Outcome::Pass   ? "[PASS]"
+                         : job.outcome == Outcome::Fail ? "[FAIL]"
+                                                        : "[ERROR]",
+                         job.name, job.seconds,
+                         job.message.empty() ? "" : ": " + job.message);
+                break;
+            }
+            continue;
+        }
+
+        // Nothing finished: enforce timeouts, then sleep briefly
+        auto now = Clock::now();
+        for (auto& job : jobs) {
+            if (job.pid <= 0 || job.timed_out) continue;
+            float elapsed =
+                std::chrono::duration<float>(now - job.started).count();
+            if (elapsed > opt.timeout) {
+                job.timed_out = true;
+                kill(job.pid, SIGKILL);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    float wall = std::chrono::duration<float>(Clock::now() - wall_start)
+                     .count();
+
+    int passed = 0, failed = 0, errored = 0;
+    for (auto& j : jobs) {
+        if (j.outcome == Outcome::Pass) passed++;
+        if (j.outcome == Outcome::Fail) failed++;
+        if (j.outcome == Outcome::Error) errored++;
+    }
+    log_info("[E2E] Summary: {} passed, {} failed, {} errors in {:.1f}s "
+             "(logs in {})",
+             passed, failed, errored, wall, opt.work_dir);
+    if (!opt.junit_path.empty()) {
+        if (write_junit(opt.junit_path, jobs, wall)) {
+            log_info("[E2E] JUnit report: {}", opt.junit_path);
+        } else {
+            log_warn("[E2E] could not write {}", opt.junit_path);
+        }
+    }
+    log_flush();
+    return (failed + errored) == 0 ? 0 : 1;
+}
+
+}  // namespace e2e_parallel
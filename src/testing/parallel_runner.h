@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Parallel e2e runner (--jobs N with --test-dir).
+//
+// Each script runs in its own headless child process of this executable
+// with its own save directory, simulated-time stepping (--fast) and a log
+// file under work_dir/<script>/. Up to `jobs` children run at once; a
+// child is killed after `timeout` wall-clock seconds. Pass/fail is the
+// child's exit status (non-zero when a script fails); a pass also needs
+// the result file the child writes at the end of its script, so a child
+// that quits early, crashes or times out counts as an error. Results go
+// to stdout and, optionally, a JUnit XML report.
+namespace e2e_parallel {
+
+struct Options {
+    std::string exe;       // path of this executable (argv[0])
+    std::string test_dir;  // directory of *.e2e scripts
+    int jobs = 1;
+    float timeout = 120.f;  // seconds per script
+    std::string work_dir = "output/e2e";
+    std::string junit_path;  // empty: no report
+    // Appended to every child (main forwards --threads, --fixed-dt and
+    // --sync-log)
+    std::vector<std::string> child_args;
+};
+
+// Returns the process exit code: 0 when every script passed
+int run(const Options& opt);
+
+}  // namespace e2e_parallel
@@ -0,0 +1,194 @@
+// Text cache domain: per-(string, size) extents and glyph quads for the
+// UI pass, with age-based pruning.
+#define AFTER_HOURS_REPLACE_LOGGING
+#include "log.h"
+
+#include "text_cache.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace text_cache {
+
+namespace {
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+using Map = std::unordered_map<std::string, Layout, StringHash,
+                               std::equal_to<>>;
+
+struct Cache {
+    // UI text comes in a handful of sizes; one map per size keeps lookups
+    // keyed on the string alone
+    std::vector<std::pair<float, Map>> by_size;
+    fmt::memory_buffer scratch;
+    uint64_t clock = 0;  // lookups so far
+    size_t entries = 0;
+    Stats stats;
+};
+
+Cache& cache() {
+    static Cache c;
+    return c;
+}
+
+Map& map_for(float size) {
+    auto& c = cache();
+    for (auto& [s, m] : c.by_size) {
+        if (s == size) return m;
+    }
+    c.by_size.push_back({size, Map{}});
+    return c.by_size.back().second;
+}
+
+// Drop everything not looked up in the last PRUNE_AGE lookups
+void prune() {
+    auto& c = cache();
+    for (auto& [s, m] : c.by_size) {
+        std::erase_if(m, [&](const auto& kv) {
+            return kv.second.last_used + PRUNE_AGE < c.clock;
+        });
+    }
+    c.entries = 0;
+    for (auto& [s, m] : c.by_size) c.entries += m.size();
+}
+
+#ifdef AFTER_HOURS_USE_RAYLIB
+// Same glyph placement as raylib's DrawTextEx / DrawTextCodepoint
+void build_quads(Layout& layout) {
+    const raylib::Font& font = get_font();
+    if (font.baseSize <= 0 || !font.glyphs) return;
+    float scale = layout.size / (float) font.baseSize;
+    float pad = (float) font.glyphPadding;
+    float ox = 0.f, oy = 0.f;
+    const char* p = layout.text.c_str();
+    const char* end = p + layout.text.size();
+    while (p < end) {
+        int bytes = 0;
+        int cp = raylib::GetCodepointNext(p, &bytes);
+        p += std::max(bytes, 1);
+        if (cp == '\n') {
+            oy += (font.baseSize + font.baseSize / 2) * scale;
+            ox = 0.f;
+            continue;
+        }
+        int gi = raylib::GetGlyphIndex(font, cp);
+        const auto& rec = font.recs[gi];
+        const auto& glyph = font.glyphs[gi];
+        if (cp != ' ' && cp != '\t') {
+            Layout::Quad q;
+            q.src = {rec.x - pad, rec.y - pad, rec.width + 2.f * pad,
+                     rec.height + 2.f * pad};
+            q.dst = {ox + glyph.offsetX * scale - pad * scale,
+                     oy + glyph.offsetY * scale - pad * scale,
+                     q.src.width * scale, q.src.height * scale};
+            layout.quads.push_back(q);
+        }
+        float advance = glyph.advanceX == 0 ? rec.width * scale
+                                            : glyph.advanceX * scale;
+        ox += advance + FONT_SPACING;
+    }
+}
+
+void emit_quads(const Layout& layout, float x, float y, Color c) {
+    const raylib::Font& font = get_font();
+    float tw = (float) font.texture.width;
+    float th = (float) font.texture.height;
+    raylib::rlColor4ub(c.r, c.g, c.b, c.a);
+    for (const auto& q : layout.quads) {
+        float u0 = q.src.x / tw, u1 = (q.src.x + q.src.width) / tw;
+        float v0 = q.src.y / th, v1 = (q.src.y + q.src.height) / th;
+        float x0 = x + q.dst.x, x1 = x0 + q.dst.width;
+        float y0 = y + q.dst.y, y1 = y0 + q.dst.height;
+        raylib::rlTexCoord2f(u0, v0);
+        raylib::rlVertex2f(x0, y0);
+        raylib::rlTexCoord2f(u0, v1);
+        raylib::rlVertex2f(x0, y1);
+        raylib::rlTexCoord2f(u1, v1);
+        raylib::rlVertex2f(x1, y1);
+        raylib::rlTexCoord2f(u1, v0);
+        raylib::rlVertex2f(x1, y0);
+    }
+}
+
+void begin_batch(const Layout& layout, int passes) {
+    raylib::rlCheckRenderBatchLimit((int) layout.quads.size() * 4 * passes);
+    raylib::rlSetTexture(get_font().texture.id);
+    raylib::rlBegin(RL_QUADS);
+    raylib::rlNormal3f(0.f, 0.f, 1.f);
+}
+
+void end_batch() {
+    raylib::rlEnd();
+    raylib::rlSetTexture(0);
+}
+#endif
+
+}  // namespace
+
+fmt::memory_buffer& scratch() { return cache().scratch; }
+
+const Layout& get(std::string_view text, float size) {
+    auto& c = cache();
+    c.clock++;
+    Map& m = map_for(size);
+    auto it = m.find(text);
+    if (it != m.end()) {
+        c.stats.hits++;
+        it->second.last_used = c.clock;
+        return it->second;
+    }
+
+    c.stats.misses++;
+    if (c.entries >= MAX_ENTRIES) prune();
+    Layout layout;
+    layout.text = std::string(text);
+    layout.size = size;
+    layout.extent = measure_text_ex(get_font(), layout.text.c_str(), size,
+                                    FONT_SPACING);
+    layout.last_used = c.clock;
+#ifdef AFTER_HOURS_USE_RAYLIB
+    build_quads(layout);
+#endif
+    c.entries++;
+    return m.emplace(layout.text, std::move(layout)).first->second;
+}
+
+void draw(const Layout& layout, float x, float y, Color color) {
+#ifdef AFTER_HOURS_USE_RAYLIB
+    begin_batch(layout, 1);
+    emit_quads(layout, x, y, color);
+    end_batch();
+#else
+    draw_text_ex(get_font(), layout.text.c_str(), {x, y}, layout.size,
+                 FONT_SPACING, color);
+#endif
+}
+
+void draw_shadowed(const Layout& layout, float x, float y, Color color,
+                   float dx, float dy, Color shadow) {
+#ifdef AFTER_HOURS_USE_RAYLIB
+    begin_batch(layout, 2);
+    emit_quads(layout, x + dx, y + dy, shadow);
+    emit_quads(layout, x, y, color);
+    end_batch();
+#else
+    draw(layout, x + dx, y + dy, shadow);
+    draw(layout, x, y, color);
+#endif
+}
+
+Stats stats() {
+    Stats s = cache().stats;
+    s.entries = cache().entries;
+    return s;
+}
+
+void reset_stats() { cache().stats = Stats{}; }
+
+}  // namespace text_cache
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "render_helpers.h"
+
+// Measured, pre-laid-out UI text keyed by (string, font size).
+//
+// A miss measures the string once and, on raylib, resolves every glyph to
+// its atlas rect and screen offset; a hit draws those quads straight into
+// the batch (one rlBegin per call, shadow included) with no measuring,
+// UTF-8 decoding or allocation. Entries not looked up for PRUNE_AGE
+// lookups are dropped once the cache outgrows MAX_ENTRIES, so churning
+// text (clock minutes, event timers) cannot grow it without bound.
+namespace text_cache {
+
+constexpr size_t MAX_ENTRIES = 512;
+constexpr uint64_t PRUNE_AGE = 4096;
+
+struct Layout {
+    std::string text;
+    float size = 0.f;
+    vec2 extent{};  // measure_text_ex of text at size
+    uint64_t last_used = 0;
+#ifdef AFTER_HOURS_USE_RAYLIB
+    struct Quad {
+        Rectangle src;  // atlas texels
+        Rectangle dst;  // relative to the draw origin
+    };
+    std::vector<Quad> quads;
+#endif
+};
+
+// Layout for (text, size); built on first use
+const Layout& get(std::string_view text, float size);
+
+// fmt::format into a reused buffer, then get(). The buffer is shared, so
+// use the returned layout's text rather than holding on to the arguments.
+template<typename... Args>
+const Layout& format(float size, fmt::format_string<Args...> f,
+                     Args&&... args);
+
+void draw(const Layout& layout, float x, float y, Color color);
+
+// Drop shadow at (+dx, +dy) in `shadow`, then the text, in one batch
+void draw_shadowed(const Layout& layout, float x, float y, Color color,
+                   float dx, float dy, Color shadow);
+
+struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
+};
+[[nodiscard]] Stats stats();
+void reset_stats();
+
+// ── Implementation details ──
+
+fmt::memory_buffer& scratch();
+
+template<typename... Args>
+const Layout& format(float size, fmt::format_string<Args...> f,
+                     Args&&... args) {
+    auto& buf = scratch();
+    buf.clear();
+    fmt::format_to(fmt::appender(buf), f, std::forward<Args>(args)...);
+    return get(std::string_view(buf.data(), buf.size()), size);
+}
+
+}  // namespace text_cache
@@ -34,6 +34,7 @@ inline bool skip_game_logic() { return game_is_over() || game_is_paused(); }
 
 inline void spawn_toast(const std::string& text, float lifetime = 3.0f) {
     Entity& te = EntityHelper::createEntity();
+    telemetry::bump(telemetry::EntitiesCreated);
     te.addComponent<ToastMessage>();
     auto& toast = te.get<ToastMessage>();
     toast.text = text;
@@ -5,10 +5,13 @@
 #include "afterhours/src/core/entity_helper.h"
 #include "afterhours/src/core/entity_query.h"
 #include "audio.h"
+#include "autosave.h"
 #include "components.h"
 #include "entity_makers.h"
+#include "replay.h"
 #include "save_system.h"
 #include "systems.h"
+#include "telemetry.h"
 #include "update_helpers.h"
 
 // Domain registration functions (defined in separate .cpp files)
@@ -21,10 +24,16 @@ void register_building_systems(SystemManager& sm);
 void register_agent_goal_systems(SystemManager& sm);
 void register_agent_movement_systems(SystemManager& sm);
 void register_crowd_flow_systems(SystemManager& sm);
+void register_macro_crowd_systems(SystemManager& sm);
 void register_crowd_damage_systems(SystemManager& sm);
 void register_crowd_particle_systems(SystemManager& sm);
 void register_polish_systems(SystemManager& sm);
 
+// Replay bookkeeping; must run before anything touches sim state
+struct ReplayTickSystem : System<> {
+    void once(float dt) override { replay::begin_tick(dt); }
+};
+
 struct CameraInputSystem : System<ProvidesCamera> {
     void for_each_with(Entity&, ProvidesCamera& cam, float dt) override {
         cam.cam.handle_input(dt);
@@ -41,12 +50,14 @@ struct UpdateGameClockSystem : System<> {
         if (!clock) return;
 
         bool pause_down = action_down(InputAction::TogglePause);
-        if (!game_is_over()) {
+        if (!game_is_over() && !replay::is_playing()) {
             if (pause_down && !was_pause_down) {
                 if (clock->speed == GameSpeed::Paused)
                     clock->speed = GameSpeed::OneX;
                 else
                     clock->speed = GameSpeed::Paused;
+                replay::record({.kind = replay::ActionKind::SetSpeed,
+                                .value = (uint8_t) clock->speed});
                 log_info("Game speed: {}",
                          clock->speed == GameSpeed::Paused ? "PAUSED" : "1x");
             }
@@ -126,6 +137,7 @@ struct CheckGameOverSystem : System<> {
             get_audio().stop_music();
             save::update_meta_on_game_over();
             save::delete_save();
+            autosave::discard();
             log_info("GAME OVER: {} deaths reached", gs->death_count);
         }
     }
@@ -151,18 +163,27 @@ struct SaveLoadSystem : System<> {
         if (action_pressed(InputAction::QuickSave)) {
             if (save::save_game()) {
                 spawn_toast("Game saved!", 2.0f);
-                log_info("Game saved to {}", save::SAVE_FILE);
+                log_info("Game saved to {}", save::save_file());
             }
         }
         if (action_pressed(InputAction::QuickLoad)) {
             if (save::load_game()) {
+                replay::stop();  // the recording no longer matches
                 spawn_toast("Game loaded!", 2.0f);
-                log_info("Game loaded from {}", save::SAVE_FILE);
+                log_info("Game loaded from {}", save::save_file());
             }
         }
     }
 };
 
+// Periodic background autosave (sim time, so pausing holds the timer)
+struct AutosaveSystem : System<> {
+    void once(float dt) override {
+        if (skip_game_logic()) return;
+        autosave::tick(dt);
+    }
+};
+
 // Update audio: drive beat music based on stage performance state
 struct UpdateAudioSystem : System<> {
     void once(float) override {
@@ -173,10 +194,23 @@ struct UpdateAudioSystem : System<> {
     }
 };
 
+// Fold this tick's hot-path counters into the telemetry history. Runs
+// last so it sees everything the tick did; seeks fold into the next frame.
+struct TelemetryTickSystem : System<> {
+    void once(float) override {
+        if (replay::is_seeking()) return;
+        telemetry::end_tick();
+    }
+};
+
 void register_update_systems(SystemManager& sm) {
+    sm.register_update_system(std::make_unique<system_timing::SectionMark>(
+        system_timing::LOGIC, true));
+
     // Core setup
-    sm.register_update_system(std::make_unique<CameraInputSystem>());
-    sm.register_update_system(std::make_unique<UpdateGameClockSystem>());
+    sm.register_update_system(timed<ReplayTickSystem>());
+    sm.register_update_system(timed<CameraInputSystem>());
+    sm.register_update_system(timed<UpdateGameClockSystem>());
 
     // Events: apply effect flags before agent logic reads them
     register_event_effect_systems(sm);
@@ -188,7 +222,7 @@ void register_update_systems(SystemManager& sm) {
     register_building_systems(sm);
 
     // Core UI toggles
-    sm.register_update_system(std::make_unique<ToggleDataLayerSystem>());
+    sm.register_update_system(timed<ToggleDataLayerSystem>());
 
     // Agent goals: set targets before movement
     register_agent_goal_systems(sm);
@@ -199,6 +233,9 @@ void register_update_systems(SystemManager& sm) {
     // Crowd flow: exodus, pheromone, density counting
     register_crowd_flow_systems(sm);
 
+    // Hybrid sim: continuum step for aggregated (off-screen) tiles
+    register_macro_crowd_systems(sm);
+
     // Agent movement: pathfinding and state transitions
     register_agent_movement_systems(sm);
 
@@ -206,9 +243,9 @@ void register_update_systems(SystemManager& sm) {
     register_crowd_damage_systems(sm);
 
     // Core late
-    sm.register_update_system(std::make_unique<UpdateToastsSystem>());
-    sm.register_update_system(std::make_unique<CheckGameOverSystem>());
-    sm.register_update_system(std::make_unique<RestartGameSystem>());
+    sm.register_update_system(timed<UpdateToastsSystem>());
+    sm.register_update_system(timed<CheckGameOverSystem>());
+    sm.register_update_system(timed<RestartGameSystem>());
 
     // Crowd particles
     register_crowd_particle_systems(sm);
@@ -223,6 +260,11 @@ void register_update_systems(SystemManager& sm) {
     register_polish_systems(sm);
 
     // Core final
-    sm.register_update_system(std::make_unique<SaveLoadSystem>());
-    sm.register_update_system(std::make_unique<UpdateAudioSystem>());
+    sm.register_update_system(timed<SaveLoadSystem>());
+    sm.register_update_system(timed<AutosaveSystem>());
+    sm.register_update_system(timed<UpdateAudioSystem>());
+    sm.register_update_system(timed<TelemetryTickSystem>());
+
+    sm.register_update_system(std::make_unique<system_timing::SectionMark>(
+        system_timing::LOGIC, false));
 }